@@ -31,9 +31,21 @@
 #include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/ilist.h>
 #include <llvm/ADT/ilist_node.h>
+#include <llvm/Support/MathExtras.h>
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 namespace tsar {
+/// Storage of a Bimap which keeps each pair in a separately allocated node,
+/// iterators remain valid until the element is removed.
+struct BimapListStorage {};
+
+/// Storage of a Bimap which keeps pairs in a contiguous vector indexed by two
+/// open addressing hash tables, iterators are invalidated by insertion and
+/// erasure.
+struct BimapFlatStorage {};
+
 namespace detail {
 /// \brief Provides llvm::DenseMapInfo to implement search in a Bimap.
 ///
@@ -92,6 +104,9 @@ struct BimapInfoBase {
 /// hash for the first key.
 /// \tparam SecondInfoTy Implementation of traits which is necessary to build
 /// hash for the second key.
+/// \tparam StorageTy Layout of the container (BimapListStorage or
+/// BimapFlatStorage). This comment describes the default list storage,
+/// see specialization for BimapFlatStorage for details about the flat one.
 ///
 /// Invalidation of iterators, pointers and references referring to elements may
 /// occur only when element is removed from the container. But only entities
@@ -125,10 +140,11 @@ struct BimapInfoBase {
 /// Predefined tags Bimap<...>::First and Bimap<...>::Second are also available.
 template<class FTy, class STy,
   class FirstInfoTy = llvm::DenseMapInfo<bcl::add_alias_tagged_t<FTy, FTy>>,
-  class SecondInfoTy = llvm::DenseMapInfo<bcl::add_alias_tagged_t<STy, STy>>>
+  class SecondInfoTy = llvm::DenseMapInfo<bcl::add_alias_tagged_t<STy, STy>>,
+  class StorageTy = BimapListStorage>
 class Bimap {
   /// Type of this bidirectional map.
-  typedef Bimap<FTy, STy, FirstInfoTy, SecondInfoTy> Self;
+  typedef Bimap<FTy, STy, FirstInfoTy, SecondInfoTy, StorageTy> Self;
 
 public:
   /// This tag can be used to access first key in a pair.
@@ -559,6 +575,421 @@ private:
   FirstToSecondMap mFirstToSecond;
   SecondToFirstMap mSecondToFirst;
 };
+
+/// \brief Bidirectional associative container with flat layout.
+///
+/// Pairs are stored in a contiguous vector in order of insertion. Two open
+/// addressing hash tables map the first and the second key to a position of
+/// a pair in the vector. So, lookup does not access separately allocated
+/// nodes and the container is cheap to build and to copy.
+///
+/// In contrast to the default list storage, insertion of an element may
+/// invalidate all iterators, pointers and references. Erasure moves the last
+/// element to the place of the removed one, so it invalidates iterators,
+/// pointers and references to the removed and the last elements and it does
+/// not preserve order of elements. Use this storage for containers which are
+/// built once and then queried a lot.
+template<class FTy, class STy, class FirstInfoTy, class SecondInfoTy>
+class Bimap<FTy, STy, FirstInfoTy, SecondInfoTy, BimapFlatStorage> {
+  /// Type of this bidirectional map.
+  typedef Bimap<FTy, STy, FirstInfoTy, SecondInfoTy, BimapFlatStorage> Self;
+
+public:
+  /// This tag can be used to access first key in a pair.
+  struct First {};
+
+  /// This tag can be used to access second key in a pair.
+  struct Second {};
+
+private:
+  typedef bcl::TypeList<
+    bcl::add_alias_tagged<FTy, First>,
+    bcl::add_alias_tagged<STy, Second>> Taggeds;
+  typedef bcl::get_tagged_t<First, Taggeds> FirstTy;
+  typedef bcl::get_tagged_t<Second, Taggeds> SecondTy;
+public:
+  typedef bcl::tagged_pair<
+    bcl::get_tagged<First, Taggeds>,
+    bcl::get_tagged<Second, Taggeds>> value_type;
+  typedef value_type & reference;
+  typedef const value_type & const_reference;
+  typedef value_type * pointer;
+  typedef const value_type * const_pointer;
+
+private:
+  /// This is a main collection that contains all pairs of elements in the map.
+  typedef std::vector<value_type> Collection;
+
+  /// Position of a pair in the main collection.
+  typedef unsigned IndexTy;
+
+  /// Hash table which maps a key to a position of a pair.
+  typedef std::vector<IndexTy> IndexTable;
+
+  enum : IndexTy {
+    EmptyIdx = ~0u,
+    TombstoneIdx = ~0u - 1
+  };
+
+  enum : std::size_t { MinTableSize = 16 };
+
+public:
+  typedef typename Collection::size_type size_type;
+  typedef typename Collection::const_iterator iterator;
+  typedef iterator const_iterator;
+  typedef typename Collection::const_reverse_iterator reverse_iterator;
+  typedef reverse_iterator const_reverse_iterator;
+
+  /// Default constructor.
+  Bimap() = default;
+
+  /// Copy constructor.
+  Bimap(const Bimap &BM) = default;
+
+  /// Move constructor.
+  Bimap(Bimap &&BM) { swap(BM); }
+
+  /// Constructs the container with the contents of the range [I, EI).
+  template<class Itr> Bimap(Itr I, Itr EI) {
+    insert(I, EI);
+  }
+
+  /// Constructs the container with the contents of the initializer list.
+  Bimap(std::initializer_list<value_type> List) {
+    insert(List);
+  }
+
+  /// Copy assignment operator. Replaces the contents with a copy of the
+  /// contents of other
+  Bimap & operator=(const Bimap &BM) = default;
+
+  /// Move assignment operator. Replaces the contents with those of other using
+  /// move semantics
+  Bimap & operator=(Bimap &&BM) {
+    if (this == &BM)
+      return *this;
+    clear();
+    swap(BM);
+    return *this;
+  }
+
+  /// Replaces the contents with those identified by initializer list.
+  Bimap & operator=(std::initializer_list<value_type> List) {
+    clear();
+    insert(List);
+    return *this;
+  }
+
+  /// \brief Returns an iterator to the first element of the container.
+  ///
+  /// If the container is empty, the returned iterator will be equal to end().
+  iterator begin() const { return mColl.begin(); }
+
+  /// \brief Returns an iterator to the element following the last element of
+  /// the container.
+  iterator end() const { return mColl.end(); }
+
+  /// Returns an iterator to the first element of the container.
+  iterator cbegin() const { return begin(); }
+
+  /// Returns an iterator to the element following the last element of
+  /// the container.
+  iterator cend() const { return end(); }
+
+  /// Returns a reverse iterator to the first element of the reversed
+  /// container.
+  reverse_iterator rbegin() const { return mColl.rbegin(); }
+
+  /// Returns a reverse iterator to the element following the last
+  /// element of the reversed container.
+  reverse_iterator rend() const { return mColl.rend(); }
+
+  /// Returns a reverse iterator to the first element of the reversed
+  /// container.
+  reverse_iterator crbegin() const { return rbegin(); }
+
+  /// Returns a reverse iterator to the element following the last
+  /// element of the reversed container.
+  reverse_iterator crend() const { return rend(); }
+
+  /// Returns true if the container has no elements.
+  bool empty() const { return mColl.empty(); }
+
+  /// Returns the number of elements in the container.
+  size_type size() const { return mColl.size(); }
+
+  /// Removes all elements from the container.
+  void clear() {
+    mColl.clear();
+    mFirstToSecond.clear();
+    mSecondToFirst.clear();
+    mNumTombstones = 0;
+  }
+
+  /// Exchanges the contents of the container with those of other.
+  void swap(Self &Other) {
+    mColl.swap(Other.mColl);
+    mFirstToSecond.swap(Other.mFirstToSecond);
+    mSecondToFirst.swap(Other.mSecondToFirst);
+    std::swap(mNumTombstones, Other.mNumTombstones);
+  }
+
+  /// Grows the container to hold at least a specified number of elements
+  /// without rehashing.
+  void reserve(size_type NumEntries) {
+    mColl.reserve(NumEntries);
+    if (NumEntries * 4 >= mFirstToSecond.size() * 3)
+      rehash(std::max<std::size_t>(MinTableSize,
+                                   llvm::PowerOf2Ceil(NumEntries * 2)));
+  }
+
+  /// \brief Inserts element into the container, if the container doesn't
+  /// already contain an element with an equivalent key.
+  ///
+  /// \return Returns a pair consisting of an iterator to the inserted element
+  /// (or to the element that prevented the insertion) and a bool denoting
+  /// whether the insertion took place.
+  template<typename Pair,
+    typename = typename std::enable_if<
+      std::is_constructible<value_type, Pair&&>::value>::type>
+  std::pair<iterator, bool> insert(Pair&& Val) {
+    return insertValue(value_type(std::forward<Pair>(Val)));
+  }
+
+  /// Inserts copies of the elements in the initializer list to the container.
+  void insert(std::initializer_list<value_type> List) {
+    for (auto &Val : List)
+      insert(Val);
+  }
+
+  /// Inserts elements from range [I, EI).
+  template<class Itr>  void insert(Itr I, Itr EI) {
+    for ( ; I != EI; ++I)
+      insert(*I);
+  }
+
+  /// Inserts a new element into the container by constructing it with
+  /// the given Args if there is no element with the key in the container.
+  template<typename... ArgTy>
+  std::pair<iterator, bool> emplace(ArgTy&&... Args) {
+    return insertValue(value_type(std::forward<ArgTy>(Args)...));
+  }
+
+  /// Finds an element with first key equivalent to First.
+  iterator find_first(const FirstTy &First) const {
+    auto *Slot = findSlot<FirstInfoTy>(mFirstToSecond, First, getFirst);
+    return Slot ? begin() + *Slot : end();
+  }
+
+  /// Finds an element with second key equivalent to Second.
+  iterator find_second(const SecondTy &Second) const {
+    auto *Slot = findSlot<SecondInfoTy>(mSecondToFirst, Second, getSecond);
+    return Slot ? begin() + *Slot : end();
+  }
+
+  /// Finds an element with a key Tag equivalent to Key.
+  template<class Tag,
+    class = typename std::enable_if<
+      !std::is_void<bcl::get_tagged<Tag, Taggeds>>::value>::type>
+  iterator find(const bcl::get_tagged_t<Tag, Taggeds> &Key) const {
+    return taggedFindImp(
+      Key, std::is_same<
+        bcl::get_tagged<First, Taggeds>, bcl::get_tagged<Tag, Taggeds>>());
+  }
+
+  /// \brief Removes specified element from the container.
+  ///
+  /// \return Iterator which refers to the position of the removed element.
+  /// After erasure this position contains the element which was the last one.
+  iterator erase(iterator I) {
+    assert(I != end() && "Iterator must refer element in the container!");
+    IndexTy Idx = I - begin();
+    eraseIndex(Idx);
+    return begin() + Idx;
+  }
+
+  /// \brief Removes the elements in the range [I; EI), which must be
+  /// a valid range in *this.
+  ///
+  /// \return Iterator which refers to the position of the first removed
+  /// element.
+  iterator erase(iterator I, iterator EI) {
+    IndexTy FirstIdx = I - begin();
+    // Remove elements in reverse order, so elements from the range are not
+    // moved before their erasure.
+    for (IndexTy Idx = EI - begin(); Idx > FirstIdx; --Idx)
+      eraseIndex(Idx - 1);
+    return begin() + FirstIdx;
+  }
+
+  /// \brief Removes the element (if one exists) with the first key equivalent
+  /// to First.
+  ///
+  /// \return True if the element has been found and removed.
+  bool erase_first(const FirstTy &First) {
+    auto *Slot = findSlot<FirstInfoTy>(mFirstToSecond, First, getFirst);
+    if (!Slot)
+      return false;
+    eraseIndex(*Slot);
+    return true;
+  }
+
+  /// \brief Removes the element (if one exists) with the second key equivalent
+  /// to Second.
+  ///
+  /// \return True if the element has been found and removed.
+  bool erase_second(const SecondTy &Second) {
+    auto *Slot = findSlot<SecondInfoTy>(mSecondToFirst, Second, getSecond);
+    if (!Slot)
+      return false;
+    eraseIndex(*Slot);
+    return true;
+  }
+
+  /// \brief Removes the element (if one exists) with the key Tag equivalent to
+  /// Key.
+  ///
+  /// \return True if the element has been found and removed.
+  template<class Tag,
+    class = typename std::enable_if<
+      !std::is_void<bcl::get_tagged<Tag, Taggeds>>::value>::type>
+  bool erase(const bcl::get_tagged_t<Tag, Taggeds> &Key) {
+    return taggedEraseImp(
+      Key, std::is_same<
+        bcl::get_tagged<First, Taggeds>, bcl::get_tagged<Tag, Taggeds>>());
+  }
+
+private:
+  static const FirstTy & getFirst(const value_type &Val) { return Val.first; }
+  static const SecondTy & getSecond(const value_type &Val) {
+    return Val.second;
+  }
+
+  /// Returns a slot in a hash table which contains position of a pair with
+  /// a specified key or nullptr if there is no such pair.
+  template<class KeyInfoTy, class KeyTy, class GetKeyT>
+  const IndexTy * findSlot(const IndexTable &Table, const KeyTy &Key,
+      GetKeyT GetKey) const {
+    if (Table.empty())
+      return nullptr;
+    std::size_t Mask = Table.size() - 1;
+    std::size_t Probe = KeyInfoTy::getHashValue(Key) & Mask;
+    for (std::size_t ProbeAmt = 1; ; ++ProbeAmt) {
+      auto Idx = Table[Probe];
+      if (Idx == EmptyIdx)
+        return nullptr;
+      if (Idx != TombstoneIdx && KeyInfoTy::isEqual(Key, GetKey(mColl[Idx])))
+        return &Table[Probe];
+      Probe = (Probe + ProbeAmt) & Mask;
+    }
+  }
+
+  /// Returns a slot in a hash table which contains a specified position.
+  static IndexTy & findSlotOf(IndexTable &Table, unsigned Hash, IndexTy Idx) {
+    std::size_t Mask = Table.size() - 1;
+    std::size_t Probe = Hash & Mask;
+    for (std::size_t ProbeAmt = 1; Table[Probe] != Idx; ++ProbeAmt) {
+      assert(Table[Probe] != EmptyIdx && "Position must be in the table!");
+      Probe = (Probe + ProbeAmt) & Mask;
+    }
+    return Table[Probe];
+  }
+
+  /// Stores a specified position in the first empty slot.
+  static void insertSlot(IndexTable &Table, unsigned Hash, IndexTy Idx) {
+    std::size_t Mask = Table.size() - 1;
+    std::size_t Probe = Hash & Mask;
+    for (std::size_t ProbeAmt = 1; Table[Probe] != EmptyIdx; ++ProbeAmt)
+      Probe = (Probe + ProbeAmt) & Mask;
+    Table[Probe] = Idx;
+  }
+
+  /// Rebuilds hash tables with a specified number of slots.
+  void rehash(std::size_t NumSlots) {
+    assert(llvm::isPowerOf2_64(NumSlots) &&
+      "Number of slots must be a power of 2!");
+    mFirstToSecond.assign(NumSlots, EmptyIdx);
+    mSecondToFirst.assign(NumSlots, EmptyIdx);
+    mNumTombstones = 0;
+    for (IndexTy Idx = 0, EIdx = mColl.size(); Idx < EIdx; ++Idx) {
+      insertSlot(mFirstToSecond,
+        FirstInfoTy::getHashValue(mColl[Idx].first), Idx);
+      insertSlot(mSecondToFirst,
+        SecondInfoTy::getHashValue(mColl[Idx].second), Idx);
+    }
+  }
+
+  /// Rehashes tables if there is no room for a new element.
+  void grow() {
+    auto NumEntries = mColl.size() + 1;
+    if ((NumEntries + mNumTombstones) * 4 < mFirstToSecond.size() * 3)
+      return;
+    rehash(std::max<std::size_t>(MinTableSize,
+                                 llvm::PowerOf2Ceil(NumEntries * 2)));
+  }
+
+  /// Inserts a specified value if there is no element with the same keys.
+  std::pair<iterator, bool> insertValue(value_type &&Val) {
+    auto I = find_first(Val.first);
+    if (I != end())
+      return std::make_pair(I, false);
+    I = find_second(Val.second);
+    if (I != end())
+      return std::make_pair(I, false);
+    assert(mColl.size() < TombstoneIdx && "Too many elements in the map!");
+    grow();
+    IndexTy Idx = mColl.size();
+    insertSlot(mFirstToSecond, FirstInfoTy::getHashValue(Val.first), Idx);
+    insertSlot(mSecondToFirst, SecondInfoTy::getHashValue(Val.second), Idx);
+    mColl.push_back(std::move(Val));
+    return std::make_pair(begin() + Idx, true);
+  }
+
+  /// Removes an element at a specified position and moves the last element
+  /// to this position.
+  void eraseIndex(IndexTy Idx) {
+    assert(Idx < mColl.size() && "Index is out of range!");
+    findSlotOf(mFirstToSecond,
+      FirstInfoTy::getHashValue(mColl[Idx].first), Idx) = TombstoneIdx;
+    findSlotOf(mSecondToFirst,
+      SecondInfoTy::getHashValue(mColl[Idx].second), Idx) = TombstoneIdx;
+    ++mNumTombstones;
+    IndexTy LastIdx = mColl.size() - 1;
+    if (Idx != LastIdx) {
+      findSlotOf(mFirstToSecond,
+        FirstInfoTy::getHashValue(mColl[LastIdx].first), LastIdx) = Idx;
+      findSlotOf(mSecondToFirst,
+        SecondInfoTy::getHashValue(mColl[LastIdx].second), LastIdx) = Idx;
+      mColl[Idx] = std::move(mColl[LastIdx]);
+    }
+    mColl.pop_back();
+  }
+
+  /// Overloaded method. Finds an element with first key equivalent to key.
+  iterator taggedFindImp(const FirstTy &Key, std::true_type) const {
+    return find_first(Key);
+  }
+
+  /// Overloaded method. Finds an element with second key equivalent to key.
+  iterator taggedFindImp(const SecondTy &Key, std::false_type) const {
+    return find_second(Key);
+  }
+
+  /// Overloaded method. Removes an element with the specified first key.
+  bool taggedEraseImp(const FirstTy &Key, std::true_type) {
+    return erase_first(Key);
+  }
+
+  /// Overloaded method. Removes an element with the specified second key.
+  bool taggedEraseImp(const SecondTy &Key, std::false_type) {
+    return erase_second(Key);
+  }
+
+  Collection mColl;
+  IndexTable mFirstToSecond;
+  IndexTable mSecondToFirst;
+  std::size_t mNumTombstones = 0;
+};
 }
 
 
@@ -566,18 +997,22 @@ private:
 
 namespace std {
 /// Specializes the std::swap algorithm for tsar::Bimap.
-template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy,
+         class StorageTy>
 inline void swap(
-    tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
-    tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+    tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy, StorageTy> &LHS,
+    tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy, StorageTy> &RHS) {
   LHS.swap(RHS);
 }
 
 /// Compares the contents of two bidirectional maps.
-template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy,
+         class StorageTy>
 bool operator==(
-    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
-    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy,
+                      StorageTy> &LHS,
+    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy,
+                      StorageTy> &RHS) {
   if (&LHS == &RHS)
     return true;
   auto LHSItr = LHS.begin(), LHSEndItr = LHS.end();
@@ -591,10 +1026,13 @@ bool operator==(
 }
 
 /// Compares the contents of two bidirectional maps.
-template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy,
+         class StorageTy>
 bool operator!=(
-    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
-    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy,
+                      StorageTy> &LHS,
+    const tsar::Bimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy,
+                      StorageTy> &RHS) {
   return !operator==(LHS, RHS);
 }
 }
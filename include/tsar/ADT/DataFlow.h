@@ -33,6 +33,8 @@
 //  * DataFlowTraits - It must be specialized to determine data-flow framework.
 //  * RegionDFTraits - It must be specialized to determine data-flow framework
 //                     for a hierarchy of regions.
+//  * IndexedGraphTraits - It may be specialized to traverse a data-flow graph
+//                         using dense indexes of nodes.
 //  * solveDataFlow...() - It should be used to solve data-flow problem.
 //  * SmallDFNode - It can be inherited to represent nodes of a data-flow graph.
 //
@@ -46,6 +48,7 @@
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/PostOrderIterator.h>
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <type_traits>
 #include <vector>
@@ -120,6 +123,167 @@ template <class GraphType> struct Backward {
   inline Backward(const GraphType &G) : Graph(G) {}
 };
 
+/// \brief Compact representation of a data-flow graph.
+///
+/// This class may be specialized by a type of a data-flow graph
+/// (see DataFlowTraits::GraphType) to allow solvers to traverse the graph
+/// using dense indexes of nodes instead of llvm::GraphTraits, so it is not
+/// necessary to follow pointers to adjacent nodes and to hash nodes.
+/// The default version is empty which is why llvm::GraphTraits are used.
+/// The following elements should be provided:
+/// - typedef NodeRef - Type of a node (the same as in llvm::GraphTraits).
+/// - static bool isIndexed(GraphType) -
+///     Returns true if indexes are available for the specified graph,
+///     otherwise llvm::GraphTraits are used.
+/// - static unsigned size(GraphType) -
+///     Returns number of nodes in the graph including the entry node,
+///     nodes are identified by indexes in range [0, size()).
+/// - static unsigned getEntryIndex(GraphType) -
+///     Returns index of the entry node.
+/// - static NodeRef getNode(GraphType, unsigned) -
+///     Returns a node with a specified index.
+/// - static void forEachChild(GraphType, unsigned, FuncT &&) -
+///     Calls a function for index of each child of a node with a specified
+///     index (children are the same as llvm::GraphTraits<GraphType> children).
+/// - static void forEachInverseChild(GraphType, unsigned, FuncT &&) -
+///     Calls a function for index of each child of a node with a specified
+///     index in the inverse graph (llvm::GraphTraits<Inverse<GraphType>>).
+/// Nodes are visited by solvers in order of their indexes, so this order
+/// should be the same as the order of llvm::GraphTraits::nodes_begin() to
+/// obtain identical results.
+template<class GraphType> struct IndexedGraphTraits {};
+
+namespace detail {
+/// Determines whether IndexedGraphTraits are specialized by a graph type.
+template<class GraphType, class = void>
+struct HasIndexedGraph : public std::false_type {};
+
+template<class GraphType>
+struct HasIndexedGraph<GraphType, std::void_t<decltype(
+    IndexedGraphTraits<GraphType>::isIndexed(std::declval<GraphType>()))>> :
+  public std::true_type {};
+
+/// Returns true if a specified indexed graph is acyclic (see isDAG()).
+template<class GraphType> bool isIndexedDAG(GraphType G) {
+  typedef IndexedGraphTraits<GraphType> IGT;
+  enum : char { White, Gray, Black };
+  std::vector<char> Colors(IGT::size(G), White);
+  std::vector<std::pair<unsigned, llvm::SmallVector<unsigned, 4>>> Stack;
+  auto push = [&G, &Colors, &Stack](unsigned Idx) {
+    Colors[Idx] = Gray;
+    Stack.emplace_back(Idx, llvm::SmallVector<unsigned, 4>());
+    IGT::forEachChild(G, Idx,
+      [&Stack](unsigned C) { Stack.back().second.push_back(C); });
+    std::reverse(Stack.back().second.begin(), Stack.back().second.end());
+  };
+  push(IGT::getEntryIndex(G));
+  while (!Stack.empty()) {
+    auto &Children = Stack.back().second;
+    if (Children.empty()) {
+      Colors[Stack.back().first] = Black;
+      Stack.pop_back();
+      continue;
+    }
+    auto C = Children.pop_back_val();
+    if (Colors[C] == Gray)
+      return false;
+    if (Colors[C] == White)
+      push(C);
+  }
+  return true;
+}
+
+/// Iteratively solves data-flow problem for an indexed graph
+/// (see solveDataFlowIteratively()).
+template<class DFFwk> void solveIndexedDataFlowIteratively(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typedef DataFlowTraits<DFFwk> DFT;
+  typedef typename DFT::ValueType ValueType;
+  typedef IndexedGraphTraits<typename DFT::GraphType> IGT;
+  auto Size = IGT::size(DFG);
+  auto EntryIdx = IGT::getEntryIndex(DFG);
+  for (unsigned Idx = 0; Idx < Size; ++Idx)
+    if (Idx != EntryIdx) {
+      DFT::initialize(IGT::getNode(DFG, Idx), DFF, DFG);
+      DFT::setValue(DFT::topElement(DFF, DFG), IGT::getNode(DFG, Idx), DFF);
+    }
+  DFT::initialize(IGT::getNode(DFG, EntryIdx), DFF, DFG);
+  DFT::setValue(DFT::boundaryCondition(DFF, DFG), IGT::getNode(DFG, EntryIdx),
+    DFF);
+  bool isChanged = true;
+  do {
+    isChanged = false;
+    for (unsigned Idx = 0; Idx < Size; ++Idx) {
+      if (Idx == EntryIdx)
+        continue;
+      ValueType Value(DFT::topElement(DFF, DFG));
+      bool HasChildren = false;
+      IGT::forEachChild(DFG, Idx, [&](unsigned C) {
+        HasChildren = true;
+        DFT::meetOperator(DFT::getValue(IGT::getNode(DFG, C), DFF), Value,
+          DFF, DFG);
+      });
+      (void)HasChildren;
+      assert(HasChildren &&
+        "Data-flow graph must not contain unreachable nodes!");
+      isChanged = DFT::transferFunction(
+        std::move(Value), IGT::getNode(DFG, Idx), DFF, DFG) || isChanged;
+    }
+  } while (isChanged);
+}
+
+/// Solves data-flow problem for an indexed graph in topological order
+/// (see solveDataFlowTopologicaly()).
+template<class DFFwk> void solveIndexedDataFlowTopologicaly(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typedef DataFlowTraits<DFFwk> DFT;
+  typedef typename DFT::ValueType ValueType;
+  typedef IndexedGraphTraits<typename DFT::GraphType> IGT;
+  auto EntryIdx = IGT::getEntryIndex(DFG);
+  // Compute post-order traversal of the inverse graph.
+  std::vector<unsigned> PO;
+  PO.reserve(IGT::size(DFG));
+  std::vector<bool> Visited(IGT::size(DFG));
+  std::vector<std::pair<unsigned, llvm::SmallVector<unsigned, 4>>> Stack;
+  auto push = [&DFG, &Visited, &Stack](unsigned Idx) {
+    Visited[Idx] = true;
+    Stack.emplace_back(Idx, llvm::SmallVector<unsigned, 4>());
+    IGT::forEachInverseChild(DFG, Idx,
+      [&Stack](unsigned C) { Stack.back().second.push_back(C); });
+    std::reverse(Stack.back().second.begin(), Stack.back().second.end());
+  };
+  push(EntryIdx);
+  while (!Stack.empty()) {
+    auto &Children = Stack.back().second;
+    if (Children.empty()) {
+      PO.push_back(Stack.back().first);
+      Stack.pop_back();
+      continue;
+    }
+    auto C = Children.pop_back_val();
+    if (!Visited[C])
+      push(C);
+  }
+  assert(PO.back() == EntryIdx &&
+    "The first node in the topological order differs from the entry node in the data-flow framework!");
+  for (auto I = PO.rbegin() + 1, E = PO.rend(); I != E; ++I) {
+    DFT::initialize(IGT::getNode(DFG, *I), DFF, DFG);
+    DFT::setValue(DFT::topElement(DFF, DFG), IGT::getNode(DFG, *I), DFF);
+  }
+  DFT::initialize(IGT::getNode(DFG, EntryIdx), DFF, DFG);
+  DFT::setValue(DFT::boundaryCondition(DFF, DFG), IGT::getNode(DFG, EntryIdx),
+    DFF);
+  for (auto I = PO.rbegin() + 1, E = PO.rend(); I != E; ++I) {
+    ValueType Value(DFT::topElement(DFF, DFG));
+    IGT::forEachChild(DFG, *I, [&](unsigned C) {
+      DFT::meetOperator(DFT::getValue(IGT::getNode(DFG, C), DFF), Value,
+        DFF, DFG);
+    });
+    DFT::transferFunction(std::move(Value), IGT::getNode(DFG, *I), DFF, DFG);
+  }
+}
+}
+
 /// \brief Iteratively solves data-flow problem.
 ///
 /// This computes IN and OUT for each node in the specified data-flow graph
@@ -136,11 +300,18 @@ template <class GraphType> struct Backward {
 /// The GraphTraits class should be specialized by
 /// DataFlowTraits<DFFwk>::GraphType.
 /// \pre The graph must not contain unreachable nodes.
+/// \note If IndexedGraphTraits are specialized by the graph type and indexes
+/// are available, the graph is traversed using indexes.
 template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
     typename DataFlowTraits<DFFwk>::GraphType DFG) {
   typedef DataFlowTraits<DFFwk> DFT;
   typedef typename DFT::ValueType ValueType;
   typedef typename DFT::GraphType GraphType;
+  if constexpr (detail::HasIndexedGraph<GraphType>::value)
+    if (IndexedGraphTraits<GraphType>::isIndexed(DFG)) {
+      detail::solveIndexedDataFlowIteratively(DFF, DFG);
+      return;
+    }
   typedef llvm::GraphTraits<GraphType> GT;
   typedef typename GT::nodes_iterator nodes_iterator;
   typedef typename GT::ChildIteratorType ChildIteratorType;
@@ -188,11 +359,18 @@ template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
 /// The GraphTraits class should be specialized by
 /// DataFlowTraits<DFFwk>::GraphType.
 /// \pre The graph must not contain unreachable nodes.
+/// \note If IndexedGraphTraits are specialized by the graph type and indexes
+/// are available, the graph is traversed using indexes.
 template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
     typename DataFlowTraits<DFFwk>::GraphType DFG) {
   typedef DataFlowTraits<DFFwk> DFT;
   typedef typename DFT::ValueType ValueType;
   typedef typename DFT::GraphType GraphType;
+  if constexpr (detail::HasIndexedGraph<GraphType>::value)
+    if (IndexedGraphTraits<GraphType>::isIndexed(DFG)) {
+      detail::solveIndexedDataFlowTopologicaly(DFF, DFG);
+      return;
+    }
   typedef llvm::GraphTraits<GraphType> GT;
   typedef typename GT::nodes_iterator nodes_iterator;
   typedef typename GT::ChildIteratorType ChildIteratorType;
@@ -234,6 +412,27 @@ template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
   }
 }
 
+/// \brief Solves data-flow problem for a specified graph.
+///
+/// If the graph is acyclic the problem is solved in topological order in
+/// a single pass, otherwise iteratively (see solveDataFlowTopologicaly() and
+/// solveDataFlowIteratively()).
+/// \pre The graph must not contain unreachable nodes.
+template<class DFFwk> void solveDataFlow(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typedef typename DataFlowTraits<DFFwk>::GraphType GraphType;
+  bool IsDAG;
+  if constexpr (detail::HasIndexedGraph<GraphType>::value)
+    IsDAG = IndexedGraphTraits<GraphType>::isIndexed(DFG) ?
+      detail::isIndexedDAG(DFG) : isDAG(DFG);
+  else
+    IsDAG = isDAG(DFG);
+  if (IsDAG)
+    solveDataFlowTopologicaly(DFF, DFG);
+  else
+    solveDataFlowIteratively(DFF, DFG);
+}
+
 /// \brief Data-flow framework for a hierarchy of regions.
 ///
 /// This class should be specialized by different region types
@@ -252,6 +451,18 @@ template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
 ///   static region_iterator region_begin(GraphType &G),
 ///   static region_iterator region_end (GraphType &G) -
 ///     Allow iteration over all internal regions in the specified region.
+/// The following elements are optional:
+/// - static TaskPoolT *getTaskPool(DFFwk &) -
+///     Returns a pool of tasks which is used to solve data-flow problems for
+///     sibling regions concurrently or nullptr to use sequential solver.
+///     The TaskPoolT::async(F) method should enqueue a task F and return
+///     a handle with a wait() method (for example, llvm::ThreadPool).
+///     A framework which provides a pool guarantees that expand(), collapse()
+///     and all methods from DataFlowTraits are thread-safe if they are called
+///     for nodes of disjoint regions. Values of a region are accessed only
+///     after all its inner regions have been processed (in upward direction)
+///     or before any of them is processed (in downward direction), so
+///     results are identical to the results of the sequential solver.
 /// \note It may be convenient to inherit DataFlowTraits to specialize this
 /// class.
 /// \note Whether regions at different levels of hierarchy have the same type
@@ -268,6 +479,70 @@ template<class DFFwk > struct RegionDFTraits {
   typedef typename DFFwk::UnknownFrameworkError GraphType;
 };
 
+namespace detail {
+/// Determines whether RegionDFTraits provide a pool of tasks.
+template<class DFFwk, class = void>
+struct HasRegionTaskPool : public std::false_type {};
+
+template<class DFFwk>
+struct HasRegionTaskPool<DFFwk, std::void_t<decltype(
+    RegionDFTraits<DFFwk>::getTaskPool(std::declval<DFFwk &>()))>> :
+  public std::true_type {};
+
+/// \brief Solves data-flow problem for all inner regions of a specified region.
+///
+/// If `IsConcurrent` is true, RegionDFTraits provide a pool of tasks and
+/// there are multiple inner regions, each region is solved in a separate task.
+/// Hierarchy of regions inside a task is processed sequentially.
+/// This function returns after all inner regions have been processed.
+template<class DFFwk, class SolverT>
+void solveInnerRegions(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, bool IsConcurrent,
+    SolverT Solver) {
+  typedef RegionDFTraits<DFFwk> RT;
+  auto I = RT::region_begin(DFG), E = RT::region_end(DFG);
+  if constexpr (HasRegionTaskPool<DFFwk>::value) {
+    auto *Pool = IsConcurrent ? RT::getTaskPool(DFF) : nullptr;
+    if (Pool && I != E && std::next(I) != E) {
+      using TaskT = decltype(Pool->async(std::function<void()>()));
+      std::vector<TaskT> Tasks;
+      for (; I != E; ++I) {
+        auto Inner = *I;
+        Tasks.push_back(Pool->async(std::function<void()>(
+          [DFF, Inner, Solver]() { Solver(DFF, Inner, false); })));
+      }
+      for (auto &T : Tasks)
+        T.wait();
+      return;
+    }
+  }
+  for (; I != E; ++I)
+    Solver(DFF, *I, IsConcurrent);
+}
+
+/// Solves data-flow problem upward (see solveDataFlowUpward()).
+template<class DFFwk> void solveDataFlowUpwardImpl(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, bool IsConcurrent) {
+  typedef RegionDFTraits<DFFwk> RT;
+  RT::expand(DFF, DFG);
+  solveInnerRegions(DFF, DFG, IsConcurrent,
+    &solveDataFlowUpwardImpl<DFFwk>);
+  solveDataFlow(DFF, DFG);
+  RT::collapse(DFF, DFG);
+}
+
+/// Solves data-flow problem downward (see solveDataFlowDownward()).
+template<class DFFwk> void solveDataFlowDownwardImpl(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, bool IsConcurrent) {
+  typedef RegionDFTraits<DFFwk> RT;
+  RT::expand(DFF, DFG);
+  solveDataFlow(DFF, DFG);
+  solveInnerRegions(DFF, DFG, IsConcurrent,
+    &solveDataFlowDownwardImpl<DFFwk>);
+  RT::collapse(DFF, DFG);
+}
+}
+
 /// \brief Solves data-flow problem for the specified hierarchy of regions.
 ///
 /// The data-flow problems solves upward from innermost regions to the region
@@ -287,20 +562,12 @@ template<class DFFwk > struct RegionDFTraits {
 /// The llvm::GraphTraits class should be specialized by type of each
 /// regions in the hierarchy (not only for DataFlowTraits<DFFwk>::GraphType).
 /// Note that type of region is generally a pointer type.
+/// If RegionDFTraits provide a pool of tasks, sibling regions are solved
+/// concurrently.
 /// \pre The graph must not contain unreachable nodes.
 template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
     typename DataFlowTraits<DFFwk>::GraphType DFG) {
-  typedef RegionDFTraits<DFFwk> RT;
-  typedef typename RT::region_iterator region_iterator;
-  RT::expand(DFF, DFG);
-  for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
-       I != E; ++I)
-    solveDataFlowUpward(DFF, *I);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
-  RT::collapse(DFF, DFG);
+  detail::solveDataFlowUpwardImpl(DFF, DFG, true);
 }
 
 /// \brief Solves data-flow problem for the specified hierarchy of regions.
@@ -324,20 +591,12 @@ template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
 /// The llvm::GraphTraits class should be specialized by type of each
 /// regions in the hierarchy (not only for DataFlowTraits<DFFwk>::GraphType).
 /// Note that type of region is generally a pointer type.
+/// If RegionDFTraits provide a pool of tasks, sibling regions are solved
+/// concurrently.
 /// \pre The graph must not contain unreachable nodes.
 template<class DFFwk> void solveDataFlowDownward(DFFwk DFF,
   typename DataFlowTraits<DFFwk>::GraphType DFG) {
-  typedef RegionDFTraits<DFFwk> RT;
-  typedef typename RT::region_iterator region_iterator;
-  RT::expand(DFF, DFG);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
-  for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
-       I != E; ++I)
-    solveDataFlowDownward(DFF, *I);
-  RT::collapse(DFF, DFG);
+  detail::solveDataFlowDownwardImpl(DFF, DFG, true);
 }
 
 namespace detail{
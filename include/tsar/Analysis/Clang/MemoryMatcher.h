@@ -47,9 +47,13 @@ namespace tsar {
 ///
 /// Note that matcher contains canonical declarations (Decl::getCanonicalDecl).
 struct MemoryMatchInfo : private bcl::Uncopyable {
+  /// The matcher is built once for a module and then it is queried a lot,
+  /// so flat storage is used.
   typedef tsar::Bimap<
     bcl::tagged<clang::VarDecl*, tsar::AST>,
-    bcl::tagged<llvm::Value *, tsar::IR>> MemoryMatcher;
+    bcl::tagged<llvm::Value *, tsar::IR>,
+    llvm::DenseMapInfo<clang::VarDecl *>, llvm::DenseMapInfo<llvm::Value *>,
+    tsar::BimapFlatStorage> MemoryMatcher;
 
   typedef std::set<clang::VarDecl *> MemoryASTSet;
 
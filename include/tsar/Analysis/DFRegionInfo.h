@@ -55,6 +55,13 @@ public:
   /// Returns the smallest region that surrounds a specified loop.
   tsar::DFNode * getRegionFor(llvm::Loop *L) const;
 
+  /// \brief Returns number of nodes in the hierarchy.
+  ///
+  /// All nodes are numbered in range [0, getNumNodes()), so this value can be
+  /// used to allocate storage for values indexed by numbers of nodes
+  /// (see tsar::DFNodeMap).
+  unsigned getNumNodes() const noexcept { return mNumNodes; }
+
   /// Releases memory.
   void releaseMemory() {
     if (mTopLevelRegion) {
@@ -62,6 +69,7 @@ public:
       mTopLevelRegion = nullptr;
     }
     mBBToNode.clear();
+    mNumNodes = 0;
   }
 
   /// \brief Treats all loops in a function as regions and build the region
@@ -94,8 +102,16 @@ private:
   template<class LoopReptn>
   void buildLoopRegion(LoopReptn L, tsar::DFRegion *R);
 
+  /// \brief Numbers nodes of a specified region and of all inner regions and
+  /// builds compact views of these regions (see tsar::DFGraphView).
+  ///
+  /// Nodes of a region obtain consecutive numbers, then inner regions
+  /// are processed.
+  void numberRegion(tsar::DFRegion *R);
+
   tsar::DFNode *mTopLevelRegion = nullptr;
   BBToNodeMap mBBToNode;
+  unsigned mNumNodes = 0;
 };
 }
 
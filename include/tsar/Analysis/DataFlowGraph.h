@@ -26,6 +26,8 @@
 //
 // There are following main elements in this file:
 // * Classes which is used to represent nodes and regions in a data-flow graph.
+// * Compact view of a region which uses dense numbering of nodes.
+// * Map from nodes to values which is indexed by numbers of nodes.
 // * Functions, to build hierarchy of regions.
 //
 //===--------------------------------------------------------------------===//
@@ -36,11 +38,14 @@
 #include "tsar/ADT/DataFlow.h"
 #include "tsar/ADT/GraphUtils.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/IR/CFG.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/ErrorHandling.h>
 #include <llvm/Analysis/LoopInfo.h>
+#include <algorithm>
 #include <vector>
 
 namespace llvm {
@@ -100,6 +105,14 @@ public:
   /// Returns a parent node.
   const DFNode * getParent() const { return mParent; }
 
+  /// \brief Returns number of the node.
+  ///
+  /// Nodes are numbered by DFRegionInfo, numbers are dense and unique for all
+  /// nodes in a hierarchy of regions. Nodes of each region have consecutive
+  /// numbers. If the node has not been numbered yet, the method returns
+  /// InvalidId.
+  unsigned getId() const noexcept { return mId; }
+
   /// \brief Adds a new attribute to the node.
   ///
   /// \tparam Attribute which has been declared using macros
@@ -146,10 +159,16 @@ protected:
   /// Creates a new node of the specified type.
   explicit DFNode(Kind K) : mKind(K), mParent(nullptr) {}
 
+public:
+  /// Number of a node which has not been numbered yet.
+  static constexpr unsigned InvalidId = ~0u;
+
 private:
   friend class DFRegion;
+  friend class DFRegionInfo;
   Kind mKind;
   DFNode *mParent;
+  unsigned mId = InvalidId;
   llvm::DenseMap<bcl::AttributeId, void *> mAttributes;
 };
 
@@ -200,6 +219,67 @@ public:
   DFLatch() : DFNode(KIND_LATCH) {}
 };
 
+/// \brief Compact representation of edges between nodes of a region.
+///
+/// Nodes of a region are identified by local indexes in range [0, size()),
+/// the local index of a node is equal to its position in the list of nodes
+/// of the region (DFRegion::getNodes()). Successors and predecessors of
+/// all nodes are stored in two arrays in the compressed sparse row format,
+/// so it is not necessary to follow pointers to traverse the graph.
+///
+/// This view is built by DFRegionInfo and it is used by data-flow solvers
+/// to traverse the region (see tsar::IndexedGraphTraits), so edges of
+/// the region must not be changed after the view has been built.
+class DFGraphView {
+public:
+  /// Returns number of nodes in the region.
+  unsigned size() const noexcept { return mNodes.size(); }
+
+  /// Returns true if the view has not been built yet.
+  bool empty() const noexcept { return mNodes.empty(); }
+
+  /// Returns number of the first node (DFNode::getId()) in the region.
+  unsigned getFirstId() const noexcept { return mFirstId; }
+
+  /// Returns a node with a specified local index.
+  DFNode * getNode(unsigned Idx) const {
+    assert(Idx < size() && "Index is out of range!");
+    return mNodes[Idx];
+  }
+
+  /// Returns local index of a specified node.
+  unsigned getIndex(const DFNode *N) const {
+    assert(N && "Node must not be null!");
+    assert(N->getId() - mFirstId < size() &&
+      "Node must be located in the region!");
+    return N->getId() - mFirstId;
+  }
+
+  /// Returns local indexes of successors of a node with a specified index.
+  llvm::ArrayRef<unsigned> successors(unsigned Idx) const {
+    assert(Idx < size() && "Index is out of range!");
+    return llvm::makeArrayRef(mSuccs).slice(
+      mSuccOffsets[Idx], mSuccOffsets[Idx + 1] - mSuccOffsets[Idx]);
+  }
+
+  /// Returns local indexes of predecessors of a node with a specified index.
+  llvm::ArrayRef<unsigned> predecessors(unsigned Idx) const {
+    assert(Idx < size() && "Index is out of range!");
+    return llvm::makeArrayRef(mPreds).slice(
+      mPredOffsets[Idx], mPredOffsets[Idx + 1] - mPredOffsets[Idx]);
+  }
+
+private:
+  friend class DFRegionInfo;
+
+  llvm::ArrayRef<DFNode *> mNodes;
+  unsigned mFirstId = DFNode::InvalidId;
+  std::vector<unsigned> mSuccOffsets;
+  std::vector<unsigned> mSuccs;
+  std::vector<unsigned> mPredOffsets;
+  std::vector<unsigned> mPreds;
+};
+
 /// \brief Representation of a region in a data-flow framework.
 ///
 /// In some cases it is convenient to use hierarchy of nodes. Some nodes
@@ -257,6 +337,13 @@ public:
   /// Returns iterator that points to the ending of the internal regions.
   region_iterator region_end() const { return mRegions.end(); }
 
+  /// \brief Returns compact view of edges between nodes of this region.
+  ///
+  /// The view is built by DFRegionInfo, it is empty if the region has been
+  /// constructed in some other way. If the view is not empty, data-flow
+  /// solvers use it to traverse the region.
+  const DFGraphView & getGraphView() const noexcept { return mView; }
+
   /// \brief Returns the entry-point of the data-flow graph.
   ///
   /// The result of this method is an entry point which is necessary to solve
@@ -333,9 +420,12 @@ protected:
   explicit DFRegion(Kind K) : DFNode(K), mLatchNode(nullptr) {}
 
 private:
+  friend class DFRegionInfo;
+
   std::vector<DFNode *> mNodes;
   std::vector<DFRegion *> mRegions;
   DFNode *mLatchNode;
+  DFGraphView mView;
 };
 
 /// \brief Representation of a loop in a data-flow framework.
@@ -420,6 +510,273 @@ public:
 private:
   llvm::Function *mFunc;
 };
+
+/// \brief Map from data-flow nodes to values which is indexed by numbers
+/// of nodes.
+///
+/// This is a replacement of llvm::DenseMap<DFNode *, ValueT> for nodes
+/// which have been numbered by DFRegionInfo (see DFNode::getId()). Buckets are
+/// stored in a vector and a number of a node is used as an index in this
+/// vector, so hashing and probing is not necessary to access a value.
+/// A bucket is empty if its key is null. The map supports the same interface
+/// which is used by data-flow frameworks (find(), insert(), try_emplace(),
+/// operator[]). Bucket type can be specified in the same way as for
+/// llvm::DenseMap, so tagged buckets (tsar::TaggedDenseMapPair,
+/// tsar::TaggedDenseMapTuple) can be used.
+///
+/// \attention All iterators are invalidated after insertion. Different nodes
+/// can be inserted concurrently if storage has been already allocated
+/// (see reserve()), in this case iterators are not invalidated.
+template<class ValueT,
+  class BucketT = llvm::detail::DenseMapPair<DFNode *, ValueT>>
+class DFNodeMap {
+  using BucketVector = std::vector<BucketT>;
+
+  template<class BucketItrT, class ValueRefT>
+  class IteratorImpl {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BucketT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ValueRefT *;
+    using reference = ValueRefT &;
+
+    IteratorImpl() = default;
+    IteratorImpl(BucketItrT I, BucketItrT E) : mItr(I), mEnd(E) {
+      skipEmpty();
+    }
+
+    /// Allows conversion from iterator to const_iterator.
+    template<class OtherItrT, class OtherRefT>
+    IteratorImpl(const IteratorImpl<OtherItrT, OtherRefT> &Other) :
+      mItr(Other.mItr), mEnd(Other.mEnd) {}
+
+    reference operator*() const { return *mItr; }
+    pointer operator->() const { return &*mItr; }
+
+    bool operator==(const IteratorImpl &RHS) const { return mItr == RHS.mItr; }
+    bool operator!=(const IteratorImpl &RHS) const { return mItr != RHS.mItr; }
+
+    IteratorImpl & operator++() {
+      ++mItr;
+      skipEmpty();
+      return *this;
+    }
+
+    IteratorImpl operator++(int) {
+      auto Tmp = *this;
+      ++*this;
+      return Tmp;
+    }
+
+  private:
+    template<class, class> friend class IteratorImpl;
+
+    void skipEmpty() {
+      while (mItr != mEnd && !mItr->getFirst())
+        ++mItr;
+    }
+
+    BucketItrT mItr;
+    BucketItrT mEnd;
+  };
+
+public:
+  using key_type = DFNode *;
+  using mapped_type = ValueT;
+  using value_type = BucketT;
+  using size_type = unsigned;
+  using iterator = IteratorImpl<typename BucketVector::iterator, BucketT>;
+  using const_iterator =
+    IteratorImpl<typename BucketVector::const_iterator, const BucketT>;
+
+  iterator begin() { return iterator(mBuckets.begin(), mBuckets.end()); }
+  iterator end() { return iterator(mBuckets.end(), mBuckets.end()); }
+
+  const_iterator begin() const {
+    return const_iterator(mBuckets.begin(), mBuckets.end());
+  }
+  const_iterator end() const {
+    return const_iterator(mBuckets.end(), mBuckets.end());
+  }
+
+  /// Returns number of elements in the map.
+  ///
+  /// This method has linear complexity because the number of elements is
+  /// not stored to allow concurrent insertion of different nodes.
+  size_type size() const {
+    return std::count_if(mBuckets.begin(), mBuckets.end(),
+      [](const BucketT &B) { return B.getFirst() != nullptr; });
+  }
+
+  /// Returns true if the map is empty.
+  bool empty() const { return begin() == end(); }
+
+  /// Preallocates space for nodes with numbers in range [0, NumNodes).
+  void reserve(size_type NumNodes) {
+    if (mBuckets.size() < NumNodes)
+      mBuckets.resize(NumNodes);
+  }
+
+  /// Removes all elements from the map.
+  void clear() {
+    mBuckets.clear();
+  }
+
+  /// Returns 1 if the specified node is in the map, 0 otherwise.
+  size_type count(const DFNode *N) const { return getBucket(N) ? 1 : 0; }
+
+  iterator find(const DFNode *N) {
+    if (getBucket(N))
+      return iterator(mBuckets.begin() + N->getId(), mBuckets.end());
+    return end();
+  }
+
+  const_iterator find(const DFNode *N) const {
+    if (getBucket(N))
+      return const_iterator(mBuckets.begin() + N->getId(), mBuckets.end());
+    return end();
+  }
+
+  /// \brief Inserts a new element if the node is not in the map yet.
+  ///
+  /// \return A pair of an iterator pointed to the element with a specified
+  /// key and a bool value which is true if insertion takes place.
+  template<class... ArgsT>
+  std::pair<iterator, bool> try_emplace(DFNode *N, ArgsT &&... Args) {
+    auto &B = getOrCreateBucket(N);
+    bool IsNew = !B.getFirst();
+    if (IsNew) {
+      B.getFirst() = N;
+      B.getSecond() = ValueT(std::forward<ArgsT>(Args)...);
+    }
+    return std::make_pair(
+      iterator(mBuckets.begin() + N->getId(), mBuckets.end()), IsNew);
+  }
+
+  template<class PairT>
+  std::pair<iterator, bool> insert(PairT &&KV) {
+    return try_emplace(KV.first, std::forward<PairT>(KV).second);
+  }
+
+  ValueT & operator[](DFNode *N) {
+    return try_emplace(N).first->getSecond();
+  }
+
+  /// Removes a specified node from the map, returns true on success.
+  bool erase(const DFNode *N) {
+    if (!getBucket(N))
+      return false;
+    mBuckets[N->getId()] = BucketT();
+    return true;
+  }
+
+  void erase(iterator I) {
+    assert(I != end() && "Iterator must point to an existing element!");
+    *I = BucketT();
+  }
+
+private:
+  const BucketT * getBucket(const DFNode *N) const {
+    assert(N && "Node must not be null!");
+    assert(N->getId() != DFNode::InvalidId && "Node must be numbered!");
+    if (N->getId() >= mBuckets.size())
+      return nullptr;
+    auto &B = mBuckets[N->getId()];
+    return B.getFirst() ? &B : nullptr;
+  }
+
+  BucketT & getOrCreateBucket(DFNode *N) {
+    assert(N && "Node must not be null!");
+    if (N->getId() == DFNode::InvalidId)
+      llvm::report_fatal_error("data-flow node must be numbered by "
+                               "DFRegionInfo to be inserted in DFNodeMap");
+    if (N->getId() >= mBuckets.size())
+      mBuckets.resize(N->getId() + 1);
+    auto &B = mBuckets[N->getId()];
+    assert((!B.getFirst() || B.getFirst() == N) &&
+      "Nodes from different hierarchies of regions must not be mixed!");
+    return B;
+  }
+
+  BucketVector mBuckets;
+};
+
+/// \brief Index-based traversal of a region in forward direction.
+///
+/// Compact view of the region is used (see DFGraphView), so indexes are
+/// available for regions which have been built by DFRegionInfo only.
+template<> struct IndexedGraphTraits<Forward<DFRegion *>> {
+  typedef DFNode * NodeRef;
+  static bool isIndexed(Forward<DFRegion *> G) {
+    return !G.Graph->getGraphView().empty();
+  }
+  static unsigned size(Forward<DFRegion *> G) {
+    return G.Graph->getGraphView().size();
+  }
+  static unsigned getEntryIndex(Forward<DFRegion *> G) {
+    return G.Graph->getGraphView().getIndex(G.Graph->getEntryNode());
+  }
+  static NodeRef getNode(Forward<DFRegion *> G, unsigned Idx) {
+    return G.Graph->getGraphView().getNode(Idx);
+  }
+  template<class FuncT>
+  static void forEachChild(Forward<DFRegion *> G, unsigned Idx, FuncT &&F) {
+    for (auto Pred : G.Graph->getGraphView().predecessors(Idx))
+      F(Pred);
+  }
+  template<class FuncT>
+  static void forEachInverseChild(Forward<DFRegion *> G, unsigned Idx,
+      FuncT &&F) {
+    for (auto Succ : G.Graph->getGraphView().successors(Idx))
+      F(Succ);
+  }
+};
+
+/// \brief Index-based traversal of a region in backward direction.
+///
+/// Compact view of the region is used (see DFGraphView), so indexes are
+/// available for regions which have been built by DFRegionInfo only.
+///
+/// In backward direction the latch node of a loop is treated as
+/// a predecessor of the exit node: an iteration is followed by the next one or
+/// by the exit from the loop, so values which are necessary after the loop
+/// are also necessary after the latch. This edge is not stored in the region,
+/// so the region is not modified while a problem is solved.
+template<> struct IndexedGraphTraits<Backward<DFRegion *>> {
+  typedef DFNode * NodeRef;
+  static bool isIndexed(Backward<DFRegion *> G) {
+    return !G.Graph->getGraphView().empty();
+  }
+  static unsigned size(Backward<DFRegion *> G) {
+    return G.Graph->getGraphView().size();
+  }
+  static unsigned getEntryIndex(Backward<DFRegion *> G) {
+    return G.Graph->getGraphView().getIndex(G.Graph->getExitNode());
+  }
+  static NodeRef getNode(Backward<DFRegion *> G, unsigned Idx) {
+    return G.Graph->getGraphView().getNode(Idx);
+  }
+  template<class FuncT>
+  static void forEachChild(Backward<DFRegion *> G, unsigned Idx, FuncT &&F) {
+    auto &View = G.Graph->getGraphView();
+    for (auto Succ : View.successors(Idx))
+      F(Succ);
+    if (auto *LN = G.Graph->getLatchNode())
+      if (View.getIndex(LN) == Idx)
+        F(getEntryIndex(G));
+  }
+  template<class FuncT>
+  static void forEachInverseChild(Backward<DFRegion *> G, unsigned Idx,
+      FuncT &&F) {
+    auto &View = G.Graph->getGraphView();
+    for (auto Pred : View.predecessors(Idx))
+      F(Pred);
+    if (auto *LN = G.Graph->getLatchNode())
+      if (Idx == getEntryIndex(G))
+        F(View.getIndex(LN));
+  }
+};
 }
 
 namespace llvm {
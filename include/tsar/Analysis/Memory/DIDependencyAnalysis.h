@@ -150,8 +150,10 @@ private:
   ///
   /// Descendant alias node must be already analyzed. This method use results
   /// of IR-level dependence analysis (including variable privatization) and
-  /// results of analysis of promoted memory locations.
-  void analyzeNode(tsar::DIAliasMemoryNode &DIN, Optional<unsigned> DWLang,
+  /// results of analysis of promoted memory locations. Reductions over
+  /// elements of arrays are also recognized for a specified loop.
+  void analyzeNode(Loop *L, tsar::DIAliasMemoryNode &DIN,
+    Optional<unsigned> DWLang,
     const tsar::SpanningTreeRelation<tsar::AliasTree *> &AliasSTR,
     const tsar::SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
     ArrayRef<const tsar::DIMemory *> LockedTraits,
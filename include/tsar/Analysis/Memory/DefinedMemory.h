@@ -307,6 +307,19 @@ public:
     return mAddressUnknowns.insert(I).second;
   }
 
+  /// Returns true if both sets contain the same information.
+  bool operator==(const DefUseSet &RHS) const {
+    return mDefs == RHS.mDefs && mMayDefs == RHS.mMayDefs &&
+           mUses == RHS.mUses && mExplicitAccesses == RHS.mExplicitAccesses &&
+           mAddressAccesses == RHS.mAddressAccesses &&
+           mUnknownInsts == RHS.mUnknownInsts &&
+           mExplicitUnknowns == RHS.mExplicitUnknowns &&
+           mAddressUnknowns == RHS.mAddressUnknowns;
+  }
+
+  /// Returns true if sets contain different information.
+  bool operator!=(const DefUseSet &RHS) const { return !operator==(RHS); }
+
 private:
   LocationSet mDefs;
   LocationSet mMayDefs;
@@ -350,9 +363,10 @@ public:
   typedef DFValue<ReachDFFwk, DefinitionInfo> ReachSet;
 
   /// This represents results of reach definition analysis results.
-  typedef llvm::DenseMap<DFNode *,
+  ///
+  /// Results are indexed by numbers of data-flow nodes.
+  typedef DFNodeMap<
     std::tuple<std::unique_ptr<DefUseSet>, std::unique_ptr<ReachSet>>,
-    llvm::DenseMapInfo<DFNode *>,
     tsar::TaggedDenseMapTuple<
       bcl::tagged<DFNode *, DFNode>,
       bcl::tagged<std::unique_ptr<DefUseSet>, DefUseSet>,
@@ -92,6 +92,14 @@ public:
     /// This is representation of offset (`Ptr-ArrayPtr`) after delinearization.
     ExprList Subscripts;
 
+    /// List of subscripts in a normal form, one for each subscript in
+    /// the `Subscripts` list (see computeSCEVAddRec()).
+    ///
+    /// The second value is `false` if the normal form relies on type casts
+    /// which may be unsafe. The normal form does not depend on other accesses,
+    /// so it is computed once when delinearization is finished.
+    llvm::SmallVector<std::pair<const llvm::SCEV *, bool>, 4> AddRecSubscripts;
+
     /// Creates element referenced with a specified pointer. Initial this
     /// element is not delinearized yet.
     explicit Range(llvm::Value *Ptr) : Ptr(Ptr) {
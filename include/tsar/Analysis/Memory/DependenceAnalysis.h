@@ -40,6 +40,8 @@
 #ifndef LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 #define LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/IR/Instructions.h"
@@ -67,7 +69,9 @@ template <typename T> class ArrayRef;
   class LoopInfo;
   class ScalarEvolution;
   class SCEV;
+  class SCEVAddRecExpr;
   class SCEVConstant;
+  class SCEVUnknown;
   class raw_ostream;
   class TargetLibraryInfo;
   class DefinedMemoryPass;
@@ -421,6 +425,24 @@ inline namespace tsar_impl {
       unsigned char DirSet;
     };
 
+    /// AccessFunction - This private struct represents a normal form of
+    /// an access function of a single memory reference. It does not depend
+    /// on the other reference in a pair, so it is computed once for each
+    /// reference and it is reused by all pairs this reference participates in.
+    struct AccessFunction {
+      /// Address of the reference evaluated in the innermost loop.
+      const SCEV *AccessFn = nullptr;
+      /// Base pointer of the address, or null if it is unknown.
+      const SCEVUnknown *Base = nullptr;
+      /// Size of the accessed element.
+      const SCEV *ElementSize = nullptr;
+      /// Offset from the base, or null if it is not an affine recurrence.
+      const SCEVAddRecExpr *AddRec = nullptr;
+    };
+
+    /// Normal forms of access functions of already analyzed references.
+    DenseMap<const Instruction *, AccessFunction> AccessFunctions;
+
     /// Constraint - This private class represents a constraint, as defined
     /// in the paper
     ///
@@ -722,6 +744,19 @@ inline namespace tsar_impl {
                        FullDependence &Result,
                        Constraint &NewConstraint) const;
 
+    /// strongSIVtestInt64 - Tests the strong SIV subscript pair with constant
+    /// coefficient and constant terms using fixed-width integer arithmetic.
+    /// Returns None if some of intermediate values overflow the type of
+    /// subscripts, otherwise returns the same result as strongSIVtest().
+    Optional<bool> strongSIVtestInt64(int64_t Coeff,
+                                      int64_t SrcConst,
+                                      int64_t DstConst,
+                                      Type *Ty,
+                                      const Loop *CurrentLoop,
+                                      unsigned Level,
+                                      FullDependence &Result,
+                                      Constraint &NewConstraint) const;
+
     /// weakCrossingSIVtest - Tests the weak-crossing SIV subscript pair
     /// (Src and Dst) for dependence.
     /// Things of the form [c1 + a*i] and [c2 - a*i],
@@ -837,6 +872,14 @@ inline namespace tsar_impl {
                     const SCEV *Dst,
                     FullDependence &Result) const;
 
+    /// gcdMIVtestInt64 - Tests an MIV subscript pair with constant
+    /// coefficients and constant terms using fixed-width integer arithmetic.
+    /// Returns None if some of terms are not constants or some of
+    /// intermediate values overflow the type of subscripts, otherwise returns
+    /// the same result as gcdMIVtest().
+    Optional<bool> gcdMIVtestInt64(const SCEV *Src, const SCEV *Dst,
+                                   FullDependence &Result) const;
+
     /// banerjeeMIVtest - Tests an MIV subscript pair for dependence.
     /// Returns true if any possible dependence is disproved.
     /// Marks the result as inconsistent.
@@ -993,6 +1036,10 @@ inline namespace tsar_impl {
 
     bool tryDelinearize(Instruction *Src, Instruction *Dst,
                         SmallVectorImpl<Subscript> &Pair);
+
+    /// getAccessFunction - Return normal form of an access function of
+    /// a specified load or store, compute it if it has not been computed yet.
+    const AccessFunction &getAccessFunction(Instruction *I);
   }; // class DependenceInfo
 
   /// AnalysisPass to compute dependence information in a function
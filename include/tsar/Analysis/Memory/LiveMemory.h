@@ -34,6 +34,7 @@
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include <bcl/utility.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/ThreadPool.h>
 
 namespace llvm {
 class DominatorTree;
@@ -45,8 +46,7 @@ namespace tsar {
 class LiveDFFwk : private bcl::Uncopyable {
 public:
   typedef DFValue<LiveDFFwk, MemorySet<MemoryLocationRange>> LiveSet;
-  typedef llvm::DenseMap<DFNode *, std::unique_ptr<LiveSet>,
-    llvm::DenseMapInfo<DFNode*>,
+  typedef DFNodeMap<std::unique_ptr<LiveSet>,
     tsar::TaggedDenseMapPair<
       bcl::tagged<DFNode *, DFNode>,
       bcl::tagged<std::unique_ptr<LiveSet>, LiveSet>>> LiveMemoryInfo;
@@ -66,10 +66,21 @@ public:
   DefinedMemoryInfo & getDefInfo() noexcept { return *mDefInfo; }
   const DefinedMemoryInfo & getDefInfo() const noexcept { return *mDefInfo; }
   const llvm::DominatorTree * getDomTree() const noexcept { return mDT; }
+
+  /// \brief Returns pool of tasks which is used to solve data-flow problems
+  /// for sibling regions concurrently.
+  ///
+  /// Storage for results must be allocated (LiveMemoryInfo::reserve()) before
+  /// solving the problem if the pool is not null.
+  llvm::ThreadPool * getTaskPool() const noexcept { return mTaskPool; }
+
+  /// Specifies pool of tasks, nullptr disables concurrent solving.
+  void setTaskPool(llvm::ThreadPool *Pool) noexcept { mTaskPool = Pool; }
 private:
   LiveMemoryInfo *mLiveInfo;
   DefinedMemoryInfo *mDefInfo;
   const llvm::DominatorTree *mDT;
+  llvm::ThreadPool *mTaskPool = nullptr;
 };
 
 /// This covers IN and OUT value for a live locations analysis.
@@ -134,9 +145,12 @@ template<> struct DataFlowTraits<LiveDFFwk *> {
 /// Traits for a data-flow framework which is used to find live locations.
 template<> struct RegionDFTraits<LiveDFFwk *> :
   DataFlowTraits<LiveDFFwk *> {
+  /// The latch node is connected with the exit node only if the region has
+  /// no compact view, otherwise solvers take this edge into account
+  /// (see IndexedGraphTraits<Backward<DFRegion *>>).
   static void expand(LiveDFFwk *, GraphType G) {
     DFNode *LN = G.Graph->getLatchNode();
-    if (!LN)
+    if (!LN || !G.Graph->getGraphView().empty())
       return;
     DFNode *EN = G.Graph->getExitNode();
     LN->addSuccessor(EN);
@@ -144,7 +158,7 @@ template<> struct RegionDFTraits<LiveDFFwk *> :
   }
   static void collapse(LiveDFFwk *, GraphType G) {
     DFNode *LN = G.Graph->getLatchNode();
-    if (!LN)
+    if (!LN || !G.Graph->getGraphView().empty())
       return;
     DFNode *EN = G.Graph->getExitNode();
     LN->removeSuccessor(EN);
@@ -157,6 +171,11 @@ template<> struct RegionDFTraits<LiveDFFwk *> :
   static region_iterator region_end(GraphType G) {
     return G.Graph->region_end();
   }
+  /// Sibling regions can be solved concurrently because each region updates
+  /// values of its own nodes only and def-use sets are not changed.
+  static llvm::ThreadPool * getTaskPool(LiveDFFwk *Fwk) {
+    return Fwk->getTaskPool();
+  }
 };
 }
 
@@ -191,6 +210,7 @@ public:
   void releaseMemory() override { mLiveInfo.clear(); }
 private:
   tsar::LiveMemoryInfo mLiveInfo;
+  std::unique_ptr<ThreadPool> mTaskPool;
 };
 
 /// Wrapper to access results of interprocedural live memory analysis.
@@ -39,8 +39,10 @@
 #include "tsar/Analysis/Memory/LiveMemory.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/Optional.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Pass.h>
+#include <chrono>
 #include <forward_list>
 #include <tuple>
 
@@ -178,6 +180,13 @@ public:
     mDL = nullptr;
     mTLI = nullptr;
     mSE = nullptr;
+    mDeadline.reset();
+    mQueryLimit = 0;
+    mIsTimeExceeded = false;
+    mMemoryLimit = 0;
+    mIsMemoryExceeded = false;
+    mNumExceededLoops = 0;
+    mNumQueries = 0;
   }
 
   /// Specifies a list of analyzes  that are necessary for this pass.
@@ -193,6 +202,15 @@ private:
   void collectDependencies(Loop *L, DependenceMap &Deps,
     tsar::detail::DependenceCache &Cache);
 
+  /// Returns true if a budget of the analysis is exceeded, `NumQueries` is
+  /// a number of queries which have been already performed for a current loop.
+  bool isBudgetExceeded(unsigned NumQueries);
+
+  /// Conservatively assume dependencies for all locations accessed in
+  /// a specified range of instructions.
+  void assumeDependencies(ArrayRef<Instruction *> Insts,
+    DependenceMap &Deps);
+
   /// Update collection `Deps` of loop-carried dependencies in a specified loop.
   void insertDependence(const Dependence &Dep,
     const MemoryLocation &Src, const MemoryLocation Dst,
@@ -357,6 +375,14 @@ private:
   const DataLayout *mDL = nullptr;
   TargetLibraryInfo *mTLI = nullptr;
   ScalarEvolution *mSE = nullptr;
+  Optional<std::chrono::steady_clock::time_point> mDeadline;
+  unsigned mQueryLimit = 0;
+  bool mIsTimeExceeded = false;
+  uint64_t mMemoryLimit = 0;
+  bool mIsMemoryExceeded = false;
+  unsigned mNumExceededLoops = 0;
+  /// Total number of dependence queries in a function.
+  uint64_t mNumQueries = 0;
 };
 }
 #endif//TSAR_PRIVATE_ANALYSIS_H
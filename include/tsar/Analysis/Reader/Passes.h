@@ -33,6 +33,7 @@
 namespace llvm {
 class PassRegistry;
 class FunctionPass;
+class ModulePass;
 
 /// Initialize all passes which is necessary to load external analysis results.
 void initializeAnalysisReader(PassRegistry &Registry);
@@ -44,5 +45,23 @@ FunctionPass * createAnalysisReader(llvm::StringRef Filename = "");
 
 /// Initialize a reader of external analysis results.
 void initializeAnalysisReaderPass(PassRegistry &Registry);
+
+/// Create a pass which attaches attributes from summaries of external
+/// functions stored in a specified file to declarations of these functions.
+///
+/// If `Filename` is empty `GlobalOptions::FunctionSummaryUse` value is used.
+ModulePass * createFunctionSummaryReader(llvm::StringRef Filename = "");
+
+/// Initialize a reader of function summaries.
+void initializeFunctionSummaryReaderPass(PassRegistry &Registry);
+
+/// Create a pass which stores summaries of functions defined in a module
+/// to a specified file.
+///
+/// If `Filename` is empty `GlobalOptions::FunctionSummaryEmit` value is used.
+ModulePass * createFunctionSummaryWriter(llvm::StringRef Filename = "");
+
+/// Initialize a writer of function summaries.
+void initializeFunctionSummaryWriterPass(PassRegistry &Registry);
 }
 #endif//TSAR_ANALYSIS_READER_PASSES_H
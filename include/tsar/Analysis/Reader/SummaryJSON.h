@@ -0,0 +1,65 @@
+//===--- SummaryJSON.h ---- Function Summaries In JSON -----------*- C++ -*===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines representation of function summaries in JSON format.
+// A summary describes memory effects of a function which have been inferred
+// by a previous run of analysis. Summaries are used to clarify analysis of
+// calls to external functions (for example, functions from a library).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SUMMARY_JSON_H
+#define SUMMARY_JSON_H
+
+#include <bcl/Json.h>
+#include <string>
+#include <vector>
+
+namespace tsar {
+namespace summary {
+/// List of names of attributes.
+using AttrList = std::vector<std::string>;
+
+/// Definition of a JSON-object which represents a summary of a function.
+///
+/// Attributes of the function and attributes of each its parameter are
+/// stored.
+JSON_OBJECT_BEGIN(Function)
+JSON_OBJECT_PAIR_3(Function
+  , Name, std::string
+  , Attrs, AttrList
+  , Args, std::vector<AttrList>)
+JSON_OBJECT_END(Function)
+
+/// Definition of a top-level JSON-object with name 'Summary', which contains
+/// list of function summaries.
+JSON_OBJECT_BEGIN(Summary)
+  JSON_OBJECT_ROOT_PAIR_1(Summary
+   , Functions, std::vector<summary::Function>
+  )
+  Summary() : JSON_INIT_ROOT{}
+JSON_OBJECT_END(Summary)
+}
+}
+
+JSON_DEFAULT_TRAITS(tsar::summary::, Function)
+JSON_DEFAULT_TRAITS(tsar::summary::, Summary)
+
+#endif//SUMMARY_JSON_H
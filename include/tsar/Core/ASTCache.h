@@ -0,0 +1,112 @@
+//===--- ASTCache.h ------- Cache of Clang AST Files ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a cache of Clang AST files which have been emitted for
+// source inputs. The cache allows a tool to parse only changed sources if
+// analysis is repeated in the same process (for example, in a server session).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_AST_CACHE_H
+#define TSAR_AST_CACHE_H
+
+#include <bcl/utility.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MD5.h>
+#include <string>
+
+namespace tsar {
+/// Clang AST files for source inputs which are shared between consecutive
+/// runs of a tool.
+///
+/// A source is parsed again only if its content or content of some file it
+/// includes has been changed or if it has been invalidated explicitly,
+/// otherwise the previously emitted AST file is reused. Included files are
+/// taken from the list of input files which is stored in an emitted AST file
+/// (system headers are not tracked). AST files are stored in a temporary
+/// directory which is removed when the cache is destroyed.
+///
+/// Only parsing is reused. Lowering to IR and analysis are performed for
+/// the whole program on each run.
+class ASTCache : private bcl::Uncopyable {
+public:
+  ASTCache() = default;
+  ~ASTCache();
+
+  /// Return an up to date AST file for a specified source.
+  ///
+  /// If the source should be parsed again the empty string is returned.
+  /// Statistic of the current run is updated.
+  std::string lookup(llvm::StringRef Source);
+
+  /// Return name of an AST file which should be emitted for a specified
+  /// source.
+  std::string getASTFilename(llvm::StringRef Source);
+
+  /// Remember that an AST file has been successfully emitted for a specified
+  /// source which has been previously looked up, collect files included
+  /// into the source.
+  ///
+  /// Return false if the AST file does not exist (the source has not been
+  /// parsed successfully).
+  bool insert(llvm::StringRef Source);
+
+  /// Invalidate sources which depend on a specified file.
+  ///
+  /// If included files are unknown for some source (the list of input files
+  /// could not be read), the source is invalidated on change of any file which
+  /// is not a cached source.
+  void invalidate(llvm::StringRef File);
+
+  /// Invalidate all sources and remove emitted AST files.
+  void clear();
+
+  /// Reset statistic before the next run of a tool.
+  void startRun() noexcept { mNumReused = mNumRebuilt = 0; }
+
+  /// Return number of sources which have been reused in the last run.
+  unsigned getNumReused() const noexcept { return mNumReused; }
+
+  /// Return number of sources which have been parsed in the last run.
+  unsigned getNumRebuilt() const noexcept { return mNumRebuilt; }
+
+private:
+  struct SourceInfo {
+    llvm::MD5::MD5Result Hash;
+    /// Files included into the source and hashes of their content at
+    /// the moment the source has been parsed.
+    llvm::StringMap<llvm::MD5::MD5Result> Dependencies;
+    std::string ASTFile;
+    bool IsEmitted = false;
+    bool HasDependencies = false;
+  };
+
+  /// Return a key which identifies a specified source in the cache.
+  static llvm::SmallString<128> getKey(llvm::StringRef Source);
+
+  llvm::StringMap<SourceInfo> mSources;
+  llvm::SmallString<128> mDirectory;
+  unsigned mNumReused = 0;
+  unsigned mNumRebuilt = 0;
+};
+}
+#endif//TSAR_AST_CACHE_H
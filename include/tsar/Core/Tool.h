@@ -27,10 +27,12 @@
 #ifndef TSAR_TOOL_H
 #define TSAR_TOOL_H
 
+#include "tsar/Core/ASTCache.h"
 #include "tsar/Support/GlobalOptions.h"
 #include <bcl/utility.h>
 #include <clang/Tooling/CompilationDatabase.h>
 #include <llvm/ADT/SmallVector.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -68,6 +70,10 @@ public:
   /// Return analysis options specified in a command line.
   const GlobalOptions &getGlobalOptions() const noexcept { return mGlobalOpts; }
 
+  /// Return cache of Clang AST files which is shared between runs of this
+  /// tool or nullptr if caching of AST is disabled.
+  ASTCache *getASTCache() noexcept { return mASTCache.get(); }
+
 private:
   /// \brief Stores command line options.
   ///
@@ -105,6 +111,7 @@ private:
   uint8_t mPrintSteps = 0;
   const llvm::PassInfo * mTfmPass;
   std::unique_ptr<clang::tooling::CompilationDatabase> mCompilations;
+  std::unique_ptr<ASTCache> mASTCache;
   bool mEmitAST = false;
   bool mMergeAST = false;
   bool mPrintAST = false;
@@ -116,6 +123,8 @@ private:
   bool mServer = false;
   bool mLoadSources = true;
   std::string mOutputFilename;
+  std::string mProfileFilename;
+  bool mMemoryReport = false;
   std::string mLanguage;
   std::string mInstrEntry;
   std::vector<std::string> mInstrStart;
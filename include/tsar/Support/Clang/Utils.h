@@ -46,6 +46,10 @@ class FunctionDecl;
 class LangOptions;
 class MemoryBuffer;
 class SourceManager;
+
+namespace tooling {
+class Range;
+}
 }
 
 namespace tsar {
@@ -227,6 +231,12 @@ std::vector<TokenT> buildDecl(llvm::StringRef Type,
 llvm::Expected<std::string> reformat(llvm::StringRef Code,
   llvm::StringRef Fliename);
 
+/// Reformat specified ranges of code from a specified file.
+///
+/// Lines which intersect these ranges are reformatted only.
+llvm::Expected<std::string> reformat(llvm::StringRef Code,
+  llvm::StringRef Filename, llvm::ArrayRef<clang::tooling::Range> Ranges);
+
 /// Returns location of the beginning of a line which contains a specified
 /// location.
 inline clang::SourceLocation getStartOfLine(clang::SourceLocation Loc,
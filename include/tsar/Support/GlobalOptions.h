@@ -42,6 +42,11 @@ struct GlobalOptions {
     IRMK_Weak
   };
 
+  enum InlineStrategyKind {
+    ISK_Inline = 0,
+    ISK_Specialize
+  };
+
   /// Print only names of files instead of full paths.
   bool PrintFilenameOnly = false;
   /// Disallow unsafe integer type cast in analysis passes.
@@ -71,14 +76,56 @@ struct GlobalOptions {
   /// A function is only inlined if the number of memory accesses in the caller
   /// does not exceed this value.
   unsigned MemoryAccessInlineThreshold = 0;
+  /// Strategy which is used to resolve calls which prevent dependence analysis.
+  ///
+  /// Calls may be inlined or redirected to clones of callees specialized for
+  /// the aliasing context of a call.
+  InlineStrategyKind InlineStrategy = ISK_Inline;
+  /// Precise dependence analysis of a function stops after this number of
+  /// seconds, conservative assumptions are used for the rest of the function
+  /// (0 means that there is no limit).
+  unsigned AnalysisTimeLimit = 0;
+  /// Precise dependence analysis of a loop stops after this number of
+  /// alias and dependence queries, conservative assumptions are used for
+  /// the rest of the loop (0 means that there is no limit).
+  unsigned AnalysisQueryLimit = 0;
+  /// Interprocedural analysis of recursive functions stops after this number
+  /// of iterations over a strongly connected component of a call graph if
+  /// a fixed point is not reached, conservative assumptions are used for
+  /// functions in the component (0 means that conservative assumptions are
+  /// used without iterations). The default value matches the command line.
+  unsigned RecursionIterationLimit = 8;
+  /// Number of threads which are used to solve data-flow problems for
+  /// sibling regions concurrently (0 means sequential solving).
+  unsigned DataFlowThreads = 0;
+  /// Extract into separate basic blocks only calls which boundaries are
+  /// necessary for interprocedural analysis (calls of functions with bodies),
+  /// other calls are kept in place.
+  bool SparseCallExtraction = false;
+  /// If memory usage exceeds this number of megabytes, results of analysis of
+  /// already processed functions are released and the remaining dependence
+  /// analysis is conservative (0 means that there is no limit).
+  unsigned MaxMemory = 0;
+  /// Release results of each processing step of a function as soon as this
+  /// step is finished and its output is emitted (results with locked traits
+  /// are kept for the next step).
+  bool StreamAnalysis = false;
   /// Pass to external analysis results which is used to clarify analysis/
   std::string AnalysisUse = "";
+  /// Path to summaries of external functions which is used to clarify
+  /// analysis of calls.
+  std::string FunctionSummaryUse = "";
+  /// Path to a file to store summaries of functions defined in sources.
+  std::string FunctionSummaryEmit = "";
   /// List of regions which should be optimized.
   std::vector<std::string> OptRegions;
   /// This suffix should be add to transformed sources before extension.
   std::string OutputSuffix = "";
   /// Disable formatting of a source code after transformation.
   bool NoFormat = false;
+  /// Number of threads which are used to format transformed sources
+  /// (0 means the number of available hardware threads).
+  unsigned FormatThreads = 0;
 };
 }
 
@@ -0,0 +1,138 @@
+//===- MemoryAccounting.h --- Memory Footprint of Analysis ------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions to account memory which is held by results
+// of analysis passes (alias trees, data-flow results, memory traits, etc.).
+// Analysis passes report an estimated size of their results for each function
+// and the accounted sizes are summarized for each processing step of
+// the analysis pipeline.
+//
+// This file also declares a pass which bounds memory usage. If the limit is
+// exceeded, results which have been already computed for other functions and
+// which are kept in persistent storages are released.
+//
+// In a streaming mode results of each processing step of a function are
+// released as soon as this step is finished and its output is emitted.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_MEMORY_ACCOUNTING_H
+#define TSAR_MEMORY_ACCOUNTING_H
+
+#include <llvm/ADT/StringRef.h>
+#include <cstdint>
+#include <functional>
+
+namespace llvm {
+class Function;
+class FunctionPass;
+class PassRegistry;
+class raw_ostream;
+
+void initializeMemoryLimitPassPass(PassRegistry &Registry);
+void initializeFunctionReleasePassPass(PassRegistry &Registry);
+
+/// Create a pass which releases results of analysis of already processed
+/// functions if memory usage exceeds a limit specified in global options.
+FunctionPass *createMemoryLimitPass();
+
+/// Create a pass which releases results of the current processing step of
+/// each function kept in persistent storages if streaming of functions is
+/// enabled in global options.
+///
+/// If the current step is not the last one, results of a function are kept
+/// while some of its traits are locked. This pass must follow all passes of
+/// the current step which access these results.
+FunctionPass *createFunctionReleasePass(bool IsLastStep = true);
+}
+
+namespace tsar {
+/// Start to account memory held by analysis results.
+void initializeMemoryAccounting();
+
+/// Return true if memory held by analysis results is accounted.
+bool isMemoryAccountingEnabled();
+
+/// Record an estimated number of bytes held by a specified structure which
+/// has been built for a function `F`.
+///
+/// The current processing step of the analysis pipeline is updated and a
+/// counter is also added to the profile (if it is collected).
+void trackMemoryUsage(llvm::StringRef Structure, const llvm::Function &F,
+                      uint64_t Bytes);
+
+/// Finish the current processing step and start a new one with a specified
+/// name. If the name is empty the function only finishes the current step.
+void startMemoryStep(llvm::StringRef Name);
+
+/// Print accounted memory for each structure, processing step and function.
+void printMemoryReport(llvm::raw_ostream &OS);
+
+/// Return memory usage of the process in bytes.
+///
+/// The number of bytes allocated by malloc is returned if mallinfo2() is
+/// available (glibc 2.33 or later). Otherwise, the resident set size from
+/// /proc/self/statm is used on Linux and the peak resident set size from
+/// getrusage() is used on other Unix hosts.
+uint64_t getMemoryUsage();
+
+/// Return true if a specified limit (in bytes) of memory usage is exceeded.
+///
+/// Zero limit means that there is no limit. The limit is never exceeded if
+/// memory usage of the process cannot be determined on the host.
+bool isMemoryLimitExceeded(uint64_t Limit);
+
+/// Function which releases results of analysis for a specified function
+/// and returns true if something has been released.
+///
+/// The second parameter is true if analysis of the function is finished, so
+/// results are not going to be recomputed at the following processing steps.
+using MemoryReleaser = std::function<bool(llvm::Function &, bool)>;
+
+/// Register a function which releases results of analysis kept in a storage
+/// identified by `Owner`.
+///
+/// The storage must unregister the releaser before its destruction.
+void registerMemoryReleaser(const void *Owner, MemoryReleaser Releaser);
+
+/// Forget a releaser which has been registered for a specified storage.
+void unregisterMemoryReleaser(const void *Owner);
+
+/// Release results of analysis of functions which follow `Current` in
+/// the module while memory usage exceeds a specified limit (in bytes).
+///
+/// Results of these functions have been computed at one of the previous
+/// processing steps and they are going to be recomputed. Results of
+/// functions which precede `Current` (including `Current`) are never
+/// released because they may be still used at the current step.
+///
+/// \return Number of functions which results have been released.
+unsigned releaseMemory(uint64_t Limit, llvm::Function &Current);
+
+/// Release results of analysis of a specified function which has been
+/// processed at the current step.
+///
+/// If `IsFinished` is false the function is going to be analyzed at
+/// the following steps, so results which cannot be recomputed are kept.
+/// \return True if something has been released.
+bool releaseProcessedFunction(llvm::Function &F, bool IsFinished);
+}
+
+#endif//TSAR_MEMORY_ACCOUNTING_H
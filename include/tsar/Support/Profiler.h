@@ -0,0 +1,79 @@
+//===--- Profiler.h ------- Analysis Profiler -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions to collect a profile of analysis and
+// transformation passes. The profile is written in Chrome trace event format,
+// so it can be loaded into chrome://tracing or a similar viewer.
+//
+// Legacy pass manager records an event for each pass invocation and for each
+// processed function. This file adds events for processing steps of
+// the analysis pipeline and counters reported by separate passes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_PROFILER_H
+#define TSAR_PROFILER_H
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <chrono>
+#include <cstdint>
+
+namespace llvm {
+class Function;
+class ModulePass;
+class PassRegistry;
+
+void initializeProfileStepPassPass(PassRegistry &Registry);
+
+/// Create a pass which finishes the current processing step and starts
+/// a new one with a specified name. If the name is empty the pass only
+/// finishes the current step.
+ModulePass *createProfileStepPass(StringRef Name);
+}
+
+namespace tsar {
+/// Start to collect profile.
+void initializeProfiler();
+
+/// Return true if profile is collected.
+bool isProfilerEnabled();
+
+/// Record a value of a specified counter for a function.
+///
+/// This function does nothing if profile is not collected.
+void addProfileCounter(llvm::StringRef Name, const llvm::Function &F,
+                       uint64_t Value);
+
+/// Record a task which has been executed in a specified thread, for example,
+/// processing of a single file.
+///
+/// This function does nothing if profile is not collected. It must be called
+/// from the main thread.
+void addProfileTask(llvm::StringRef Name, llvm::StringRef Detail,
+                    std::chrono::steady_clock::time_point Start,
+                    std::chrono::steady_clock::time_point End,
+                    uint64_t ThreadId);
+
+/// Write collected profile to a specified file and stop profiling.
+llvm::Error writeProfile(llvm::StringRef Path);
+}
+
+#endif//TSAR_PROFILER_H
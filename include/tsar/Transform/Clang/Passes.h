@@ -74,6 +74,24 @@ void initializeClangDVMHSMParallelizationPass(PassRegistry &Registry);
 /// Create a pass to perform DVMH-based parallelization for shared memory.
 ModulePass* createClangDVMHSMParallelization();
 
+/// Initialize a pass to perform source-level loop interchange.
+void initializeClangLoopInterchangePass(PassRegistry &Registry);
+
+/// Create a pass to perform source-level loop interchange.
+ModulePass *createClangLoopInterchange();
+
+/// Initialize a pass to perform source-level loop fusion.
+void initializeClangLoopFusionPass(PassRegistry &Registry);
+
+/// Create a pass to perform source-level loop fusion.
+ModulePass *createClangLoopFusion();
+
+/// Initialize a pass to perform source-level loop distribution.
+void initializeClangLoopDistributionPass(PassRegistry &Registry);
+
+/// Create a pass to perform source-level loop distribution.
+ModulePass *createClangLoopDistribution();
+
 /// Create pass to perform replacement of access to structure fields
 /// with separate variables.
 ModulePass * createClangStructureReplacementPass();
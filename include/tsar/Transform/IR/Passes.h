@@ -71,6 +71,9 @@ void initializeCallExtractorPassPass(PassRegistry& Registry);
 
 /// Create a pass which extract each call instruction
 /// (except debug instructions) into its own new basic block.
+///
+/// If `GlobalOptions::SparseCallExtraction` is set only calls of functions
+/// with bodies are extracted.
 FunctionPass* createCallExtractorPass();
 
 /// Initialize a pass which deduces function memory attributes.
@@ -163,6 +163,27 @@ bool ClangDependenceAnalyzer::evaluateDependency() {
           return false;
         }
       } else {
+        // Reduction clauses are generated for scalar variables only, so
+        // a reduction over elements of an array prevents parallelization.
+        clang::VarDecl *ArrayDecl = nullptr;
+        for (auto &T : TS) {
+          auto Search = mASTVars.findDecl(*T->getMemory(), mASTToClient,
+                                          mDIMemoryMatcher);
+          if (Search.first && !Search.first->getType()->isScalarType() &&
+              !mASTVars.CanonicalLocals.count(Search.first)) {
+            ArrayDecl = Search.first;
+            break;
+          }
+        }
+        if (ArrayDecl) {
+          if (IgnoreRedundant)
+            continue;
+          toDiag(mDiags, mRegion->getBeginLoc(),
+                 tsar::diag::warn_parallel_loop);
+          toDiag(mDiags, ArrayDecl->getLocation(),
+                 tsar::diag::note_parallel_reduction_array);
+          return false;
+        }
         auto CurrentKind = Red->getKind();
         auto &ReductionList =
             mDependenceInfo.get<trait::Reduction>()[CurrentKind];
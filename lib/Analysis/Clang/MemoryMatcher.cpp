@@ -125,7 +125,8 @@ STATISTIC(NumNonMatchASTMemory, "Number of non-matched AST variables");
 namespace {
 /// This matches allocas (IR) and variables (AST).
 class MatchAllocaVisitor :
-  public MatchASTBase<Value *, VarDecl *>,
+  public MatchASTBase<Value *, VarDecl *, DILocation *, DILocationMapInfo,
+    unsigned, DenseMapInfo<unsigned>, MemoryMatchInfo::MemoryMatcher>,
   public RecursiveASTVisitor<MatchAllocaVisitor> {
 public:
   MatchAllocaVisitor(SourceManager &SrcMgr, Matcher &MM,
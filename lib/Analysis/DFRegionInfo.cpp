@@ -59,6 +59,8 @@ void DFRegionInfo::recalculate(llvm::Function &F, llvm::LoopInfo &LpInfo) {
   mTopLevelRegion = new tsar::DFFunction(&F);
   buildLoopRegion(std::make_pair(&F, &LpInfo),
     llvm::cast<tsar::DFRegion>(mTopLevelRegion));
+  mTopLevelRegion->mId = mNumNodes++;
+  numberRegion(llvm::cast<tsar::DFRegion>(mTopLevelRegion));
   NumRegion = ++NumFunctionRegion + NumLoopRegion + NumBlockRegion;
 }
 
@@ -66,9 +68,45 @@ void DFRegionInfo::recalculate(llvm::Loop &L) {
   releaseMemory();
   mTopLevelRegion = new tsar::DFLoop(&L);
   buildLoopRegion(&L, llvm::cast<tsar::DFRegion>(mTopLevelRegion));
+  mTopLevelRegion->mId = mNumNodes++;
+  numberRegion(llvm::cast<tsar::DFRegion>(mTopLevelRegion));
   NumRegion = ++NumLoopRegion + NumBlockRegion;
 }
 
+void DFRegionInfo::numberRegion(DFRegion *R) {
+  assert(R && "Region must not be null!");
+  auto &View = R->mView;
+  View.mNodes = R->getNodes();
+  View.mFirstId = mNumNodes;
+  for (auto *N : R->getNodes())
+    N->mId = mNumNodes++;
+  auto NumNodes = View.size();
+  View.mSuccOffsets.clear();
+  View.mSuccOffsets.reserve(NumNodes + 1);
+  View.mPredOffsets.clear();
+  View.mPredOffsets.reserve(NumNodes + 1);
+  View.mSuccs.clear();
+  View.mPreds.clear();
+  for (auto *N : R->getNodes()) {
+    View.mSuccOffsets.push_back(View.mSuccs.size());
+    for (auto *S : N->successors()) {
+      assert(S->getParent() == R &&
+        "Successor must be located in the same region!");
+      View.mSuccs.push_back(View.getIndex(S));
+    }
+    View.mPredOffsets.push_back(View.mPreds.size());
+    for (auto *P : N->predecessors()) {
+      assert(P->getParent() == R &&
+        "Predecessor must be located in the same region!");
+      View.mPreds.push_back(View.getIndex(P));
+    }
+  }
+  View.mSuccOffsets.push_back(View.mSuccs.size());
+  View.mPredOffsets.push_back(View.mPreds.size());
+  for (auto *Inner : R->getRegions())
+    numberRegion(Inner);
+}
+
 template<class LoopReptn>
 void DFRegionInfo::buildLoopRegion(LoopReptn L, DFRegion *R) {
   assert(R && "Region must not be null!");
@@ -617,7 +617,7 @@ void IRToArrayInfoFunctor::operator()(Instruction &I, MemoryLocation &&Loc,
   for (std::size_t DimIdx = 0, DimIdxE = Range.Subscripts.size();
        DimIdx < DimIdxE; ++DimIdx) {
     auto *S = Range.Subscripts[DimIdx];
-    auto AddRecInfo = computeSCEVAddRec(S, SE);
+    auto &AddRecInfo = Range.AddRecSubscripts[DimIdx];
     const SCEV *Coef, *ConstTerm;
     const Loop *L = nullptr;
     if ((!GlobalOpts.IsSafeTypeCast || AddRecInfo.second) &&
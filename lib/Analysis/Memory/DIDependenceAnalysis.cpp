@@ -40,6 +40,7 @@
 #include "tsar/Core/Query.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
+#include "tsar/Support/MemoryAccounting.h"
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Support/Tags.h"
 #include "tsar/Support/Utils.h"
@@ -50,6 +51,7 @@
 #include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/InitializePasses.h>
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/Support/raw_ostream.h>
@@ -1738,7 +1740,137 @@ void DIDependencyAnalysisPass::propagateReduction(PHINode *Phi,
   }
 }
 
-void DIDependencyAnalysisPass::analyzeNode(DIAliasMemoryNode &DIN,
+/// Return a load which reads a value updated by a specified store.
+///
+/// The stored value must be a result of a binary operation and exactly one of
+/// its operands must be a load which accesses the same memory as the store.
+/// The position of the load in the list of operands is returned in `IsLHS`.
+static LoadInst *getUpdatedLoad(StoreInst &SI, AAResults &AA, bool &IsLHS) {
+  auto *BO = dyn_cast<BinaryOperator>(SI.getValueOperand());
+  if (!BO || !BO->hasOneUse() || BO->getParent() != SI.getParent())
+    return nullptr;
+  auto StoreLoc = MemoryLocation::get(&SI);
+  auto isUpdatedValue = [&SI, &AA, &StoreLoc](Value *V) {
+    auto *LI = dyn_cast<LoadInst>(V);
+    if (!LI || !LI->isSimple() || !LI->hasOneUse() ||
+        LI->getParent() != SI.getParent())
+      return false;
+    if (LI->getPointerOperand()->stripPointerCasts() ==
+            SI.getPointerOperand()->stripPointerCasts() &&
+        LI->getType() == SI.getValueOperand()->getType())
+      return true;
+    return AA.isMustAlias(MemoryLocation::get(LI), StoreLoc);
+  };
+  bool IsLHSUpdated = isUpdatedValue(BO->getOperand(0));
+  bool IsRHSUpdated = isUpdatedValue(BO->getOperand(1));
+  // In case of a[I] = a[I] * a[I] both operands are updated values, so it is
+  // not a reduction.
+  if (IsLHSUpdated == IsRHSUpdated)
+    return nullptr;
+  IsLHS = IsLHSUpdated;
+  return cast<LoadInst>(BO->getOperand(IsLHS ? 0 : 1));
+}
+
+/// Return reduction kind if a specified store writes a result of an
+/// associative operation which updates a value loaded from the same memory.
+static Optional<trait::Reduction::Kind> getUpdateKind(StoreInst &SI,
+                                                      bool IsLHS) {
+  auto *BO = cast<BinaryOperator>(SI.getValueOperand());
+  switch (BO->getOpcode()) {
+  case Instruction::Add: case Instruction::FAdd:
+    return trait::DIReduction::RK_Add;
+  case Instruction::Sub: case Instruction::FSub:
+    // a[I] = a[I] - X is an additive reduction, a[I] = X - a[I] is not.
+    if (IsLHS)
+      return trait::DIReduction::RK_Add;
+    return None;
+  case Instruction::Mul: case Instruction::FMul:
+    return trait::DIReduction::RK_Mult;
+  case Instruction::Or: return trait::DIReduction::RK_Or;
+  case Instruction::And: return trait::DIReduction::RK_And;
+  case Instruction::Xor: return trait::DIReduction::RK_Xor;
+  default:
+    return None;
+  }
+}
+
+/// Check whether all elements of an array are only updated in a loop with
+/// the same associative operation (for example, a[f(I)] += X).
+///
+/// All memory accesses in a loop which may refer to a specified alias node
+/// must access memory which is based on `Objects`. Each access must be a part
+/// of the `load-update-store` sequence in which the load and the store access
+/// the same memory. The other operand of the update must not read memory from
+/// the alias node (a[I] = a[I] + a[J] is not a reduction). So, neither values
+/// of array elements nor their addresses can be used in the loop apart from
+/// updates.
+static Optional<trait::Reduction::Kind>
+findArrayReduction(const Loop &L, AliasNode &AN, AliasTree &AT,
+                   const SpanningTreeRelation<AliasTree *> &AliasSTR,
+                   const SmallPtrSetImpl<const Value *> &Objects) {
+  auto &AA = AT.getAliasAnalysis();
+  // Return true if a specified instruction may access a specified alias node.
+  auto isAccessed = [&AT, &AN, &AliasSTR](Instruction &I) {
+    auto *EM = AT.find(MemoryLocation::get(&I));
+    if (!EM)
+      return true;
+    auto *Node = EM->getAliasNode(AT);
+    return Node == &AN || !AliasSTR.isUnreachable(Node, &AN);
+  };
+  Optional<trait::Reduction::Kind> Kind;
+  SmallPtrSet<LoadInst *, 8> UpdatedLoads;
+  SmallVector<LoadInst *, 8> Loads;
+  for (auto *BB : L.blocks())
+    for (auto &I : *BB) {
+      if (!I.mayReadOrWriteMemory())
+        continue;
+      if (auto *Call = dyn_cast<CallBase>(&I)) {
+        if (isDbgInfoIntrinsic(Call->getIntrinsicID()) ||
+            isMemoryMarkerIntrinsic(Call->getIntrinsicID()) ||
+            Call->doesNotAccessMemory())
+          continue;
+        return None;
+      }
+      if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+        return None;
+      if (!isAccessed(I))
+        continue;
+      if (!Objects.count(
+              getUnderlyingObject(getLoadStorePointerOperand(&I), 0)))
+        return None;
+      // Loads are checked when all stores have been processed.
+      if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        Loads.push_back(LI);
+        continue;
+      }
+      auto &SI = cast<StoreInst>(I);
+      if (!SI.isSimple())
+        return None;
+      bool IsLHS = false;
+      auto *Updated = getUpdatedLoad(SI, AA, IsLHS);
+      if (!Updated)
+        return None;
+      auto UpdateKind = getUpdateKind(SI, IsLHS);
+      if (!UpdateKind || (Kind && *Kind != *UpdateKind))
+        return None;
+      // The other operand of the update must not read the array.
+      auto *Other = cast<BinaryOperator>(SI.getValueOperand())
+                        ->getOperand(IsLHS ? 1 : 0);
+      if (auto *OtherLI = dyn_cast<LoadInst>(Other))
+        if (isAccessed(*OtherLI))
+          return None;
+      Kind = UpdateKind;
+      UpdatedLoads.insert(Updated);
+    }
+  // Each load from the array must read a value which is updated.
+  if (any_of(Loads, [&UpdatedLoads](LoadInst *LI) {
+        return !UpdatedLoads.count(LI);
+      }))
+    return None;
+  return Kind;
+}
+
+void DIDependencyAnalysisPass::analyzeNode(Loop *L, DIAliasMemoryNode &DIN,
     Optional<unsigned> DWLang,
     const SpanningTreeRelation<AliasTree *> &AliasSTR,
     const SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
@@ -1929,6 +2061,26 @@ void DIDependencyAnalysisPass::analyzeNode(DIAliasMemoryNode &DIN,
   LLVM_DEBUG(dbgs() << "[DA DI]: sanitize indirect accesses\n");
   IndirectAccessSanitizer(*mAT, DWLang, *DIATraitItr,
     GlobalOpts.IgnoreRedundantMemory).exec();
+  // Try to recognize reduction over elements of an array. Traits for
+  // a single explicitly accessed location are updated, so ancestor nodes
+  // (they are processed later) will also see the reduction.
+  if (AN && isa<DIAliasEstimateNode>(DIN) && DIATraitItr->size() == 1) {
+    auto DIMTraitItr = *DIATraitItr->begin();
+    auto *DIM = DIMTraitItr->getMemory();
+    if (DIM->getAliasNode() == &DIN && !DIM->emptyBinding() &&
+        DIMTraitItr->is_any<trait::Anti, trait::Flow, trait::Output>() &&
+        !isLockedTrait(*DIMTraitItr, LockedTraits, DIAliasSTR)) {
+      SmallPtrSet<const Value *, 4> Objects;
+      for (auto &Bind : *DIM)
+        if (Bind)
+          Objects.insert(getUnderlyingObject(Bind, 0));
+      if (auto Kind = findArrayReduction(*L, *AN, *mAT, AliasSTR, Objects)) {
+        LLVM_DEBUG(dbgs() << "[DA DI]: array reduction found\n");
+        DIMTraitItr->set<trait::Reduction>(new trait::DIReduction(*Kind));
+        ++NumTraits.get<trait::Reduction>();
+      }
+    }
+  }
   combineTraits(GlobalOpts.IgnoreRedundantMemory, *DIATraitItr);
   // We do not update traits for each memory location (as in private recognition
   // pass) because these traits should be updated early (during analysis of
@@ -2026,8 +2178,8 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
     for (auto *DIN : post_order(&DIAT)) {
       if (isa<DIAliasTopNode>(DIN))
         continue;
-      analyzeNode(cast<DIAliasMemoryNode>(*DIN), DWLang, AliasSTR, DIAliasSTR,
-        LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
+      analyzeNode(L, cast<DIAliasMemoryNode>(*DIN), DWLang, AliasSTR,
+        DIAliasSTR, LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
       for (auto &DIM : cast<DIAliasMemoryNode>(*DIN))
         if (auto *DIEM = dyn_cast<DIEstimateMemory>(&DIM))
           if (DIEM->getExpression()->getNumElements() == 0)
@@ -2068,6 +2220,14 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
             I->set<trait::Flow, trait::Anti, trait::Output>();
         }
   }
+  uint64_t PoolSize = 0;
+  for (auto *DFL : LQ)
+    if (auto *DILoop = DFL->getLoop()->getLoopID()) {
+      auto PoolItr = mTraitPool->find(DILoop);
+      if (PoolItr != mTraitPool->end() && PoolItr->get<Pool>())
+        PoolSize += PoolItr->get<Pool>()->size() * sizeof(DIMemoryTrait);
+    }
+  trackMemoryUsage("DIMemoryTraitPool", F, PoolSize);
   return false;
 }
 
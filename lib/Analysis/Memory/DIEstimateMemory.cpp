@@ -27,8 +27,10 @@
 #include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
 #include "tsar/Analysis/Memory/DIMemoryLocation.h"
+#include "tsar/Analysis/Memory/DIMemoryTrait.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Support/MemoryAccounting.h"
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Unparse/Utils.h"
@@ -2333,8 +2335,17 @@ public:
     initializeDIMemoryEnvironmentStoragePass(*PassRegistry::getPassRegistry());
   }
 
+  ~DIMemoryEnvironmentStorage() { unregisterMemoryReleaser(this); }
+
   void initializePass() override {
     getAnalysis<DIMemoryEnvironmentWrapper>().set(mEnv);
+    auto *PoolWrapper = getAnalysisIfAvailable<DIMemoryTraitPoolWrapper>();
+    registerMemoryReleaser(this, [this, PoolWrapper](Function &F,
+                                                     bool IsFinished) {
+      auto *TraitPool =
+          PoolWrapper && *PoolWrapper ? &PoolWrapper->get() : nullptr;
+      return release(F, TraitPool, IsFinished);
+    });
   }
 
   void getAnalysisUsage(AnalysisUsage &AU) const override {
@@ -2348,6 +2359,37 @@ public:
   const DIMemoryEnvironment & getEnv() const noexcept { return mEnv; }
 
 private:
+  /// Release alias tree and traits of loops for a specified function if
+  /// memory is exhausted or a processing step of the function is finished.
+  /// Results will be rebuilt from scratch when the function is analyzed again.
+  ///
+  /// Results of a function which is going to be analyzed again are kept if
+  /// some of traits are locked, because locked traits cannot be recomputed
+  /// at the following processing steps.
+  bool release(Function &F, DIMemoryTraitPool *TraitPool, bool IsFinished) {
+    if (!mEnv.get(F))
+      return false;
+    if (TraitPool) {
+      SmallVector<MDNode *, 8> LoopIDs;
+      for (auto &BB : F)
+        if (auto *LoopID =
+                BB.getTerminator()->getMetadata(LLVMContext::MD_loop))
+          LoopIDs.push_back(LoopID);
+      if (!IsFinished)
+        for (auto *LoopID : LoopIDs) {
+          auto PoolItr = TraitPool->find(LoopID);
+          if (PoolItr != TraitPool->end() && PoolItr->get<Pool>() &&
+              any_of(*PoolItr->get<Pool>(),
+                     [](DIMemoryTrait &T) { return T.is<trait::Lock>(); }))
+            return false;
+        }
+      for (auto *LoopID : LoopIDs)
+        TraitPool->erase(LoopID);
+    }
+    mEnv.erase(F);
+    return true;
+  }
+
   DIMemoryEnvironment mEnv;
 };
 }
@@ -2430,6 +2472,9 @@ bool DIEstimateMemoryPass::runOnFunction(Function &F) {
   auto MD = MDNode::get(F.getContext(), MemoryNodes);
   F.setMetadata(AliasTreeMDKind, MD);
   mDIAliasTree = Env.reset(F, std::move(NewDIAT));
+  trackMemoryUsage("DIAliasTree", F,
+    mDIAliasTree->size() * sizeof(DIAliasEstimateNode) +
+    mDIAliasTree->memory_size() * sizeof(DIEstimateMemory));
   return false;
 }
 
@@ -27,6 +27,8 @@
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Unparse/Utils.h"
@@ -68,6 +70,7 @@ bool llvm::DefinedMemoryPass::runOnFunction(Function & F) {
   const auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
   auto *DFF = cast<DFFunction>(RegionInfo.getTopLevelRegion());
   auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
+  mDefInfo.reserve(RegionInfo.getNumNodes());
   if (GDM) {
     ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, mDefInfo, *GDM);
     solveDataFlowUpward(&ReachDefFwk, DFF);
@@ -75,6 +78,18 @@ bool llvm::DefinedMemoryPass::runOnFunction(Function & F) {
     ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, mDefInfo);
     solveDataFlowUpward(&ReachDefFwk, DFF);
   }
+  if (isMemoryAccountingEnabled() || isProfilerEnabled()) {
+    uint64_t NumLocations = 0;
+    for (auto &Info : mDefInfo)
+      if (auto &DU = Info.get<DefUseSet>())
+        NumLocations +=
+          std::distance(DU->getDefs().begin(), DU->getDefs().end()) +
+          std::distance(DU->getMayDefs().begin(), DU->getMayDefs().end()) +
+          std::distance(DU->getUses().begin(), DU->getUses().end());
+    trackMemoryUsage("DefinedMemoryInfo", F,
+      mDefInfo.size() * (sizeof(DefUseSet) + sizeof(ReachSet)) +
+      NumLocations * sizeof(MemoryLocationRange));
+  }
   return false;
 }
 
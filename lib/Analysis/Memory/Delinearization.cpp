@@ -29,7 +29,9 @@
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/MemoryAccounting.h"
 #include "tsar/Support/MetadataUtils.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Support/SCEVUtils.h"
 #include "tsar/Support/Utils.h"
 #include <llvm/ADT/SmallSet.h>
@@ -637,9 +639,22 @@ bool DelinearizationPass::runOnFunction(Function &F) {
       LLVM_DEBUG(dbgs() << "[DELINEARIZE]: unable to delinearize "
                         << ArrayInfo->getBase()->getName() << "\n");
     }
+    for (auto &Range : *ArrayInfo) {
+      Range.AddRecSubscripts.reserve(Range.Subscripts.size());
+      for (auto *S : Range.Subscripts)
+        Range.AddRecSubscripts.push_back(computeSCEVAddRec(S, *mSE));
+    }
   }
   mDelinearizeInfo.updateRangeCache();
   LLVM_DEBUG(delinearizationLog(mDelinearizeInfo, *mSE, mIsSafeTypeCast, dbgs()));
+  if (isMemoryAccountingEnabled() || isProfilerEnabled()) {
+    uint64_t NumRanges = 0;
+    for (auto *ArrayInfo : mDelinearizeInfo.getArrays())
+      NumRanges += ArrayInfo->size();
+    trackMemoryUsage("DelinearizeInfo", F,
+      mDelinearizeInfo.getArrays().size() * sizeof(Array) +
+      NumRanges * sizeof(Array::Range));
+  }
   return false;
 }
 
@@ -677,11 +692,12 @@ RawDelinearizeInfo tsar::toJSON(const DelinearizeInfo &Info,
     std::vector<std::vector<std::vector<std::string>>> Accesses;
     for (auto &Range : *ArrayInfo) {
       std::vector<std::vector<std::string>> Subscripts;
-      for (auto *S : Range.Subscripts) {
+      for (auto I : seq<std::size_t>(0, Range.Subscripts.size())) {
+        auto *S = Range.Subscripts[I];
         Subscripts.emplace_back(2);
         auto &CoefStr = Subscripts.back().front();
         auto &ConstTermStr = Subscripts.back().back();
-        auto Info = computeSCEVAddRec(S, SE);
+        auto &Info = Range.AddRecSubscripts[I];
         const SCEV *Coef, *ConstTerm;
         if ((!IsSafeTypeCast || Info.second) &&
             isa<SCEVAddRecExpr>(Info.first)) {
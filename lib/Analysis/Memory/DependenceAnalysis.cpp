@@ -75,7 +75,9 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <limits>
 
 using namespace llvm;
 using namespace tsar;
@@ -117,11 +119,19 @@ STATISTIC(GCDindependence, "GCD independence");
 STATISTIC(BanerjeeApplications, "Banerjee applications");
 STATISTIC(BanerjeeIndependence, "Banerjee independence");
 STATISTIC(BanerjeeSuccesses, "Banerjee successes");
+STATISTIC(Int64FastPathApplications, "Fixed-width fast path applications");
+STATISTIC(AccessFunctionCacheHits, "Access function cache hits");
+STATISTIC(AccessFunctionCacheMisses, "Access function cache misses");
 
 static cl::opt<bool>
     Delinearize("delinearize-da", cl::init(true), cl::Hidden, cl::ZeroOrMore,
                 cl::desc("Try to delinearize array references."));
 
+static cl::opt<bool> Int64FastPath(
+    "da-int64-fast-path", cl::init(true), cl::Hidden, cl::ZeroOrMore,
+    cl::desc("Use fixed-width integer arithmetic in dependence tests if all "
+             "terms of subscripts are small constants."));
+
 //===----------------------------------------------------------------------===//
 // basics
 
@@ -1193,6 +1203,28 @@ const SCEVConstant *DependenceInfo::collectConstantUpperBound(const Loop *L,
 }
 
 
+/// Extract a value of a constant SCEV if it can be represented as a signed
+/// 64-bit integer.
+static bool getInt64Constant(const SCEV *S, int64_t &Value) {
+  if (!Int64FastPath)
+    return false;
+  auto *C = dyn_cast<SCEVConstant>(S);
+  if (!C || C->getAPInt().getMinSignedBits() > 64)
+    return false;
+  Value = C->getAPInt().getSExtValue();
+  return true;
+}
+
+/// Compute absolute value of X if it is representable as a signed integer
+/// of a specified bit width.
+static bool getAbsInt(int64_t X, unsigned Bits, int64_t &Abs) {
+  if (X >= 0) {
+    Abs = X;
+    return true;
+  }
+  return !SubOverflow<int64_t>(0, X, Abs) && isIntN(Bits, Abs);
+}
+
 // testZIV -
 // When we have a pair of subscripts of the form [c1] and [c2],
 // where c1 and c2 are both loop invariant, we attack it using
@@ -1208,6 +1240,17 @@ bool DependenceInfo::testZIV(const SCEV *Src, const SCEV *Dst,
   LLVM_DEBUG(dbgs() << "    src = " << *Src << "\n");
   LLVM_DEBUG(dbgs() << "    dst = " << *Dst << "\n");
   ++ZIVapplications;
+  int64_t SrcVal, DstVal;
+  if (getInt64Constant(Src, SrcVal) && getInt64Constant(Dst, DstVal)) {
+    ++Int64FastPathApplications;
+    if (SrcVal == DstVal) {
+      LLVM_DEBUG(dbgs() << "    provably dependent\n");
+      return false;
+    }
+    LLVM_DEBUG(dbgs() << "    provably independent\n");
+    ++ZIVindependence;
+    return true;
+  }
   if (isKnownPredicate(CmpInst::ICMP_EQ, Src, Dst)) {
     LLVM_DEBUG(dbgs() << "    provably dependent\n");
     return false; // provably dependent
@@ -1264,6 +1307,17 @@ bool DependenceInfo::strongSIVtest(const SCEV *Coeff, const SCEV *SrcConst,
   ++StrongSIVapplications;
   assert(0 < Level && Level <= CommonLevels && "level out of range");
   Level--;
+  int64_t CoeffVal, SrcVal, DstVal;
+  if (getInt64Constant(Coeff, CoeffVal) && CoeffVal != 0 &&
+      getInt64Constant(SrcConst, SrcVal) &&
+      getInt64Constant(DstConst, DstVal)) {
+    if (auto Res = strongSIVtestInt64(CoeffVal, SrcVal, DstVal,
+                                      SrcConst->getType(), CurLoop, Level,
+                                      Result, NewConstraint)) {
+      ++Int64FastPathApplications;
+      return *Res;
+    }
+  }
   if (!isEnclosingNestAddRec(SrcConst, DstConst))
     return false;
   const SCEV *Delta = SE->getMinusSCEV(SrcConst, DstConst);
@@ -1359,6 +1413,74 @@ bool DependenceInfo::strongSIVtest(const SCEV *Coeff, const SCEV *SrcConst,
 }
 
 
+// strongSIVtestInt64 -
+// Strong SIV test for subscripts with constant terms only. All arithmetic is
+// performed on signed 64-bit integers. The results are the same as in
+// strongSIVtest() with the exception that None is returned if some of
+// intermediate values can not be represented in the type of subscripts
+// without overflow. In this case, the general test should be used.
+Optional<bool> DependenceInfo::strongSIVtestInt64(
+    int64_t Coeff, int64_t SrcConst, int64_t DstConst, Type *Ty,
+    const Loop *CurLoop, unsigned Level, FullDependence &Result,
+    Constraint &NewConstraint) const {
+  unsigned Bits = SE->getTypeSizeInBits(Ty);
+  int64_t Delta;
+  if (SubOverflow(SrcConst, DstConst, Delta) || !isIntN(Bits, Delta))
+    return None;
+  LLVM_DEBUG(dbgs() << "\t    Delta = " << Delta << "\n");
+  // check that |Delta| < iteration count
+  if (const SCEV *UpperBound = collectUpperBound(CurLoop, Ty)) {
+    int64_t AbsDelta, AbsCoeff;
+    if (!getAbsInt(Delta, Bits, AbsDelta) || !getAbsInt(Coeff, Bits, AbsCoeff))
+      return None;
+    LLVM_DEBUG(dbgs() << "\t    UpperBound = " << *UpperBound << "\n");
+    bool IsOutOfBounds;
+    int64_t UB, Product;
+    if (getInt64Constant(UpperBound, UB) &&
+        !MulOverflow(UB, AbsCoeff, Product) && isIntN(Bits, Product)) {
+      IsOutOfBounds = AbsDelta > Product;
+    } else {
+      // The trip count is not a small constant, so compare |Delta| with
+      // UpperBound*|Coeff| in the same way as the general test does.
+      IsOutOfBounds = isKnownPredicate(
+          CmpInst::ICMP_SGT, SE->getConstant(Ty, AbsDelta, true),
+          SE->getMulExpr(UpperBound, SE->getConstant(Ty, AbsCoeff, true)));
+    }
+    if (IsOutOfBounds) {
+      // Distance greater than trip count - no dependence
+      ++StrongSIVindependence;
+      ++StrongSIVsuccesses;
+      return true;
+    }
+  }
+  if (Delta == std::numeric_limits<int64_t>::min() && Coeff == -1)
+    return None;
+  int64_t Distance = Delta / Coeff;
+  if (!isIntN(Bits, Distance))
+    return None;
+  LLVM_DEBUG(dbgs() << "\t    Distance = " << Distance << "\n");
+  LLVM_DEBUG(dbgs() << "\t    Remainder = " << Delta % Coeff << "\n");
+  // Make sure Coeff divides Delta exactly
+  if (Delta % Coeff != 0) {
+    // Coeff doesn't divide Distance, no dependence
+    ++StrongSIVindependence;
+    ++StrongSIVsuccesses;
+    return true;
+  }
+  auto *DistanceSCEV = SE->getConstant(Ty, Distance, true);
+  Result.DV[Level].Distance = DistanceSCEV;
+  NewConstraint.setDistance(DistanceSCEV, CurLoop);
+  if (Distance > 0)
+    Result.DV[Level].Direction &= Dependence::DVEntry::LT;
+  else if (Distance < 0)
+    Result.DV[Level].Direction &= Dependence::DVEntry::GT;
+  else
+    Result.DV[Level].Direction &= Dependence::DVEntry::EQ;
+  ++StrongSIVsuccesses;
+  return false;
+}
+
+
 // weakCrossingSIVtest -
 // From the paper, Practical Dependence Testing, Section 4.2.2
 //
@@ -2466,6 +2588,10 @@ bool DependenceInfo::gcdMIVtest(const SCEV *Src, const SCEV *Dst,
                                 FullDependence &Result) const {
   LLVM_DEBUG(dbgs() << "starting gcd\n");
   ++GCDapplications;
+  if (auto Res = gcdMIVtestInt64(Src, Dst, Result)) {
+    ++Int64FastPathApplications;
+    return *Res;
+  }
   unsigned BitWidth = SE->getTypeSizeInBits(Src->getType());
   APInt RunningGCD = APInt::getNullValue(BitWidth);
 
@@ -2642,6 +2768,95 @@ bool DependenceInfo::gcdMIVtest(const SCEV *Src, const SCEV *Dst,
 }
 
 
+// gcdMIVtestInt64 -
+// GCD test for subscripts with constant coefficients and constant terms only.
+// Arithmetic is performed on signed 64-bit integers. The results (including
+// refined directions) are the same as in gcdMIVtest() with the exception that
+// None is returned if some of terms are not constants or some of intermediate
+// values can not be represented in the type of subscripts. In this case, the
+// general test should be used.
+//
+// Return true if dependence disproved.
+Optional<bool> DependenceInfo::gcdMIVtestInt64(const SCEV *Src,
+                                               const SCEV *Dst,
+                                               FullDependence &Result) const {
+  unsigned Bits = SE->getTypeSizeInBits(Src->getType());
+  using CoeffList = SmallVector<std::pair<const Loop *, int64_t>, 4>;
+  // Collect coefficients and compute GCD of their absolute values.
+  auto collectCoeffs = [this, Bits](const SCEV *Coefficients, CoeffList &Coeffs,
+                                    uint64_t &RunningGCD, int64_t &Const) {
+    while (auto *AddRec = dyn_cast<SCEVAddRecExpr>(Coefficients)) {
+      int64_t Coeff, AbsCoeff;
+      if (!getInt64Constant(AddRec->getStepRecurrence(*SE), Coeff) ||
+          !getAbsInt(Coeff, Bits, AbsCoeff))
+        return false;
+      Coeffs.emplace_back(AddRec->getLoop(), Coeff);
+      RunningGCD = GreatestCommonDivisor64(RunningGCD, AbsCoeff);
+      Coefficients = AddRec->getStart();
+    }
+    return getInt64Constant(Coefficients, Const);
+  };
+  CoeffList SrcCoeffs, DstCoeffs;
+  uint64_t RunningGCD = 0;
+  int64_t SrcConst, DstConst, Delta;
+  if (!collectCoeffs(Src, SrcCoeffs, RunningGCD, SrcConst) ||
+      !collectCoeffs(Dst, DstCoeffs, RunningGCD, DstConst) ||
+      SubOverflow(DstConst, SrcConst, Delta) || !isIntN(Bits, Delta) ||
+      (Delta != 0 && RunningGCD == 0))
+    return None;
+  LLVM_DEBUG(dbgs() << "    ConstDelta = " << Delta << "\n");
+  if (Delta == 0)
+    return false;
+  LLVM_DEBUG(dbgs() << "    RunningGCD = " << RunningGCD << "\n");
+  if (Delta % static_cast<int64_t>(RunningGCD) != 0) {
+    ++GCDindependence;
+    return true;
+  }
+  // Try to disprove equal directions, see gcdMIVtest() for details.
+  // Delta is a constant, so ExtraGCD is always 0 here.
+  bool Improved = false;
+  for (auto &SrcCoeff : SrcCoeffs) {
+    const Loop *CurLoop = SrcCoeff.first;
+    RunningGCD = 0;
+    int64_t DstCoeff = 0;
+    // Absolute values of all coefficients have been already checked.
+    auto addToGCD = [&RunningGCD](int64_t Coeff) {
+      RunningGCD =
+          GreatestCommonDivisor64(RunningGCD, Coeff < 0 ? -Coeff : Coeff);
+    };
+    for (auto &Coeff : SrcCoeffs)
+      if (Coeff.first != CurLoop)
+        addToGCD(Coeff.second);
+    for (auto &Coeff : DstCoeffs)
+      if (Coeff.first == CurLoop)
+        DstCoeff = Coeff.second;
+      else
+        addToGCD(Coeff.second);
+    int64_t CoeffDelta;
+    if (SubOverflow(SrcCoeff.second, DstCoeff, CoeffDelta) ||
+        !isIntN(Bits, CoeffDelta) || !getAbsInt(CoeffDelta, Bits, CoeffDelta))
+      return None;
+    addToGCD(CoeffDelta);
+    LLVM_DEBUG(dbgs() << "\tRunningGCD = " << RunningGCD << "\n");
+    if (RunningGCD == 0 || Delta % static_cast<int64_t>(RunningGCD) == 0)
+      continue;
+    LLVM_DEBUG(dbgs() << "\tRemainder = "
+                      << Delta % static_cast<int64_t>(RunningGCD) << "\n");
+    bool InCommonNest = CurLoop->contains(Result.getSrc()->getParent()) &&
+      CurLoop->contains(Result.getDst()->getParent());
+    if (InCommonNest) {
+      unsigned Level = mapSrcLoop(CurLoop);
+      Result.DV[Level - 1].Direction &= unsigned(~Dependence::DVEntry::EQ);
+      Improved = true;
+    }
+  }
+  if (Improved)
+    ++GCDsuccesses;
+  LLVM_DEBUG(dbgs() << "all done\n");
+  return false;
+}
+
+
 //===----------------------------------------------------------------------===//
 // banerjeeMIVtest -
 // Use Banerjee's Inequalities to test an MIV subscript pair.
@@ -3405,6 +3620,28 @@ void DependenceInfo::updateDirection(Dependence::DVEntry &Level,
     llvm_unreachable("constraint has unexpected kind");
 }
 
+const DependenceInfo::AccessFunction &
+DependenceInfo::getAccessFunction(Instruction *I) {
+  assert(isLoadOrStore(I) && "instruction is not load or store");
+  auto Itr = AccessFunctions.find(I);
+  if (Itr != AccessFunctions.end()) {
+    ++AccessFunctionCacheHits;
+    return Itr->second;
+  }
+  ++AccessFunctionCacheMisses;
+  AccessFunction Fn;
+  Fn.AccessFn = SE->getSCEVAtScope(getLoadStorePointerOperand(I),
+                                   LI->getLoopFor(I->getParent()));
+  Fn.Base = dyn_cast<SCEVUnknown>(SE->getPointerBase(Fn.AccessFn));
+  Fn.ElementSize = SE->getElementSize(I);
+  if (Fn.Base) {
+    auto *AR = dyn_cast<SCEVAddRecExpr>(SE->getMinusSCEV(Fn.AccessFn, Fn.Base));
+    if (AR && AR->isAffine())
+      Fn.AddRec = AR;
+  }
+  return AccessFunctions.try_emplace(I, Fn).first->second;
+}
+
 /// Check if we can delinearize the subscripts. If the SCEVs representing the
 /// source and destination array references are recurrences on a nested loop,
 /// this function flattens the nested recurrences into separate recurrences
@@ -3439,47 +3676,41 @@ bool DependenceInfo::tryDelinearize(Instruction *Src, Instruction *Dst,
           "Dimensions of delinearized array (except first) must have known sizes!");
         Sizes[I] = SrcInfo.first->getDimSize(I + 1);
       }
-      for (auto *S : SrcInfo.second->Subscripts) {
-        auto AddRecInfo = computeSCEVAddRec(S, *SE);
-        SrcSubscripts.push_back(
-          AddRecInfo.second || !GO->IsSafeTypeCast ? AddRecInfo.first : S);
-      }
-      for (auto *S : DstInfo.second->Subscripts) {
-        auto AddRecInfo = computeSCEVAddRec(S, *SE);
-        DstSubscripts.push_back(
-          AddRecInfo.second || !GO->IsSafeTypeCast ? AddRecInfo.first : S);
-      }
+      // Normal forms of subscripts are computed once for each access after
+      // delinearization, so there is no need to recompute them for each pair.
+      auto addSubscripts = [this](const tsar::Array::Range &R,
+                                  SmallVectorImpl<const SCEV *> &Subscripts) {
+        for (unsigned I = 0, EI = R.Subscripts.size(); I < EI; ++I) {
+          auto &AddRecInfo = R.AddRecSubscripts[I];
+          Subscripts.push_back(AddRecInfo.second || !GO->IsSafeTypeCast
+                                   ? AddRecInfo.first
+                                   : R.Subscripts[I]);
+        }
+      };
+      addSubscripts(*SrcInfo.second, SrcSubscripts);
+      addSubscripts(*DstInfo.second, DstSubscripts);
     }
   }
 
   if (!IsDIDelinearized) {
-    Loop *SrcLoop = LI->getLoopFor(Src->getParent());
-    Loop *DstLoop = LI->getLoopFor(Dst->getParent());
-
     // Below code mimics the code in Delinearization.cpp
-    const SCEV *SrcAccessFn =
-      SE->getSCEVAtScope(SrcPtr, SrcLoop);
-    const SCEV *DstAccessFn =
-      SE->getSCEVAtScope(DstPtr, DstLoop);
+    // Copy the normal forms, the second lookup may invalidate references.
+    AccessFunction SrcFn = getAccessFunction(Src);
+    AccessFunction DstFn = getAccessFunction(Dst);
 
-    const SCEVUnknown *SrcBase =
-      dyn_cast<SCEVUnknown>(SE->getPointerBase(SrcAccessFn));
-    const SCEVUnknown *DstBase =
-      dyn_cast<SCEVUnknown>(SE->getPointerBase(DstAccessFn));
+    const SCEVUnknown *SrcBase = SrcFn.Base;
+    const SCEVUnknown *DstBase = DstFn.Base;
 
     if (!SrcBase || !DstBase || SrcBase != DstBase)
       return false;
 
-    const SCEV *ElementSize = SE->getElementSize(Src);
-    if (ElementSize != SE->getElementSize(Dst))
+    const SCEV *ElementSize = SrcFn.ElementSize;
+    if (ElementSize != DstFn.ElementSize)
       return false;
 
-    const SCEV *SrcSCEV = SE->getMinusSCEV(SrcAccessFn, SrcBase);
-    const SCEV *DstSCEV = SE->getMinusSCEV(DstAccessFn, DstBase);
-
-    const SCEVAddRecExpr *SrcAR = dyn_cast<SCEVAddRecExpr>(SrcSCEV);
-    const SCEVAddRecExpr *DstAR = dyn_cast<SCEVAddRecExpr>(DstSCEV);
-    if (!SrcAR || !DstAR || !SrcAR->isAffine() || !DstAR->isAffine())
+    const SCEVAddRecExpr *SrcAR = SrcFn.AddRec;
+    const SCEVAddRecExpr *DstAR = DstFn.AddRec;
+    if (!SrcAR || !DstAR)
       return false;
 
     // First step: collect parametric terms in both array references.
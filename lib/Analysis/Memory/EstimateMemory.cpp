@@ -25,6 +25,8 @@
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/MemorySetInfo.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Unparse/Utils.h"
 #include <llvm/ADT/Statistic.h>
 #include <llvm/ADT/PointerUnion.h>
@@ -1114,5 +1116,16 @@ bool EstimateMemoryPass::runOnFunction(Function &F) {
       }
     }
   }
+  addProfileCounter("alias tree nodes", F, mAliasTree->size());
+  if (isMemoryAccountingEnabled() || isProfilerEnabled()) {
+    uint64_t NumMemory = 0;
+    for (auto &N : *mAliasTree)
+      if (auto *EN = dyn_cast<AliasEstimateNode>(&N))
+        NumMemory += std::distance(EN->begin(), EN->end());
+    trackMemoryUsage("AliasTree", F,
+      mAliasTree->size() *
+        std::max(sizeof(AliasEstimateNode), sizeof(AliasUnknownNode)) +
+      NumMemory * sizeof(EstimateMemory));
+  }
   return false;
 }
@@ -25,9 +25,11 @@
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/Passes.h"
+#include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/PassProvider.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/SCCIterator.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/InitializePasses.h>
@@ -39,6 +41,10 @@
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "def-mem"
 
+STATISTIC(NumRecursiveSCC, "Number of analyzed recursive SCCs");
+STATISTIC(NumRecursionLimit,
+          "Number of recursive SCCs which exceed the iteration limit");
+
 using namespace llvm;
 using namespace tsar;
 
@@ -53,6 +59,22 @@ public:
 
   bool runOnModule(Module &SCC) override;
   void getAnalysisUsage(AnalysisUsage& AU) const override;
+
+private:
+  /// Compute def-use summary for a function, summaries for callees are
+  /// taken from a specified storage.
+  std::unique_ptr<DefUseSet> analyzeFunction(Function &F,
+                                             InterprocDefUseInfo &Info);
+
+  /// Compute summaries for functions in a recursive SCC with fixed-point
+  /// iteration.
+  ///
+  /// Summaries are initialized with empty sets and each iteration recomputes
+  /// summaries for all functions in the SCC. If a fixed point is not reached
+  /// after a specified number of iterations summaries are removed, so
+  /// conservative assumptions will be used for calls to these functions.
+  void analyzeRecursion(ArrayRef<CallGraphNode *> SCC, unsigned MaxIterations,
+                        InterprocDefUseInfo &Info);
 };
 
 class GlobalDefinedMemoryStorage :
@@ -119,6 +141,7 @@ INITIALIZE_PASS_DEPENDENCY(CallGraphWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(GlobalDefinedMemoryProvider)
 INITIALIZE_PASS_DEPENDENCY(GlobalDefinedMemoryWrapper)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_END(GlobalDefinedMemory, "global-def-mem",
                     "Global Defined Memory Analysis", true, true)
 
@@ -127,6 +150,7 @@ void GlobalDefinedMemory::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<GlobalDefinedMemoryWrapper>();
   AU.addRequired<CallGraphWrapperPass>();
   AU.addRequired<TargetLibraryInfoWrapperPass>();
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
   AU.setPreservesAll();
 }
 
@@ -138,40 +162,81 @@ ImmutablePass *llvm::createGlobalDefinedMemoryStorage() {
   return new GlobalDefinedMemoryStorage;
 }
 
+std::unique_ptr<DefUseSet>
+GlobalDefinedMemory::analyzeFunction(Function &F, InterprocDefUseInfo &Info) {
+  LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: analyze " << F.getName()
+                    << "\n";);
+  auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
+  auto &Provider = getAnalysis<GlobalDefinedMemoryProvider>(F);
+  auto &RegInfo = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
+  const auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
+  auto *DFF = cast<DFFunction>(RegInfo.getTopLevelRegion());
+  DefinedMemoryInfo DefInfo;
+  ReachDFFwk ReachDefFwk(AT, TLI, RegInfo, DT, DefInfo, Info);
+  solveDataFlowUpward(&ReachDefFwk, DFF);
+  auto DefUseSetItr = ReachDefFwk.getDefInfo().find(DFF);
+  assert(DefUseSetItr != ReachDefFwk.getDefInfo().end() &&
+         "Def-use set must exist for a function!");
+  return std::move(DefUseSetItr->get<DefUseSet>());
+}
+
+void GlobalDefinedMemory::analyzeRecursion(ArrayRef<CallGraphNode *> SCC,
+    unsigned MaxIterations, InterprocDefUseInfo &Info) {
+  ++NumRecursiveSCC;
+  for (auto *CGN : SCC)
+    Info.try_emplace(CGN->getFunction(), std::make_unique<DefUseSet>());
+  bool IsChanged = true;
+  for (unsigned Iteration = 0; IsChanged && Iteration < MaxIterations;
+       ++Iteration) {
+    LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: iteration " << Iteration
+                      << " over recursive SCC\n");
+    IsChanged = false;
+    for (auto *CGN : SCC) {
+      auto *F = CGN->getFunction();
+      auto DefUse = analyzeFunction(*F, Info);
+      auto &Summary = Info.find(F)->get<DefUseSet>();
+      if (*Summary != *DefUse) {
+        Summary = std::move(DefUse);
+        IsChanged = true;
+      }
+    }
+  }
+  if (!IsChanged)
+    return;
+  ++NumRecursionLimit;
+  LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: iteration limit is exceeded, "
+                       "use conservative assumptions for recursive SCC\n");
+  for (auto *CGN : SCC)
+    Info.erase(CGN->getFunction());
+}
+
 bool GlobalDefinedMemory::runOnModule(Module &SCC) {
   auto &Wrapper = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (!Wrapper)
     return false;
   Wrapper->clear();
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
   for (scc_iterator<CallGraph *> SCC = scc_begin(&CG); !SCC.isAtEnd(); ++SCC) {
-    /// TODO (kaniandr@gmail.com): implement analysis in case of recursion.
-    if (SCC->size() > 1)
-      continue;
-    CallGraphNode *CGN = *SCC->begin();
-    auto F = CGN->getFunction();
     // Indirect calls or calls to functions without body may lead to implicit
     // recursion. So, disable analysis in this case.
     // TODO (kaniandr@gmail.com): sapfor.direct-user-callee is not set for
     // library functions, may be analysis of these functions is a special case
     // and these functions should be pre-analyzed.
-    if (!F || F->empty() || !hasFnAttr(*F, AttrKind::DirectUserCallee))
+    if (any_of(*SCC, [](CallGraphNode *CGN) {
+          auto F = CGN->getFunction();
+          return !F || F->empty() || !hasFnAttr(*F, AttrKind::DirectUserCallee);
+        }))
+      continue;
+    if (SCC.hasCycle() && GO.RecursionIterationLimit > 0) {
+      analyzeRecursion(*SCC, GO.RecursionIterationLimit, *Wrapper);
+      continue;
+    }
+    if (SCC->size() > 1)
       continue;
-    LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: analyze " << F->getName()
-                      << "\n";);
-    auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
-    auto &Provider = getAnalysis<GlobalDefinedMemoryProvider>(*F);
-    auto &RegInfo = Provider.get<DFRegionInfoPass>().getRegionInfo();
-    auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
-    const auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
-    auto *DFF = cast<DFFunction>(RegInfo.getTopLevelRegion());
-    DefinedMemoryInfo DefInfo;
-    ReachDFFwk ReachDefFwk(AT, TLI, RegInfo, DT, DefInfo, *Wrapper);
-    solveDataFlowUpward(&ReachDefFwk, DFF);
-    auto DefUseSetItr = ReachDefFwk.getDefInfo().find(DFF);
-    assert(DefUseSetItr != ReachDefFwk.getDefInfo().end() &&
-           "Def-use set must exist for a function!");
-    Wrapper->try_emplace(F, std::move(DefUseSetItr->get<DefUseSet>()));
+    auto *F = SCC->front()->getFunction();
+    Wrapper->try_emplace(F, analyzeFunction(*F, *Wrapper));
   }
   return false;
 }
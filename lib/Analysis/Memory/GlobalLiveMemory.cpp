@@ -29,6 +29,7 @@
 #include "tsar/Support/PassProvider.h"
 #include <llvm/ADT/SCCIterator.h>
 #include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/Analysis/ValueTracking.h>
@@ -44,6 +45,10 @@
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "live-mem"
 
+STATISTIC(NumRecursiveSCC, "Number of analyzed recursive SCCs");
+STATISTIC(NumRecursionLimit,
+          "Number of recursive SCCs which exceed the iteration limit");
+
 using namespace llvm;
 using namespace tsar;
 
@@ -144,7 +149,21 @@ void initMayLivesWithIPO(Function &F, LiveMemoryForCalls &LiveSetForCalls,
     init(Loc);
 }
 
-/// Return true if each call is extracted to its own basic block.
+/// Return true if a specified instruction calls a function with a body.
+bool isCallOfDefinition(const Instruction &I) {
+  auto *Call = dyn_cast<CallBase>(&I);
+  if (!Call)
+    return false;
+  auto *Callee =
+    dyn_cast<Function>(Call->getCalledOperand()->stripPointerCasts());
+  return Callee && !Callee->isDeclaration();
+}
+
+/// Return true if each call of a function with a body is extracted to its
+/// own basic block.
+///
+/// Live memory after other calls is not used, so these calls may be kept
+/// in place (see sparse mode of CallExtractorPass).
 bool checkCallsFrom(CallGraphNode &CGN) {
   assert(CGN.getFunction() && "Function must not be null!");
   for (auto &CallInfo : CGN) {
@@ -157,7 +176,7 @@ bool checkCallsFrom(CallGraphNode &CGN) {
         if (isMemoryMarkerIntrinsic(II->getIntrinsicID()) ||
             isDbgInfoIntrinsic(II->getIntrinsicID()))
           continue;
-      if (isa<CallBase>(&I) && HasUsefulInstr) {
+      if (isCallOfDefinition(I) && HasUsefulInstr) {
         llvm::DiagnosticInfoOptimizationFailure Diag(
             *CGN.getFunction(), I.getDebugLoc(),
             "inter-procedural live memory analysis was disabled: unable to "
@@ -240,12 +259,25 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
   Wrapper->clear();
   auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
-  std::vector<CallGraphNode *> Worklist;
+  // Each item is a strongly connected component of a call graph, components
+  // are stored in post order.
+  std::vector<std::vector<CallGraphNode *>> Worklist;
   SmallPtrSet<CallGraphNode *, 32> HasExternalCalls;
   for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
-    // TODO (kaniandr@gmail.com): implement analysis in case of recursion.
-    if (I->size() > 1)
-      return false;
+    if (I.hasCycle()) {
+      if (GO.RecursionIterationLimit == 0)
+        return false;
+      for (auto *CGN : *I) {
+        auto F = CGN->getFunction();
+        if (!F || F->empty() || hasFnAttr(*F, AttrKind::LibFunc) ||
+            !hasFnAttr(*F, AttrKind::DirectUserCallee))
+          return false;
+        if (!checkCallsFrom(*CGN))
+          return false;
+      }
+      Worklist.push_back(*I);
+      continue;
+    }
     CallGraphNode *CGN = I->front();
     auto F = CGN->getFunction();
     if (!F && !GO.NoExternalCalls)
@@ -262,7 +294,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
       return false;
     if (!checkCallsFrom(*CGN))
       return false;
-    Worklist.push_back(CGN);
+    Worklist.push_back({CGN});
   }
   auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (GDM) {
@@ -271,10 +303,13 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
   }
   auto &DL = M.getDataLayout();
   LiveMemoryForCalls LiveSetForCalls;
-  for (auto *CGN : llvm::reverse(Worklist)) {
-    auto F = CGN->getFunction();
-    if (!F || F->empty())
-      continue;
+  // Compute live memory for a function and remember memory which is live
+  // after calls from this function. If there are calls to a function which
+  // are not analyzed yet (in case of recursion) or if the function may be
+  // called outside the module use conservative boundary conditions.
+  auto analyzeFunction = [this, &DL, &LiveSetForCalls](
+      CallGraphNode &CGN, bool UseConservativeBoundary) {
+    auto *F = CGN.getFunction();
     LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: analyze " << F->getName()
                       << "\n";);
     auto &Provider = getAnalysis<GlobalLiveMemoryProvider>(*F);
@@ -288,7 +323,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     assert(DefItr != DefInfo.end() && DefItr->get<DefUseSet>() &&
       "Def-use set must not be null!");
     auto &DefUse = DefItr->get<DefUseSet>();
-    if (!HasExternalCalls.count(CGN)) {
+    if (!UseConservativeBoundary) {
       initMayLivesWithIPO(*F, LiveSetForCalls, *DefUse, MayLives);
     } else {
       LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: "
@@ -308,7 +343,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     LiveDFFwk LiveFwk(IntraLiveInfo, DefInfo, DT);
     solveDataFlowDownward(&LiveFwk, TopRegion);
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
-    for (auto &CallRecord : *CGN) {
+    for (auto &CallRecord : CGN) {
       Function *Callee = CallRecord.second->getFunction();
       if (!CallRecord.first || !Callee)
         continue;
@@ -334,7 +369,71 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
           },
           [](Instruction &, AccessInfo, AccessInfo) {});
     }
-    Wrapper->try_emplace(F, std::move(IntraLiveInfo[TopRegion]));
+    return std::move(IntraLiveInfo[TopRegion]);
+  };
+  // Forget memory which is live after calls from a function.
+  auto forgetCallsFrom = [&LiveSetForCalls](CallGraphNode &CGN) {
+    for (auto &CallRecord : CGN) {
+      Function *Callee = CallRecord.second->getFunction();
+      if (!CallRecord.first || !Callee)
+        continue;
+      auto FuncInfo = LiveSetForCalls.find(Callee);
+      if (FuncInfo == LiveSetForCalls.end())
+        continue;
+      llvm::erase_if(FuncInfo->second, [&CGN](const CallList::value_type &C) {
+        return C.get<Instruction>()->getFunction() == CGN.getFunction();
+      });
+    }
+  };
+  for (auto &SCC : llvm::reverse(Worklist)) {
+    bool IsRecursive = SCC.size() > 1 ||
+      any_of(*SCC.front(), [&SCC](const CallGraphNode::CallRecord &CR) {
+        return CR.second == SCC.front();
+      });
+    if (!IsRecursive) {
+      auto *CGN = SCC.front();
+      Wrapper->try_emplace(CGN->getFunction(),
+                           analyzeFunction(*CGN, HasExternalCalls.count(CGN)));
+      continue;
+    }
+    // Live memory after exit from a function in a recursive SCC depends on
+    // live memory after calls from functions in the same SCC. So, iterate
+    // until a fixed point is reached. Sets of live locations only grow from
+    // one iteration to another, because initially there is no live memory
+    // after recursive calls.
+    ++NumRecursiveSCC;
+    bool UseConservativeBoundary = any_of(SCC, [&HasExternalCalls](
+        CallGraphNode *CGN) { return HasExternalCalls.count(CGN); });
+    bool IsChanged = !UseConservativeBoundary;
+    for (unsigned Iteration = 0;
+         IsChanged && Iteration < GO.RecursionIterationLimit; ++Iteration) {
+      LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: iteration " << Iteration
+                        << " over recursive SCC\n");
+      IsChanged = false;
+      for (auto *CGN : SCC) {
+        forgetCallsFrom(*CGN);
+        auto LS = analyzeFunction(*CGN, false);
+        auto Itr = Wrapper->try_emplace(CGN->getFunction(), nullptr).first;
+        auto &Summary = Itr->get<LiveSet>();
+        if (!Summary || Summary->getIn() != LS->getIn() ||
+            Summary->getOut() != LS->getOut()) {
+          Summary = std::move(LS);
+          IsChanged = true;
+        }
+      }
+    }
+    if (!IsChanged && !UseConservativeBoundary)
+      continue;
+    if (IsChanged) {
+      ++NumRecursionLimit;
+      LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: iteration limit is "
+                           "exceeded, use conservative assumptions for "
+                           "recursive SCC\n");
+    }
+    for (auto *CGN : SCC) {
+      forgetCallsFrom(*CGN);
+      (*Wrapper)[CGN->getFunction()] = analyzeFunction(*CGN, true);
+    }
   }
   LLVM_DEBUG(visitedFunctionsLog(LiveSetForCalls));
   return false;
@@ -24,6 +24,9 @@
 
 #include "tsar/Analysis/Memory/LiveMemory.h"
 #include "tsar/Analysis/Memory/DefinedMemory.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Unparse/Utils.h"
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/Analysis/ValueTracking.h>
@@ -44,6 +47,7 @@ INITIALIZE_PASS_BEGIN(LiveMemoryPass, "live-mem",
   INITIALIZE_PASS_DEPENDENCY(DFRegionInfoPass)
   INITIALIZE_PASS_DEPENDENCY(DefinedMemoryPass)
   INITIALIZE_PASS_DEPENDENCY(GlobalLiveMemoryWrapper)
+  INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
   "Live Memory Analysis", false, true)
 
@@ -58,6 +62,7 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
   );
   auto *DFF = cast<DFFunction>(RegionInfo.getTopLevelRegion());
   auto &GLM = getAnalysis<GlobalLiveMemoryWrapper>();
+  mLiveInfo.reserve(RegionInfo.getNumNodes());
   auto LiveItr = mLiveInfo.insert(
     std::make_pair(DFF, std::make_unique<LiveSet>())).first;
   auto &LS = LiveItr->get<LiveSet>();
@@ -94,7 +99,28 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
     LS->setOut(std::move(MayLives));
   }
   LiveDFFwk LiveFwk(mLiveInfo, DefInfo, DT);
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  bool IsConcurrent = GO.DataFlowThreads > 0;
+  // Debug output of concurrent tasks is interleaved, so disable concurrency.
+  LLVM_DEBUG(IsConcurrent = false);
+  if (IsConcurrent) {
+    if (!mTaskPool)
+      mTaskPool = std::make_unique<ThreadPool>(
+        hardware_concurrency(GO.DataFlowThreads));
+    LiveFwk.setTaskPool(mTaskPool.get());
+  }
   solveDataFlowDownward(&LiveFwk, DFF);
+  if (isMemoryAccountingEnabled() || isProfilerEnabled()) {
+    uint64_t NumLocations = 0;
+    for (auto &Info : mLiveInfo)
+      if (auto &Live = Info.get<LiveSet>())
+        NumLocations +=
+          std::distance(Live->getIn().begin(), Live->getIn().end()) +
+          std::distance(Live->getOut().begin(), Live->getOut().end());
+    trackMemoryUsage("LiveMemoryInfo", F,
+      mLiveInfo.size() * sizeof(LiveSet) +
+      NumLocations * sizeof(MemoryLocationRange));
+  }
   return false;
 }
 
@@ -102,6 +128,7 @@ void LiveMemoryPass::getAnalysisUsage(AnalysisUsage & AU) const {
   AU.addRequired<DFRegionInfoPass>();
   AU.addRequired<DefinedMemoryPass>();
   AU.addRequired<GlobalLiveMemoryWrapper>();
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
   AU.setPreservesAll();
 }
 
@@ -40,8 +40,11 @@
 #include "tsar/Core/Query.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Unparse/Utils.h"
+#include <llvm/ADT/BitVector.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/PostOrderIterator.h>
 #include <llvm/ADT/DepthFirstIterator.h>
@@ -51,6 +54,7 @@
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/ValueTracking.h>
 #include <llvm/InitializePasses.h>
+#include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
@@ -70,6 +74,8 @@ using bcl::operator "" _b;
 #define DEBUG_TYPE "private"
 
 MEMORY_TRAIT_STATISTIC(NumTraits)
+STATISTIC(NumBudgetExceededLoops,
+  "Number of loops with conservative dependencies due to analysis budget");
 
 char PrivateRecognitionPass::ID = 0;
 INITIALIZE_PASS_IN_GROUP_BEGIN(PrivateRecognitionPass, "private",
@@ -84,6 +90,7 @@ INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(DependenceAnalysisWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(GlobalDefinedMemoryWrapper)
 INITIALIZE_PASS_IN_GROUP_END(PrivateRecognitionPass, "private",
   "Private Variable Analysis", false, true,
   DefaultQueryManager::PrintPassGroup::getPassRegistry())
@@ -120,12 +127,26 @@ bool PrivateRecognitionPass::runOnFunction(Function &F) {
   mDL = &F.getParent()->getDataLayout();
   mTLI = &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
   mSE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+  if (GlobalOpts.AnalysisTimeLimit > 0)
+    mDeadline = std::chrono::steady_clock::now() +
+                std::chrono::seconds(GlobalOpts.AnalysisTimeLimit);
+  mQueryLimit = GlobalOpts.AnalysisQueryLimit;
+  mMemoryLimit = uint64_t(GlobalOpts.MaxMemory) << 20;
   auto *DFF = cast<DFFunction>(RegionInfo.getTopLevelRegion());
   GraphNumbering<const AliasNode *> Numbers;
   numberGraph(mAliasTree, &Numbers);
   AliasTreeRelation AliasSTR(mAliasTree);
   DependenceCache Cache;
   resolveCandidats(Numbers, AliasSTR, DFF, Cache);
+  if (mNumExceededLoops > 0) {
+    std::string Msg = (Twine(mIsMemoryExceeded ? "memory limit"
+                                               : "analysis budget") +
+                       " exceeded, conservative dependencies are assumed in " +
+                       Twine(mNumExceededLoops) + " loop(s)").str();
+    DiagnosticInfoUnsupported Diag(F, Msg, findMetadata(&F), DS_Warning);
+    F.getContext().diagnose(Diag);
+  }
+  addProfileCounter("dependence queries", F, mNumQueries);
   return false;
 }
 
@@ -614,22 +635,195 @@ void PrivateRecognitionPass::insertDependence(const Dependence &Dep,
                    Deps);
 }
 
+bool PrivateRecognitionPass::isBudgetExceeded(unsigned NumQueries) {
+  if (mIsTimeExceeded || mIsMemoryExceeded)
+    return true;
+  if (mQueryLimit > 0 && NumQueries >= mQueryLimit)
+    return true;
+  if (mDeadline && std::chrono::steady_clock::now() > *mDeadline)
+    mIsTimeExceeded = true;
+  return mIsTimeExceeded;
+}
+
+void PrivateRecognitionPass::assumeDependencies(ArrayRef<Instruction *> Insts,
+    DependenceMap &Deps) {
+  DependenceImp::Descriptor Dptr;
+  Dptr.set<trait::Flow, trait::Anti, trait::Output>();
+  trait::Dependence::Flag Flag = trait::Dependence::May |
+    trait::Dependence::ConfusedCause | trait::Dependence::UnknownDistance;
+  auto assumeDep = [this, &Dptr, Flag, &Deps](Instruction &,
+      MemoryLocation &&Loc, unsigned, AccessInfo R, AccessInfo W) {
+    if (R == AccessInfo::No && W == AccessInfo::No)
+      return;
+    updateDependence(mAliasTree->find(Loc), Dptr, Flag, DistanceInfo{}, Deps);
+  };
+  auto stab = [](Instruction &, AccessInfo, AccessInfo) {};
+  for (auto *I : Insts)
+    if (I->mayReadOrWriteMemory())
+      for_each_memory(*I, *mTLI, assumeDep, stab);
+}
+
+namespace {
+/// Memory footprint of instructions in a loop.
+///
+/// Each location which is accessed in a loop is numbered once. A set of
+/// locations explicitly accessed in an instruction is computed once for each
+/// instruction and mod/ref information for a pair of an instruction and
+/// a location is obtained from alias analysis at most once. So, to check
+/// a pair of instructions which access memory in an unknown way (for example,
+/// calls) it is enough to intersect these sets instead of querying
+/// alias analysis for each pair.
+class AccessFootprint {
+public:
+  AccessFootprint(AliasTree &AT, TargetLibraryInfo &TLI,
+                  const InterprocDefUseInfo *InterDUInfo)
+      : mAT(AT), mTLI(TLI), mInterDUInfo(InterDUInfo) {}
+
+  /// Return index of a specified location.
+  unsigned getIndex(const MemoryLocation &Loc) {
+    auto Pair = mIndexes.try_emplace(Loc, mLocations.size());
+    if (Pair.second) {
+      mLocations.push_back(Loc);
+      mEstimates.push_back(mAT.find(Loc));
+    }
+    return Pair.first->second;
+  }
+
+  /// Return the number of locations.
+  unsigned size() const { return mLocations.size(); }
+
+  /// Return an estimate memory location for a location with a specified
+  /// index.
+  const EstimateMemory *getEstimate(unsigned Idx) const {
+    assert(Idx < mEstimates.size() && "Index is out of range!");
+    return mEstimates[Idx];
+  }
+
+  /// Return locations which are explicitly accessed in a specified
+  /// instruction.
+  const BitVector &getAccesses(Instruction &I) {
+    auto Itr = mInsts.find(&I);
+    if (Itr != mInsts.end() && Itr->second.IsAccessesKnown)
+      return Itr->second.Accesses;
+    SmallVector<unsigned, 8> Indexes;
+    for_each_memory(I, mTLI,
+      [this, &Indexes](Instruction &I, MemoryLocation &&Loc, unsigned Idx,
+                       AccessInfo R, AccessInfo W) {
+        if (auto *Call = dyn_cast<CallBase>(&I))
+          refineArgAccess(*Call, Loc, Idx, R, W);
+        if (R == AccessInfo::No && W == AccessInfo::No)
+          return;
+        Indexes.push_back(getIndex(Loc));
+      },
+      [](Instruction &, AccessInfo, AccessInfo) {});
+    auto &Info = mInsts[&I];
+    Info.Accesses.resize(mLocations.size());
+    for (auto Idx : Indexes)
+      Info.Accesses.set(Idx);
+    Info.IsAccessesKnown = true;
+    return Info.Accesses;
+  }
+
+  /// Return true if a specified instruction may access a location with
+  /// a specified index.
+  ///
+  /// The number of performed alias analysis queries is added to `NumQueries`.
+  bool mayModRef(Instruction &I, unsigned Idx, unsigned &NumQueries) {
+    auto &Info = mInsts[&I];
+    if (Info.Known.size() <= Idx) {
+      Info.Known.resize(mLocations.size());
+      Info.ModRef.resize(mLocations.size());
+    }
+    if (!Info.Known.test(Idx)) {
+      ++NumQueries;
+      Info.Known.set(Idx);
+      if (mAT.getAliasAnalysis().getModRefInfo(&I, mLocations[Idx]) !=
+          ModRefInfo::NoModRef)
+        Info.ModRef.set(Idx);
+    }
+    return Info.ModRef.test(Idx);
+  }
+
+private:
+  struct InstructionInfo {
+    BitVector Accesses;
+    BitVector Known;
+    BitVector ModRef;
+    bool IsAccessesKnown = false;
+  };
+
+  /// Use results of interprocedural analysis or attributes of a callee
+  /// to determine whether memory is accessed through a specified argument.
+  void refineArgAccess(CallBase &Call, const MemoryLocation &Loc,
+                       unsigned Idx, AccessInfo &R, AccessInfo &W) {
+    auto F = dyn_cast<Function>(Call.getCalledOperand()->stripPointerCasts());
+    if (F && !F->isVarArg() && mInterDUInfo && Idx < F->arg_size()) {
+      auto InterDUItr = mInterDUInfo->find(F);
+      if (InterDUItr != mInterDUInfo->end()) {
+        auto &DUS = InterDUItr->get<DefUseSet>();
+        MemoryLocationRange ArgLoc(F->arg_begin() + Idx, 0, Loc.Size);
+        if (!DUS->getDefs().overlap(ArgLoc) &&
+            !DUS->getMayDefs().overlap(ArgLoc) &&
+            !DUS->getUses().overlap(ArgLoc))
+          R = W = AccessInfo::No;
+        return;
+      }
+    }
+    if (mAT.getAliasAnalysis().getArgModRefInfo(&Call, Idx) ==
+        ModRefInfo::NoModRef)
+      R = W = AccessInfo::No;
+  }
+
+  AliasTree &mAT;
+  TargetLibraryInfo &mTLI;
+  const InterprocDefUseInfo *mInterDUInfo;
+  DenseMap<MemoryLocation, unsigned> mIndexes;
+  std::vector<MemoryLocation> mLocations;
+  std::vector<const EstimateMemory *> mEstimates;
+  DenseMap<Instruction *, InstructionInfo> mInsts;
+};
+}
+
 void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
     DependenceCache &Cache) {
-  auto &AA = mAliasTree->getAliasAnalysis();
+  auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
+  AccessFootprint Footprint(*mAliasTree, *mTLI, GDM ? &*GDM : nullptr);
   std::vector<Instruction *> LoopInsts;
   for (auto *BB : L->getBlocks())
     for (auto &I : *BB)
       LoopInsts.push_back(&I);
+  // Memory usage is checked once for each loop. Results of other functions
+  // have been already released if it was possible (see MemoryLimitPass),
+  // so conservative assumptions are the only way to save memory.
+  if (!mIsMemoryExceeded && isMemoryLimitExceeded(mMemoryLimit)) {
+    LLVM_DEBUG(dbgs() << "[PRIVATE]: memory limit exceeded\n");
+    mIsMemoryExceeded = true;
+  }
+  unsigned NumQueries = 0;
   for (auto SrcItr = LoopInsts.begin(), EndItr = LoopInsts.end();
        SrcItr != EndItr; ++SrcItr) {
     if (!(**SrcItr).mayReadOrWriteMemory())
       continue;
+    if (isBudgetExceeded(NumQueries)) {
+      // Each of the remaining pairs of accesses contains an instruction
+      // from the rest of the loop, so it is enough to conservatively
+      // assume dependencies for locations accessed in these instructions.
+      LLVM_DEBUG(dbgs() << "[PRIVATE]: analysis budget exceeded after "
+                        << NumQueries << " queries\n");
+      ++NumBudgetExceededLoops;
+      ++mNumExceededLoops;
+      assumeDependencies(
+        makeArrayRef(LoopInsts).drop_front(SrcItr - LoopInsts.begin()), Deps);
+      mNumQueries += NumQueries;
+      return;
+    }
     auto Src = getLoadOrStoreLocation(*SrcItr);
     if (!Src.Ptr) {
       if (auto II = dyn_cast<IntrinsicInst>(*SrcItr))
         if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
           continue;
+      auto SrcAccesses = Footprint.getAccesses(**SrcItr);
+      BitVector Accesses;
       for (auto DstItr = SrcItr; DstItr != EndItr; ++DstItr) {
         if (!(**DstItr).mayReadOrWriteMemory())
           continue;
@@ -648,27 +842,21 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
           Causes.push_back(*SrcItr);
         if (isa<CallBase>(*DstItr))
           Causes.push_back(*DstItr);
-        auto insertUnknownDep =
-          [this, &AA, &SrcItr, &DstItr, &Dptr, Flag, &Causes, &Deps](
-            Instruction &, MemoryLocation &&Loc, unsigned,
-            AccessInfo R, AccessInfo W) {
-          if (R == AccessInfo::No && W == AccessInfo::No)
-            return;
-          if (AA.getModRefInfo(*SrcItr, Loc) == ModRefInfo::NoModRef)
-            return;
-          if (AA.getModRefInfo(*DstItr, Loc) == ModRefInfo::NoModRef)
-            return;
-          updateDependence(mAliasTree->find(Loc), Dptr, Flag, DistanceInfo{},
-                           Deps, Causes);
-        };
-        auto stab = [](Instruction &, AccessInfo, AccessInfo) {};
         LLVM_DEBUG(dbgs() << "[PRIVATE]: conservatively assume dependence: ";
                    (**SrcItr).print(dbgs()); dbgs() << "\n";
                    (**DstItr).print(dbgs()); dbgs() << "\n");
-        for_each_memory(**SrcItr, *mTLI, insertUnknownDep, stab);
-        for_each_memory(**DstItr, *mTLI, insertUnknownDep, stab);
+        Accesses = SrcAccesses;
+        Accesses |= Footprint.getAccesses(**DstItr);
+        for (auto Idx : Accesses.set_bits()) {
+          if (!Footprint.mayModRef(**SrcItr, Idx, NumQueries) ||
+              !Footprint.mayModRef(**DstItr, Idx, NumQueries))
+            continue;
+          updateDependence(Footprint.getEstimate(Idx), Dptr, Flag,
+                           DistanceInfo{}, Deps, Causes);
+        }
       }
     } else {
+      Optional<unsigned> SrcIdx;
       for (auto DstItr = SrcItr; DstItr != EndItr; ++DstItr) {
         auto Dst = getLoadOrStoreLocation(*DstItr);
         if (!Dst.Ptr) {
@@ -677,7 +865,9 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
           if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
             if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
               continue;
-          if (AA.getModRefInfo(*DstItr, Src) == ModRefInfo::NoModRef)
+          if (!SrcIdx)
+            SrcIdx = Footprint.getIndex(Src);
+          if (!Footprint.mayModRef(**DstItr, *SrcIdx, NumQueries))
             continue;
           trait::Dependence::Flag Flag = trait::Dependence::May |
             trait::Dependence::UnknownDistance |
@@ -703,6 +893,7 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
             Dep = CacheItr->second.first.get();
             ConfusedLevels = CacheItr->second.second;
           } else {
+            ++NumQueries;
             auto D = mDepInfo->depends(*SrcItr, *DstItr, true, &ConfusedLevels);
             Dep = D.get();
             Cache.Impl.try_emplace(std::make_pair(*SrcItr, *DstItr),
@@ -736,6 +927,9 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
       }
     }
   }
+  LLVM_DEBUG(dbgs() << "[PRIVATE]: footprint of the loop contains "
+                    << Footprint.size() << " locations\n");
+  mNumQueries += NumQueries;
 }
 
 void PrivateRecognitionPass::resolveAccesses(Loop *L, const DFNode *LatchNode,
@@ -1376,6 +1570,7 @@ void PrivateRecognitionPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<DependenceAnalysisWrapperPass>();
   AU.addRequired<TargetLibraryInfoWrapperPass>();
   AU.addRequired<ScalarEvolutionWrapperPass>();
+  AU.addRequired<GlobalDefinedMemoryWrapper>();
   AU.setPreservesAll();
 }
 
@@ -0,0 +1,350 @@
+//===- FunctionSummary.cpp -- Summaries Of External Functions ----*- C++ -*===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements passes to store and to load summaries of functions.
+// A summary contains memory effects and other properties of a function
+// which have been inferred by analysis (LLVM and TSAR attributes).
+// Summaries of functions from a library can be stored after analysis of this
+// library and can be used later to analyze calls of these functions
+// from other programs, when definitions of called functions are
+// not available.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Attributes.h"
+#include "tsar/Analysis/Reader/Passes.h"
+#include "tsar/Analysis/Reader/SummaryJSON.h"
+#include "tsar/Support/GlobalOptions.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/InitializePasses.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "function-summary"
+
+STATISTIC(NumExportedFunc, "Number of exported function summaries");
+STATISTIC(NumImportedFunc, "Number of imported function summaries");
+STATISTIC(NumImportedAttr, "Number of imported attributes");
+
+namespace {
+/// Attributes which describe memory accesses of a function. At most one
+/// attribute from this list is set for a function.
+const Attribute::AttrKind MemoryFnAttrs[] = {
+  Attribute::ReadNone, Attribute::ReadOnly, Attribute::WriteOnly,
+  Attribute::ArgMemOnly, Attribute::InaccessibleMemOnly,
+  Attribute::InaccessibleMemOrArgMemOnly
+};
+
+/// Other function attributes which are stored in a summary.
+const Attribute::AttrKind OtherFnAttrs[] = {
+  Attribute::NoUnwind, Attribute::WillReturn, Attribute::NoRecurse,
+  Attribute::NoFree, Attribute::NoSync, Attribute::NoReturn,
+  Attribute::ReturnsTwice
+};
+
+/// Attributes which describe memory accesses through a pointer parameter.
+const Attribute::AttrKind MemoryParamAttrs[] = {
+  Attribute::ReadNone, Attribute::ReadOnly, Attribute::WriteOnly
+};
+
+/// Other attributes of pointer parameters which are stored in a summary.
+const Attribute::AttrKind OtherParamAttrs[] = {
+  Attribute::NoCapture, Attribute::NoAlias
+};
+
+/// TSAR attributes which are stored in a summary. Note, that `sapfor.libfunc`
+/// attribute is not stored because it is deduced for each program separately.
+const AttrKind SapforFnAttrs[] = {
+  AttrKind::NoIO, AttrKind::AlwaysReturn, AttrKind::DirectUserCallee
+};
+
+/// This pass stores summaries of all externally visible functions defined
+/// in a module.
+class FunctionSummaryWriter : public ModulePass, bcl::Uncopyable {
+public:
+  static char ID;
+
+  explicit FunctionSummaryWriter(StringRef DataFile = "") :
+    ModulePass(ID), mDataFile(DataFile) {
+    initializeFunctionSummaryWriterPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+private:
+  std::string mDataFile;
+};
+
+/// This pass loads summaries from a specified file and attaches
+/// attributes from these summaries to declarations of external functions.
+class FunctionSummaryReader : public ModulePass, bcl::Uncopyable {
+public:
+  static char ID;
+
+  explicit FunctionSummaryReader(StringRef DataFile = "") :
+    ModulePass(ID), mDataFile(DataFile) {
+    initializeFunctionSummaryReaderPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+private:
+  std::string mDataFile;
+};
+
+template<class KindList>
+void exportFnAttrs(const Function &F, const KindList &Kinds,
+    summary::AttrList &Attrs) {
+  for (auto Kind : Kinds)
+    if (F.hasFnAttribute(Kind))
+      Attrs.push_back(Attribute::getNameFromAttrKind(Kind).str());
+}
+
+template<class KindList>
+void exportParamAttrs(const Function &F, unsigned ArgNo, const KindList &Kinds,
+    summary::AttrList &Attrs) {
+  for (auto Kind : Kinds)
+    if (F.hasParamAttribute(ArgNo, Kind))
+      Attrs.push_back(Attribute::getNameFromAttrKind(Kind).str());
+}
+
+template<class KindList>
+bool isContained(Attribute::AttrKind Kind, const KindList &Kinds) {
+  return is_contained(Kinds, Kind);
+}
+
+/// Parse names of attributes, return false if some of them is unknown.
+bool parseAttrs(const summary::AttrList &Names,
+    SmallVectorImpl<Attribute::AttrKind> &Kinds,
+    SmallVectorImpl<AttrKind> *SapforKinds = nullptr) {
+  for (auto &Name : Names) {
+    if (SapforKinds) {
+      auto SapforItr = find_if(SapforFnAttrs,
+        [&Name](AttrKind Kind) { return getAsString(Kind) == Name; });
+      if (SapforItr != std::end(SapforFnAttrs)) {
+        SapforKinds->push_back(*SapforItr);
+        continue;
+      }
+    }
+    auto Kind = Attribute::getAttrKindFromName(Name);
+    if (Kind == Attribute::None)
+      return false;
+    Kinds.push_back(Kind);
+  }
+  return true;
+}
+
+/// Check that a specified summary can be applied to a declaration `F`.
+bool isCompatible(const Function &F, ArrayRef<Attribute::AttrKind> FnKinds,
+    ArrayRef<SmallVector<Attribute::AttrKind, 4>> ArgKinds) {
+  if (F.arg_size() != ArgKinds.size())
+    return false;
+  if (count_if(FnKinds, [](Attribute::AttrKind Kind) {
+        return isContained(Kind, MemoryFnAttrs);
+      }) > 1)
+    return false;
+  if (!all_of(FnKinds, [](Attribute::AttrKind Kind) {
+        return isContained(Kind, MemoryFnAttrs) ||
+               isContained(Kind, OtherFnAttrs);
+      }))
+    return false;
+  for (auto &Arg : F.args()) {
+    auto &Kinds = ArgKinds[Arg.getArgNo()];
+    if (Kinds.empty())
+      continue;
+    if (!Arg.getType()->isPointerTy())
+      return false;
+    if (count_if(Kinds, [](Attribute::AttrKind Kind) {
+          return isContained(Kind, MemoryParamAttrs);
+        }) > 1)
+      return false;
+    if (!all_of(Kinds, [](Attribute::AttrKind Kind) {
+          return isContained(Kind, MemoryParamAttrs) ||
+                 isContained(Kind, OtherParamAttrs);
+        }))
+      return false;
+  }
+  return true;
+}
+}
+
+INITIALIZE_PASS(FunctionSummaryWriter, "function-summary-writer",
+  "Function Summary Writer", true, true)
+
+char FunctionSummaryWriter::ID = 0;
+
+ModulePass * llvm::createFunctionSummaryWriter(StringRef DataFile) {
+  return new FunctionSummaryWriter(DataFile);
+}
+
+void FunctionSummaryWriter::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+}
+
+bool FunctionSummaryWriter::runOnModule(Module &M) {
+  if (mDataFile.empty()) {
+    auto *GOP = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (!GOP || GOP->getOptions().FunctionSummaryEmit.empty())
+      return false;
+    mDataFile = GOP->getOptions().FunctionSummaryEmit;
+  }
+  summary::Summary Summary;
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.hasLocalLinkage() || F.isIntrinsic())
+      continue;
+    summary::Function FS;
+    FS[summary::Function::Name] = F.getName().str();
+    auto &Attrs = FS[summary::Function::Attrs];
+    exportFnAttrs(F, MemoryFnAttrs, Attrs);
+    exportFnAttrs(F, OtherFnAttrs, Attrs);
+    for (auto Kind : SapforFnAttrs)
+      if (hasFnAttr(F, Kind))
+        Attrs.push_back(getAsString(Kind).str());
+    auto &Args = FS[summary::Function::Args];
+    Args.resize(F.arg_size());
+    for (auto &Arg : F.args())
+      if (Arg.getType()->isPointerTy()) {
+        exportParamAttrs(F, Arg.getArgNo(), MemoryParamAttrs,
+                         Args[Arg.getArgNo()]);
+        exportParamAttrs(F, Arg.getArgNo(), OtherParamAttrs,
+                         Args[Arg.getArgNo()]);
+      }
+    LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: export " << F.getName() << " ("
+                      << Attrs.size() << " attributes)\n");
+    Summary[summary::Summary::Functions].push_back(std::move(FS));
+    ++NumExportedFunc;
+  }
+  std::error_code EC;
+  raw_fd_ostream OS(mDataFile, EC, sys::fs::OF_Text);
+  if (EC) {
+    M.getContext().emitError("unable to write function summaries to '" +
+                             mDataFile + "': " + EC.message());
+    return false;
+  }
+  OS << json::Parser<summary::Summary>::unparseAsObject(Summary) << '\n';
+  return false;
+}
+
+INITIALIZE_PASS(FunctionSummaryReader, "function-summary-reader",
+  "Function Summary Reader", false, false)
+
+char FunctionSummaryReader::ID = 0;
+
+ModulePass * llvm::createFunctionSummaryReader(StringRef DataFile) {
+  return new FunctionSummaryReader(DataFile);
+}
+
+void FunctionSummaryReader::getAnalysisUsage(AnalysisUsage &AU) const {}
+
+bool FunctionSummaryReader::runOnModule(Module &M) {
+  if (mDataFile.empty()) {
+    auto *GOP = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (!GOP || GOP->getOptions().FunctionSummaryUse.empty())
+      return false;
+    mDataFile = GOP->getOptions().FunctionSummaryUse;
+  }
+  if (none_of(M, [](Function &F) { return F.isDeclaration(); }))
+    return false;
+  auto FileOrErr = MemoryBuffer::getFile(mDataFile);
+  if (auto EC = FileOrErr.getError()) {
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(mDataFile.data(),
+      Twine("unable to open file: ") + EC.message()));
+    return false;
+  }
+  json::Parser<> Parser((**FileOrErr).getBuffer().str());
+  summary::Summary Summary;
+  if (!Parser.parse(Summary)) {
+    for (auto D : Parser.errors()) {
+      DiagnosticInfoPGOProfile Diag(mDataFile.data(), D, DS_Note);
+      M.getContext().diagnose(Diag);
+    }
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(mDataFile.data(),
+      "unable to parse function summaries"));
+    return false;
+  }
+  StringMap<const summary::Function *> SummaryCache;
+  for (auto &FS : Summary[summary::Summary::Functions])
+    SummaryCache.try_emplace(FS[summary::Function::Name], &FS);
+  bool Changed = false;
+  for (auto &F : M) {
+    if (!F.isDeclaration() || F.isIntrinsic())
+      continue;
+    auto SummaryItr = SummaryCache.find(F.getName());
+    if (SummaryItr == SummaryCache.end())
+      continue;
+    auto &FS = *SummaryItr->second;
+    SmallVector<Attribute::AttrKind, 8> FnKinds;
+    SmallVector<AttrKind, 4> SapforKinds;
+    SmallVector<SmallVector<Attribute::AttrKind, 4>, 8> ArgKinds(
+      FS[summary::Function::Args].size());
+    bool IsKnown = parseAttrs(FS[summary::Function::Attrs], FnKinds,
+                              &SapforKinds);
+    for (unsigned I = 0, EI = ArgKinds.size(); I < EI && IsKnown; ++I)
+      IsKnown = parseAttrs(FS[summary::Function::Args][I], ArgKinds[I]);
+    if (!IsKnown || !isCompatible(F, FnKinds, ArgKinds)) {
+      LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: ignore incompatible summary "
+                           "for " << F.getName() << "\n");
+      continue;
+    }
+    LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: import " << F.getName() << "\n");
+    // A summary describes a definition of the function, so it is more
+    // accurate than attributes which have been attached to the declaration.
+    // Existing attributes are replaced to avoid incompatible combinations
+    // (for example, readnone and readonly).
+    if (any_of(FnKinds, [](Attribute::AttrKind Kind) {
+          return isContained(Kind, MemoryFnAttrs);
+        }))
+      for (auto Kind : MemoryFnAttrs)
+        F.removeFnAttr(Kind);
+    for (auto Kind : FnKinds)
+      F.addFnAttr(Kind);
+    for (auto Kind : SapforKinds)
+      addFnAttr(F, Kind);
+    NumImportedAttr += FnKinds.size() + SapforKinds.size();
+    for (auto &Arg : F.args()) {
+      auto &Kinds = ArgKinds[Arg.getArgNo()];
+      if (any_of(Kinds, [](Attribute::AttrKind Kind) {
+            return isContained(Kind, MemoryParamAttrs);
+          }))
+        for (auto Kind : MemoryParamAttrs)
+          F.removeParamAttr(Arg.getArgNo(), Kind);
+      for (auto Kind : Kinds)
+        F.addParamAttr(Arg.getArgNo(), Kind);
+      NumImportedAttr += Kinds.size();
+    }
+    ++NumImportedFunc;
+    Changed = true;
+  }
+  return Changed;
+}
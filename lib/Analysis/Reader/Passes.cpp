@@ -29,4 +29,6 @@ using namespace llvm;
 
 void llvm::initializeAnalysisReader(PassRegistry &Registry) {
   initializeAnalysisReaderPass(Registry);
+  initializeFunctionSummaryReaderPass(Registry);
+  initializeFunctionSummaryWriterPass(Registry);
 }
@@ -0,0 +1,192 @@
+//===--- ASTCache.cpp ----- Cache of Clang AST Files ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a cache of Clang AST files which have been emitted for
+// source inputs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Core/ASTCache.h"
+#include <clang/Basic/FileManager.h>
+#include <clang/Serialization/ASTReader.h>
+#include <clang/Serialization/PCHContainerOperations.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "ast-cache"
+
+namespace {
+Optional<MD5::MD5Result> hashFile(StringRef Path) {
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return None;
+  MD5 Hash;
+  Hash.update((*Buffer)->getBuffer());
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result;
+}
+
+/// Collect names of non-system input files which are stored in an AST file.
+class InputFileCollector : public ASTReaderListener {
+public:
+  bool needsInputFileVisitation() override { return true; }
+
+  bool visitInputFile(StringRef Filename, bool IsSystem, bool IsOverridden,
+                      bool IsExplicitModule) override {
+    if (!IsSystem)
+      mFiles.push_back(std::string(Filename));
+    return true;
+  }
+
+  ArrayRef<std::string> getFiles() const noexcept { return mFiles; }
+
+private:
+  std::vector<std::string> mFiles;
+};
+}
+
+ASTCache::~ASTCache() {
+  clear();
+  if (!mDirectory.empty())
+    sys::fs::remove(mDirectory);
+}
+
+SmallString<128> ASTCache::getKey(StringRef Source) {
+  SmallString<128> Key(Source);
+  sys::fs::make_absolute(Key);
+  sys::path::remove_dots(Key, true);
+  sys::path::native(Key);
+  return Key;
+}
+
+std::string ASTCache::lookup(StringRef Source) {
+  auto &Info = mSources[getKey(Source)];
+  auto Hash = hashFile(Source);
+  auto IsUpToDate = [&Info]() {
+    for (auto &Dep : Info.Dependencies) {
+      auto DepHash = hashFile(Dep.getKey());
+      if (!DepHash || !(*DepHash == Dep.getValue()))
+        return false;
+    }
+    return true;
+  };
+  if (Info.IsEmitted && Hash && Info.Hash == *Hash &&
+      sys::fs::exists(Info.ASTFile) && IsUpToDate()) {
+    LLVM_DEBUG(dbgs() << "[AST CACHE]: reuse " << Info.ASTFile << " for "
+                      << Source << "\n");
+    ++mNumReused;
+    return Info.ASTFile;
+  }
+  LLVM_DEBUG(dbgs() << "[AST CACHE]: parse " << Source << "\n");
+  ++mNumRebuilt;
+  Info.IsEmitted = false;
+  Info.HasDependencies = false;
+  Info.Dependencies.clear();
+  // Remove an outdated AST file, so it will not be used if parsing fails.
+  if (!Info.ASTFile.empty())
+    sys::fs::remove(Info.ASTFile);
+  // Remember content of the source before it is parsed, so changes which
+  // are made during parsing will be noticed in the next run.
+  if (Hash)
+    Info.Hash = *Hash;
+  return "";
+}
+
+std::string ASTCache::getASTFilename(StringRef Source) {
+  auto &Info = mSources[getKey(Source)];
+  if (!Info.ASTFile.empty())
+    return Info.ASTFile;
+  SmallString<128> ASTFile;
+  if (mDirectory.empty() &&
+      sys::fs::createUniqueDirectory("tsar-ast", mDirectory)) {
+    mDirectory.clear();
+    ASTFile = Source;
+    sys::path::replace_extension(ASTFile, ".ast");
+  } else {
+    ASTFile = mDirectory;
+    sys::path::append(ASTFile, Twine(sys::path::stem(Source)) + "-" +
+                                   Twine(mSources.size()) + ".ast");
+  }
+  Info.ASTFile = std::string(ASTFile);
+  return Info.ASTFile;
+}
+
+bool ASTCache::insert(StringRef Source) {
+  auto Itr = mSources.find(getKey(Source));
+  if (Itr == mSources.end() || Itr->second.ASTFile.empty() ||
+      !sys::fs::exists(Itr->second.ASTFile))
+    return false;
+  auto &Info = Itr->second;
+  Info.IsEmitted = true;
+  Info.Dependencies.clear();
+  FileManager FileMgr{FileSystemOptions()};
+  InputFileCollector Collector;
+  Info.HasDependencies = !ASTReader::readASTFileControlBlock(
+      Info.ASTFile, FileMgr, RawPCHContainerReader(), false, Collector, false);
+  if (!Info.HasDependencies) {
+    LLVM_DEBUG(dbgs() << "[AST CACHE]: unable to read input files of "
+                      << Info.ASTFile << "\n");
+    return true;
+  }
+  for (auto &File : Collector.getFiles()) {
+    auto Key = getKey(File);
+    if (Key == Itr->getKey())
+      continue;
+    if (auto Hash = hashFile(Key)) {
+      Info.Dependencies.try_emplace(Key, *Hash);
+    } else {
+      Info.HasDependencies = false;
+      Info.Dependencies.clear();
+      break;
+    }
+  }
+  LLVM_DEBUG(dbgs() << "[AST CACHE]: " << Source << " depends on "
+                    << Info.Dependencies.size() << " included files\n");
+  return true;
+}
+
+void ASTCache::invalidate(StringRef File) {
+  auto Key = getKey(File);
+  bool IsSource = mSources.count(Key);
+  for (auto &Info : mSources)
+    if (Info.getKey() == Key || Info.second.Dependencies.count(Key) ||
+        (!IsSource && !Info.second.HasDependencies)) {
+      LLVM_DEBUG(dbgs() << "[AST CACHE]: invalidate " << Info.getKey()
+                        << " on change of " << File << "\n");
+      Info.second.IsEmitted = false;
+    }
+}
+
+void ASTCache::clear() {
+  for (auto &Info : mSources)
+    if (!Info.second.ASTFile.empty())
+      sys::fs::remove(Info.second.ASTFile);
+  mSources.clear();
+}
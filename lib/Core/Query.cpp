@@ -35,7 +35,9 @@
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/MemoryAccounting.h"
 #include "tsar/Support/PassBarrier.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Transform/AST/Passes.h"
 #include "tsar/Transform/IR/Passes.h"
 #include "tsar/Transform/Mixed/Passes.h"
@@ -61,6 +63,7 @@
 #include <llvm/Transforms/IPO/AlwaysInliner.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Utils.h>
+#include <memory>
 
 using namespace clang;
 using namespace llvm;
@@ -99,6 +102,9 @@ void addInitialTransformations(legacy::PassManager &Passes) {
   //}
   // In other cases 'clang' automatically deletes unreachable blocks.
   Passes.add(createUnreachableBlockEliminationPass());
+  // Attributes of external functions should be known before attributes of
+  // their callers are deduced.
+  Passes.add(createFunctionSummaryReader());
   Passes.add(createInferFunctionAttrsLegacyPass());
   Passes.add(createPostOrderFunctionAttrsLegacyPass());
   Passes.add(createReversePostOrderFunctionAttrsPass());
@@ -118,6 +124,7 @@ void addBeforeTfmAnalysis(legacy::PassManager &Passes, StringRef AnalysisUse) {
   Passes.add(createGlobalDefinedMemoryPass());
   Passes.add(createGlobalLiveMemoryPass());
   Passes.add(createFunctionMemoryAttrsAnalysis());
+  Passes.add(createMemoryLimitPass());
   Passes.add(createDIDependencyAnalysisPass());
   Passes.add(createProcessDIMemoryTraitPass(mark<trait::DirectAccess>));
   Passes.add(createAnalysisReader());
@@ -153,6 +160,7 @@ void addAfterSROAAnalysis(const GlobalOptions &GO, const DataLayout &DL,
   Passes.add(createGlobalDefinedMemoryPass());
   Passes.add(createGlobalLiveMemoryPass());
   Passes.add(createFunctionMemoryAttrsAnalysis());
+  Passes.add(createMemoryLimitPass());
   Passes.add(createDIDependencyAnalysisPass());
 }
 
@@ -183,6 +191,7 @@ void addAfterLoopRotateAnalysis(legacy::PassManager &Passes) {
   Passes.add(createGlobalDefinedMemoryPass());
   Passes.add(createGlobalLiveMemoryPass());
   Passes.add(createFunctionMemoryAttrsAnalysis());
+  Passes.add(createMemoryLimitPass());
   Passes.add(createDIDependencyAnalysisPass());
 }
 } // namespace tsar
@@ -256,6 +265,24 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
       Passes.add(PI->getNormalCtor()());
     }
   };
+  // Mark beginning of a processing step in a profile and in a report of
+  // memory usage (if they are collected). Empty name marks the end of
+  // the last step.
+  auto addProfileStep = [&Passes](StringRef Name) {
+    if (isProfilerEnabled() || isMemoryAccountingEnabled())
+      Passes.add(createProfileStepPass(Name));
+  };
+  // Functions are streamed through each processing step: results of a step
+  // are released as soon as all passes of this step, including printers and
+  // outputs, have processed a function. Results of a function are kept for the
+  // following step only if some of its traits are locked. Alias trees of
+  // other functions are never accessed, callers use summaries of callees
+  // which are kept in separate storages. If some of printers or outputs
+  // process the whole module, results are released after them.
+  auto addRelease = [&Passes, this](bool IsLastStep) {
+    if (mGlobalOptions->StreamAnalysis)
+      Passes.add(createFunctionReleasePass(IsLastStep));
+  };
   // Add pass to a manager if it is necessary for some of pases in a list.
   // Properties of this passes will be looked up in a specified group of passes.
   auto addIfNecessary =
@@ -299,9 +326,12 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
   addIfNecessary(createAPCLoopInfoBasePass(), mPrintPasses,
                  PrintPassGroup::getPassRegistry(), Passes);
 #endif
+  addProfileStep("BeforeTfmAnalysis");
   addBeforeTfmAnalysis(Passes);
   addPrint(BeforeTfmAnalysis);
   addOutput(BeforeTfmAnalysis);
+  addRelease(false);
+  addProfileStep("AfterSroaAnalysis");
   addAfterSROAAnalysis(*mGlobalOptions, M->getDataLayout(), Passes);
 #ifdef APC_FOUND
   addIfNecessary(createAPCFunctionInfoPass(), mPrintPasses,
@@ -311,6 +341,8 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
 #endif
   addPrint(AfterSroaAnalysis);
   addOutput(AfterSroaAnalysis);
+  addRelease(false);
+  addProfileStep("AfterFunctionInlineAnalysis");
   addAfterFunctionInlineAnalysis(
       *mGlobalOptions, M->getDataLayout(),
       [](auto &T) {
@@ -320,9 +352,14 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
       Passes);
   addPrint(AfterFunctionInlineAnalysis);
   addOutput(AfterFunctionInlineAnalysis);
+  addRelease(false);
+  addProfileStep("AfterLoopRotateAnalysis");
   addAfterLoopRotateAnalysis(Passes);
   addPrint(AfterLoopRotateAnalysis);
   addOutput(AfterLoopRotateAnalysis);
+  addRelease(true);
+  addProfileStep("");
+  Passes.add(createFunctionSummaryWriter());
   Passes.add(createVerifierPass());
   Passes.run(*M);
 }
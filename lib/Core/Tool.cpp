@@ -32,12 +32,15 @@
 #include "tsar/Frontend/Clang/ASTMergeAction.h"
 #include "tsar/Frontend/Clang/Pragma.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/Profiler.h"
 #ifdef APC_FOUND
 # include "tsar/APC/Utils.h"
 #endif
 #include <clang/Frontend/FrontendActions.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/ScopeExit.h>
 #include <llvm/IR/LegacyPassNameParser.h>
 #include <llvm/Support/Debug.h>
 #include <llvm/Support/Path.h>
@@ -122,6 +125,7 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> EmitAST;
   llvm::cl::opt<bool> MergeAST;
   llvm::cl::alias MergeASTA;
+  llvm::cl::opt<bool> CacheAST;
   llvm::cl::opt<std::string> Output;
   llvm::cl::opt<std::string> Language;
   llvm::cl::opt<bool> Verbose;
@@ -147,6 +151,8 @@ struct Options : private bcl::Uncopyable {
         DefaultQueryManager::PrintPassGroup>>> PrintOnly;
   llvm::cl::list<unsigned> PrintStep;
   llvm::cl::opt<bool> PrintFilename;
+  llvm::cl::opt<std::string> Profile;
+  llvm::cl::opt<bool> MemoryReport;
 
   llvm::cl::OptionCategory AnalysisCategory;
   llvm::cl::opt<bool> Check;
@@ -165,14 +171,25 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> NoMathErrno;
   llvm::cl::opt<bool> Inline;
   llvm::cl::opt<unsigned> MemoryAccessInlineThreshold;
+  llvm::cl::opt<GlobalOptions::InlineStrategyKind> InlineStrategy;
   llvm::cl::opt<bool> NoInline;
+  llvm::cl::opt<unsigned> AnalysisTimeLimit;
+  llvm::cl::opt<unsigned> AnalysisQueryLimit;
+  llvm::cl::opt<unsigned> RecursionIterationLimit;
+  llvm::cl::opt<unsigned> DataFlowThreads;
+  llvm::cl::opt<bool> SparseCallExtraction;
+  llvm::cl::opt<unsigned> MaxMemory;
+  llvm::cl::opt<bool> StreamAnalysis;
   llvm::cl::opt<bool> LoadSources;
   llvm::cl::opt<bool> NoLoadSources;
   llvm::cl::opt<std::string> AnalysisUse;
+  llvm::cl::opt<std::string> FunctionSummaryUse;
+  llvm::cl::opt<std::string> FunctionSummaryEmit;
   llvm::cl::list<std::string> OptRegion;
 
   llvm::cl::OptionCategory TransformCategory;
   llvm::cl::opt<bool> NoFormat;
+  llvm::cl::opt<unsigned> FormatThreads;
   llvm::cl::opt<std::string> OutputSuffix;
 private:
   /// Default constructor.
@@ -207,6 +224,11 @@ Options::Options() :
   MergeAST("merge-ast", cl::cat(CompileCategory),
     cl::desc("Merge Clang AST for source inputs before analysis")),
   MergeASTA("m", cl::aliasopt(MergeAST), cl::desc("Alias for -merge-ast")),
+  CacheAST("ast-cache", cl::cat(CompileCategory),
+    cl::desc("Cache Clang AST of sources and do not parse sources again if "
+             "they and files they include are unchanged when analysis is "
+             "repeated in the same process (for example, in a server "
+             "session), analysis itself is not reused, requires -merge-ast")),
   Output("o", cl::cat(CompileCategory), cl::value_desc("file"),
     cl::desc("Write output to <file>"), cl::Prefix),
   Language("x", cl::cat(CompileCategory), cl::value_desc("language"),
@@ -246,6 +268,10 @@ Options::Options() :
     cl::desc("Print results for a specified processing steps (comma separated list of steps)")),
   PrintFilename("print-filename", cl::cat(DebugCategory),
     cl::desc("Print only names of files instead of full paths")),
+  Profile("tsar-profile", cl::cat(DebugCategory), cl::value_desc("file"),
+    cl::desc("Write profile of analysis passes in Chrome trace format to <file>")),
+  MemoryReport("fmemory-report", cl::cat(DebugCategory),
+    cl::desc("Print memory held by results of analysis for each function and processing step")),
   AnalysisCategory("Analysis options"),
   Check("check", cl::cat(AnalysisCategory),
     cl::desc("Check user-defined properties")),
@@ -297,8 +323,48 @@ Options::Options() :
    cl::Hidden, cl::cat(AnalysisCategory),
     cl::desc("A function is only inlined if the number of memory "
              "accesses in the caller does not exceed this value")),
+  InlineStrategy("finline-strategy", cl::cat(AnalysisCategory),
+    cl::init(GlobalOptions::ISK_Inline),
+    cl::desc("Strategy to resolve calls which prevent dependence analysis"),
+    cl::values(clEnumValN(GlobalOptions::ISK_Inline, "inline",
+                  "Inline calls (default)"),
+               clEnumValN(GlobalOptions::ISK_Specialize, "specialize",
+                  "Redirect calls to clones of callees specialized for "
+                  "aliasing of arguments, inline the remaining calls"))),
   NoInline("fno-inline", cl::cat(AnalysisCategory),
     cl::desc("Do not inline function calls to decrease analysis time")),
+  AnalysisTimeLimit("analysis-time-limit", cl::init(0),
+    cl::cat(AnalysisCategory), cl::value_desc("seconds"),
+    cl::desc("Assume conservative dependencies in a function if its analysis "
+             "takes longer than a specified time (0 means no limit)")),
+  AnalysisQueryLimit("analysis-query-limit", cl::init(0),
+    cl::cat(AnalysisCategory), cl::value_desc("queries"),
+    cl::desc("Assume conservative dependencies in a loop if its analysis "
+             "requires more alias and dependence queries than a specified "
+             "number (0 means no limit)")),
+  RecursionIterationLimit("recursion-iteration-limit", cl::init(8),
+    cl::Hidden, cl::cat(AnalysisCategory), cl::value_desc("iterations"),
+    cl::desc("Assume conservative memory effects of recursive functions if "
+             "interprocedural analysis does not converge after a specified "
+             "number of iterations")),
+  DataFlowThreads("data-flow-threads", cl::init(0),
+    cl::Hidden, cl::cat(AnalysisCategory), cl::value_desc("threads"),
+    cl::desc("Solve data-flow problems for sibling loops concurrently using "
+             "a specified number of threads (0 means sequential solving)")),
+  SparseCallExtraction("sparse-call-extraction", cl::Hidden,
+    cl::cat(AnalysisCategory),
+    cl::desc("Extract into separate basic blocks only calls of functions "
+             "with bodies, other calls are kept in place")),
+  MaxMemory("max-memory", cl::init(0),
+    cl::cat(AnalysisCategory), cl::value_desc("megabytes"),
+    cl::desc("Release results of analysis of processed functions and assume "
+             "conservative dependencies if memory usage exceeds a specified "
+             "limit (0 means no limit), memory usage is the heap size if "
+             "mallinfo2() is available or the resident set size otherwise")),
+  StreamAnalysis("stream-analysis", cl::cat(AnalysisCategory),
+    cl::desc("Release results of each analysis step of a function as soon "
+             "as its output is emitted (results with locked traits are kept "
+             "for the next step)")),
   LoadSources("fload-sources", cl::cat(AnalysisCategory),
     cl::desc("Try to load higher level sources for an IR-level input (default)")),
   NoLoadSources("fno-load-sources", cl::cat(AnalysisCategory),
@@ -306,12 +372,22 @@ Options::Options() :
   AnalysisUse("fanalysis-use", cl::cat(AnalysisCategory),
     cl::value_desc("filename"),
     cl::desc("Use external analysis results to clarify analysis")),
+  FunctionSummaryUse("fsummary-use", cl::cat(AnalysisCategory),
+    cl::value_desc("filename"),
+    cl::desc("Use summaries of external functions to clarify analysis")),
+  FunctionSummaryEmit("fsummary-emit", cl::cat(AnalysisCategory),
+    cl::value_desc("filename"),
+    cl::desc("Store summaries of functions defined in sources")),
   OptRegion("foptimize-only", cl::cat(AnalysisCategory), cl::value_desc("regions"),
     cl::ZeroOrMore, cl::ValueRequired, cl::CommaSeparated,
     cl::desc("Allow optimization of specified regions (comma separated list of region names")),
   TransformCategory("Transformation options"),
   NoFormat("no-format", cl::cat(TransformCategory),
     cl::desc("Disable format of transformed sources")),
+  FormatThreads("format-threads", cl::init(0), cl::cat(TransformCategory),
+    cl::value_desc("threads"),
+    cl::desc("Number of threads to format transformed sources "
+             "(0 means all available hardware threads)")),
   OutputSuffix("output-suffix", cl::cat(TransformCategory), cl::value_desc("suffix"),
     cl::desc("Filename suffix (between name and extension) for transformed sources")) {
   StringMap<cl::Option*> &Opts = cl::getRegisteredOptions();
@@ -616,12 +692,31 @@ void Tool::storeCLOptions() {
   }
   mGlobalOpts.MemoryAccessInlineThreshold =
       Options::get().MemoryAccessInlineThreshold;
+  mGlobalOpts.InlineStrategy = Options::get().InlineStrategy;
+  mGlobalOpts.AnalysisTimeLimit = Options::get().AnalysisTimeLimit;
+  mGlobalOpts.AnalysisQueryLimit = Options::get().AnalysisQueryLimit;
+  mGlobalOpts.RecursionIterationLimit = Options::get().RecursionIterationLimit;
+  mGlobalOpts.DataFlowThreads = Options::get().DataFlowThreads;
+  mGlobalOpts.SparseCallExtraction = Options::get().SparseCallExtraction;
+  mGlobalOpts.MaxMemory = Options::get().MaxMemory;
+  mGlobalOpts.StreamAnalysis = Options::get().StreamAnalysis;
   mGlobalOpts.OptRegions = Options::get().OptRegion;
   mGlobalOpts.AnalysisUse = Options::get().AnalysisUse;
+  mGlobalOpts.FunctionSummaryUse = Options::get().FunctionSummaryUse;
+  mGlobalOpts.FunctionSummaryEmit = Options::get().FunctionSummaryEmit;
   mEmitAST = addLLIfSet(addIfSet(Options::get().EmitAST));
   mMergeAST = mEmitAST ?
     addLLIfSet(addIfSet(Options::get().MergeAST)) :
     addLLIfSet(Options::get().MergeAST);
+  if (addLLIfSet(addIfSet(Options::get().CacheAST))) {
+    if (!mMergeAST) {
+      std::string Msg("error - this option requires");
+      Msg.append(" -").append(Options::get().MergeAST.ArgStr.data());
+      Options::get().CacheAST.error(Msg);
+      exit(1);
+    }
+    mASTCache = std::make_unique<ASTCache>();
+  }
   mPrintAST = addLLIfSet(addIfSet(Options::get().PrintAST));
   mDumpAST = addLLIfSet(addIfSet(Options::get().DumpAST));
   mOutputPasses = Options::get().OutputPasses;
@@ -641,6 +736,8 @@ void Tool::storeCLOptions() {
     exit(1);
   }
   mOutputFilename = Options::get().Output;
+  mProfileFilename = Options::get().Profile;
+  mMemoryReport = Options::get().MemoryReport;
   storePrintOptions(IncompatibleOpts);
   mLanguage = Options::get().Language;
   /// TODO (kaniandr@gmail.com): allow to use -output-suffix option for
@@ -655,6 +752,7 @@ void Tool::storeCLOptions() {
     exit(1);
   }
   mGlobalOpts.NoFormat = addIfSetIf(Options::get().NoFormat, NoTfmPass);
+  mGlobalOpts.FormatThreads = Options::get().FormatThreads;
   mGlobalOpts.OutputSuffix = Options::get().OutputSuffix;
   if (NoTfmPass && !mGlobalOpts.OutputSuffix.empty()) {
     IncompatibleOpts.push_back(&Options::get().OutputSuffix);
@@ -684,6 +782,21 @@ void Tool::storeCLOptions() {
 }
 
 int Tool::run(QueryManager *QM) {
+  if (!mProfileFilename.empty())
+    initializeProfiler();
+  auto WriteProfile = make_scope_exit([this]() {
+    if (mProfileFilename.empty())
+      return;
+    if (auto E = writeProfile(mProfileFilename))
+      errs() << "error: unable to write profile: " << toString(std::move(E))
+             << "\n";
+  });
+  if (mMemoryReport)
+    initializeMemoryAccounting();
+  auto PrintMemoryReport = make_scope_exit([this]() {
+    if (mMemoryReport)
+      printMemoryReport(errs());
+  });
   std::vector<std::string> NoASTSources;
   std::vector<std::string> SourcesToMerge;
   std::vector<std::string> LLSources;
@@ -716,7 +829,11 @@ int Tool::run(QueryManager *QM) {
         Adjusted.push_back(Arg.str());
     }
     Adjusted.emplace_back("-o");
-    if (mOutputFilename.empty()) {
+    if (mASTCache && mOutputFilename.empty()) {
+      auto PCHFile = mASTCache->getASTFilename(Filename);
+      Adjusted.push_back(PCHFile);
+      SourcesToMerge.push_back(std::move(PCHFile));
+    } else if (mOutputFilename.empty()) {
       SmallString<128> PCHFile = Filename;
       sys::path::replace_extension(PCHFile, ".ast");
       Adjusted.push_back(std::string(PCHFile));
@@ -747,7 +864,34 @@ int Tool::run(QueryManager *QM) {
   // analysis. AST files will be stored in SourcesToMerge collection.
   // If an input file already contains Clang AST it will be pushed into
   // the SourcesToMerge collection only.
-  if (mMergeAST) {
+  // If AST files are cached only changed sources are parsed.
+  if (mASTCache) {
+    mASTCache->startRun();
+    std::vector<std::string> ChangedSources;
+    for (auto &Src : NoASTSources) {
+      auto ASTFile = mASTCache->lookup(Src);
+      if (ASTFile.empty())
+        ChangedSources.push_back(Src);
+      else
+        SourcesToMerge.push_back(std::move(ASTFile));
+    }
+    ClangTool EmitChangedTool(*mCompilations, ChangedSources);
+    EmitChangedTool.appendArgumentsAdjuster(ArgumentsAdjuster);
+    auto EmitResult = EmitChangedTool.run(
+        newActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
+    for (auto &Src : ChangedSources) {
+      if (mASTCache->insert(Src))
+        continue;
+      // Do not merge an AST file for a source which has not been parsed.
+      auto Itr = llvm::find(SourcesToMerge, mASTCache->getASTFilename(Src));
+      if (Itr != SourcesToMerge.end())
+        SourcesToMerge.erase(Itr);
+    }
+    if (EmitResult != 0) {
+      errs() << "error: unable to emit Clang AST for changed sources\n";
+      return EmitResult;
+    }
+  } else if (mMergeAST) {
     EmitPCHTool.run(
         newActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
   }
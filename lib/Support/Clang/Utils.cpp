@@ -418,9 +418,14 @@ std::vector<llvm::StringRef> tsar::buildDeclStringRef(llvm::StringRef Type,
 }
 
 Expected<std::string> tsar::reformat(StringRef TfmSrc, StringRef Filename) {
+  clang::tooling::Range All(0, TfmSrc.size());
+  return reformat(TfmSrc, Filename, All);
+}
+
+Expected<std::string> tsar::reformat(StringRef TfmSrc, StringRef Filename,
+    ArrayRef<clang::tooling::Range> Ranges) {
   using namespace clang::format;
   using namespace clang::tooling;
-  std::vector<Range> Ranges({ Range(0, TfmSrc.size()) });
   auto Style = format::getStyle("LLVM", "", "LLVM");
   if (auto Err = Style.takeError())
     return std::move(Err);
@@ -0,0 +1,351 @@
+//===- MemoryAccounting.cpp - Memory Footprint of Analysis ------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements functions to account memory which is held by results
+// of analysis passes, a pass which bounds memory usage and a pass which
+// releases results of analysis of processed functions in a streaming mode.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Support/MemoryAccounting.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/Profiler.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+# define TSAR_HAS_MALLINFO2
+# include <malloc.h>
+#elif defined(LLVM_ON_UNIX)
+# include <sys/resource.h>
+#endif
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "memory-limit"
+
+STATISTIC(NumReleasedFunctions,
+  "Number of functions which analysis results have been released");
+STATISTIC(NumExceededFunctions,
+  "Number of functions analyzed after memory limit has been exceeded");
+STATISTIC(NumFinishedFunctions,
+  "Number of functions which results have been released after analysis");
+STATISTIC(NumProcessedFunctions,
+  "Number of functions which results have been released after a step");
+
+namespace {
+/// Map from a name of a structure to a number of bytes.
+using StructureMap = StringMap<uint64_t>;
+
+/// Memory accounted in a processing step of the analysis pipeline.
+struct StepInfo {
+  std::string Name;
+  StructureMap Bytes;
+  uint64_t MemoryPeak = 0;
+};
+
+struct AccountingInfo {
+  bool IsEnabled = false;
+  std::vector<StepInfo> Steps;
+  /// For each function the largest size of each structure over all steps.
+  StringMap<StructureMap> Functions;
+  std::vector<std::pair<const void *, MemoryReleaser>> Releasers;
+};
+
+AccountingInfo & getAccountingInfo() {
+  static AccountingInfo Info;
+  return Info;
+}
+
+/// Print a number of bytes in human readable form.
+void printBytes(raw_ostream &OS, uint64_t Bytes) {
+  if (Bytes >= (1u << 20))
+    OS << format("%.1f MiB", double(Bytes) / (1u << 20));
+  else if (Bytes >= (1u << 10))
+    OS << format("%.1f KiB", double(Bytes) / (1u << 10));
+  else
+    OS << Bytes << " B";
+}
+
+void printStructures(raw_ostream &OS, const StructureMap &Bytes) {
+  std::vector<std::pair<StringRef, uint64_t>> Sorted;
+  for (auto &S : Bytes)
+    Sorted.emplace_back(S.getKey(), S.getValue());
+  llvm::sort(Sorted);
+  for (auto &S : Sorted) {
+    OS << "    " << left_justify(S.first, 20) << " ";
+    printBytes(OS, S.second);
+    OS << "\n";
+  }
+}
+
+uint64_t getTotal(const StructureMap &Bytes) {
+  uint64_t Total = 0;
+  for (auto &S : Bytes)
+    Total += S.getValue();
+  return Total;
+}
+
+class MemoryLimitPass : public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  MemoryLimitPass() : FunctionPass(ID) {
+    initializeMemoryLimitPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    auto *GO = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (!GO || GO->getOptions().MaxMemory == 0)
+      return false;
+    uint64_t Limit = uint64_t(GO->getOptions().MaxMemory) << 20;
+    if (!isMemoryLimitExceeded(Limit))
+      return false;
+    LLVM_DEBUG(dbgs() << "[MEMORY LIMIT]: memory usage " << getMemoryUsage()
+                      << " exceeds limit " << Limit << " before analysis of "
+                      << F.getName() << "\n");
+    tsar::releaseMemory(Limit, F);
+    if (isMemoryLimitExceeded(Limit))
+      ++NumExceededFunctions;
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+};
+
+/// This pass releases results of the current processing step of a function
+/// after the function has been processed at this step, so these results are
+/// not accumulated over the whole module.
+class FunctionReleasePass : public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  explicit FunctionReleasePass(bool IsLastStep = true)
+      : FunctionPass(ID), mIsLastStep(IsLastStep) {
+    initializeFunctionReleasePassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    auto *GO = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (!GO || !GO->getOptions().StreamAnalysis)
+      return false;
+    if (releaseProcessedFunction(F, mIsLastStep)) {
+      if (mIsLastStep)
+        ++NumFinishedFunctions;
+      else
+        ++NumProcessedFunctions;
+    }
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  bool mIsLastStep;
+};
+}
+
+char MemoryLimitPass::ID = 0;
+INITIALIZE_PASS(MemoryLimitPass, "memory-limit", "Memory Usage Limit", true,
+                true)
+
+FunctionPass *llvm::createMemoryLimitPass() { return new MemoryLimitPass; }
+
+char FunctionReleasePass::ID = 0;
+INITIALIZE_PASS(FunctionReleasePass, "function-release",
+                "Release Results Of Processed Function", true, true)
+
+FunctionPass *llvm::createFunctionReleasePass(bool IsLastStep) {
+  return new FunctionReleasePass(IsLastStep);
+}
+
+void tsar::initializeMemoryAccounting() {
+  getAccountingInfo().IsEnabled = true;
+}
+
+bool tsar::isMemoryAccountingEnabled() {
+  return getAccountingInfo().IsEnabled;
+}
+
+void tsar::trackMemoryUsage(StringRef Structure, const Function &F,
+                            uint64_t Bytes) {
+  if (isProfilerEnabled())
+    addProfileCounter(("memory: " + Structure).str(), F, Bytes);
+  auto &Info = getAccountingInfo();
+  if (!Info.IsEnabled)
+    return;
+  if (Info.Steps.empty()) {
+    Info.Steps.emplace_back();
+    Info.Steps.back().Name = "Initial";
+  }
+  auto &Step = Info.Steps.back();
+  Step.Bytes[Structure] += Bytes;
+  Step.MemoryPeak = std::max<uint64_t>(Step.MemoryPeak, getMemoryUsage());
+  auto &Max = Info.Functions[F.getName()][Structure];
+  Max = std::max(Max, Bytes);
+}
+
+void tsar::startMemoryStep(StringRef Name) {
+  auto &Info = getAccountingInfo();
+  if (!Info.IsEnabled || Name.empty())
+    return;
+  Info.Steps.emplace_back();
+  Info.Steps.back().Name = Name.str();
+}
+
+void tsar::printMemoryReport(raw_ostream &OS) {
+  auto &Info = getAccountingInfo();
+  if (!Info.IsEnabled)
+    return;
+  OS << "===" << std::string(73, '-') << "===\n";
+  OS << "                 Memory held by results of analysis\n";
+  OS << "===" << std::string(73, '-') << "===\n";
+  for (auto &Step : Info.Steps) {
+    if (Step.Bytes.empty())
+      continue;
+    OS << "  Step " << Step.Name << ": ";
+    printBytes(OS, getTotal(Step.Bytes));
+    OS << " (peak usage of the process ";
+    printBytes(OS, Step.MemoryPeak);
+    OS << ")\n";
+    printStructures(OS, Step.Bytes);
+  }
+  std::vector<std::pair<uint64_t, StringRef>> Functions;
+  for (auto &F : Info.Functions)
+    Functions.emplace_back(getTotal(F.getValue()), F.getKey());
+  llvm::sort(Functions, [](const auto &LHS, const auto &RHS) {
+    return LHS.first > RHS.first ||
+           (LHS.first == RHS.first && LHS.second < RHS.second);
+  });
+  for (auto &F : Functions) {
+    OS << "  Function " << F.second << ": ";
+    printBytes(OS, F.first);
+    OS << "\n";
+    printStructures(OS, Info.Functions[F.second]);
+  }
+  Info.Steps.clear();
+  Info.Functions.clear();
+}
+
+uint64_t tsar::getMemoryUsage() {
+#ifdef TSAR_HAS_MALLINFO2
+  // Fields of mallinfo() which is used in sys::Process::GetMallocUsage()
+  // (prior to LLVM 13) are 'int', so they wrap around above 2 GiB.
+  // Large blocks are allocated with mmap(), so they are accounted separately.
+  auto Info = ::mallinfo2();
+  return Info.uordblks + Info.hblkhd;
+#else
+# ifdef __linux__
+  // The second field in /proc/self/statm is a number of resident pages.
+  if (auto Buffer = MemoryBuffer::getFileAsStream("/proc/self/statm")) {
+    SmallVector<StringRef, 7> Fields;
+    (*Buffer)->getBuffer().split(Fields, ' ', -1, false);
+    uint64_t NumPages = 0;
+    if (Fields.size() > 1 && !Fields[1].getAsInteger(10, NumPages))
+      return NumPages * sys::Process::getPageSizeEstimate();
+  }
+# endif
+# ifdef LLVM_ON_UNIX
+  // Peak resident set size is the best available estimate.
+  struct rusage Usage;
+  if (::getrusage(RUSAGE_SELF, &Usage) == 0)
+#  ifdef __APPLE__
+    return Usage.ru_maxrss;
+#  else
+    return static_cast<uint64_t>(Usage.ru_maxrss) * 1024;
+#  endif
+# endif
+  return sys::Process::GetMallocUsage();
+#endif
+}
+
+bool tsar::isMemoryLimitExceeded(uint64_t Limit) {
+  return Limit > 0 && getMemoryUsage() > Limit;
+}
+
+void tsar::registerMemoryReleaser(const void *Owner, MemoryReleaser Releaser) {
+  getAccountingInfo().Releasers.emplace_back(Owner, std::move(Releaser));
+}
+
+void tsar::unregisterMemoryReleaser(const void *Owner) {
+  auto &Releasers = getAccountingInfo().Releasers;
+  Releasers.erase(
+      std::remove_if(Releasers.begin(), Releasers.end(),
+                     [Owner](const auto &R) { return R.first == Owner; }),
+      Releasers.end());
+}
+
+unsigned tsar::releaseMemory(uint64_t Limit, Function &Current) {
+  auto &Releasers = getAccountingInfo().Releasers;
+  if (Releasers.empty())
+    return 0;
+  auto &M = *Current.getParent();
+  unsigned NumReleased = 0;
+  auto release = [&Releasers, &NumReleased](Function &F) {
+    bool IsReleased = false;
+    for (auto &R : Releasers)
+      IsReleased |= R.second(F, false);
+    if (IsReleased) {
+      LLVM_DEBUG(dbgs() << "[MEMORY LIMIT]: release results for "
+                        << F.getName() << "\n");
+      ++NumReleased;
+      ++NumReleasedFunctions;
+    }
+  };
+  for (auto I = std::next(Current.getIterator()), EI = M.end(); I != EI; ++I) {
+    if (!isMemoryLimitExceeded(Limit))
+      return NumReleased;
+    release(*I);
+  }
+  return NumReleased;
+}
+
+bool tsar::releaseProcessedFunction(Function &F, bool IsFinished) {
+  bool IsReleased = false;
+  for (auto &R : getAccountingInfo().Releasers)
+    IsReleased |= R.second(F, IsFinished);
+  if (IsReleased)
+    LLVM_DEBUG(dbgs() << "[MEMORY LIMIT]: release results for "
+                      << (IsFinished ? "finished" : "processed")
+                      << " function " << F.getName() << "\n");
+  return IsReleased;
+}
@@ -0,0 +1,250 @@
+//===--- Profiler.cpp ----- Analysis Profiler -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements functions to collect a profile of analysis and
+// transformation passes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Support/Profiler.h"
+#include "tsar/Support/MemoryAccounting.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+using ClockType = std::chrono::steady_clock;
+using TimePointType = ClockType::time_point;
+
+/// Processing step of the analysis pipeline.
+struct StepEvent {
+  std::string Name;
+  TimePointType Start;
+  TimePointType End;
+  std::size_t MemoryStart;
+  std::size_t MemoryEnd;
+};
+
+/// Value of a counter reported for a function.
+struct CounterEvent {
+  std::string Name;
+  std::string Function;
+  TimePointType Time;
+  uint64_t Value;
+};
+
+/// Task executed in some thread.
+struct TaskEvent {
+  std::string Name;
+  std::string Detail;
+  TimePointType Start;
+  TimePointType End;
+  uint64_t ThreadId;
+};
+
+struct ProfileInfo {
+  bool IsEnabled = false;
+  /// True if LLVM time trace profiler has been initialized by this profiler.
+  bool OwnsTimeTrace = false;
+  TimePointType Start;
+  std::vector<StepEvent> Steps;
+  bool IsStepActive = false;
+  std::vector<CounterEvent> Counters;
+  std::vector<TaskEvent> Tasks;
+};
+
+ProfileInfo & getProfileInfo() {
+  static ProfileInfo Info;
+  return Info;
+}
+
+int64_t toMicroseconds(TimePointType Start, TimePointType T) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(T - Start)
+      .count();
+}
+
+void finishStep(ProfileInfo &Info) {
+  if (!Info.IsStepActive)
+    return;
+  Info.Steps.back().End = ClockType::now();
+  Info.Steps.back().MemoryEnd = sys::Process::GetMallocUsage();
+  Info.IsStepActive = false;
+}
+
+void startStep(ProfileInfo &Info, StringRef Name) {
+  finishStep(Info);
+  if (Name.empty())
+    return;
+  Info.Steps.emplace_back();
+  Info.Steps.back().Name = Name.str();
+  Info.Steps.back().MemoryStart = sys::Process::GetMallocUsage();
+  Info.Steps.back().Start = ClockType::now();
+  Info.IsStepActive = true;
+}
+
+class ProfileStepPass : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ProfileStepPass() : ModulePass(ID) {
+    initializeProfileStepPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  explicit ProfileStepPass(StringRef Name) : ModulePass(ID), mName(Name) {
+    initializeProfileStepPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override {
+    auto &Info = getProfileInfo();
+    if (Info.IsEnabled)
+      startStep(Info, mName);
+    startMemoryStep(mName);
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mName;
+};
+}
+
+char ProfileStepPass::ID = 0;
+INITIALIZE_PASS(ProfileStepPass, "profile-step", "Profile Processing Step",
+                true, true)
+
+ModulePass *llvm::createProfileStepPass(StringRef Name) {
+  return new ProfileStepPass(Name);
+}
+
+void tsar::initializeProfiler() {
+  auto &Info = getProfileInfo();
+  if (Info.IsEnabled)
+    return;
+  // Record each pass invocation, so granularity is zero.
+  if (!timeTraceProfilerEnabled()) {
+    timeTraceProfilerInitialize(0, "tsar");
+    Info.OwnsTimeTrace = true;
+  }
+  Info.IsEnabled = true;
+  Info.Start = ClockType::now();
+}
+
+bool tsar::isProfilerEnabled() { return getProfileInfo().IsEnabled; }
+
+void tsar::addProfileCounter(StringRef Name, const Function &F,
+                             uint64_t Value) {
+  auto &Info = getProfileInfo();
+  if (!Info.IsEnabled)
+    return;
+  Info.Counters.push_back(
+      CounterEvent{Name.str(), F.getName().str(), ClockType::now(), Value});
+}
+
+void tsar::addProfileTask(StringRef Name, StringRef Detail,
+                          TimePointType Start, TimePointType End,
+                          uint64_t ThreadId) {
+  auto &Info = getProfileInfo();
+  if (!Info.IsEnabled)
+    return;
+  Info.Tasks.push_back(
+      TaskEvent{Name.str(), Detail.str(), Start, End, ThreadId});
+}
+
+Error tsar::writeProfile(StringRef Path) {
+  auto &Info = getProfileInfo();
+  if (!Info.IsEnabled)
+    return Error::success();
+  finishStep(Info);
+  SmallString<1024> Buffer;
+  raw_svector_ostream BufferOS(Buffer);
+  timeTraceProfilerWrite(BufferOS);
+  if (Info.OwnsTimeTrace)
+    timeTraceProfilerCleanup();
+  Info.OwnsTimeTrace = false;
+  Info.IsEnabled = false;
+  auto Trace = json::parse(Buffer);
+  if (!Trace)
+    return Trace.takeError();
+  auto *Events = Trace->getAsObject()
+                     ? Trace->getAsObject()->getArray("traceEvents")
+                     : nullptr;
+  if (!Events)
+    return createStringError(std::errc::invalid_argument,
+                             "list of trace events is not available");
+  int64_t Tid = get_threadid();
+  for (auto &Step : Info.Steps) {
+    auto Dur = toMicroseconds(Step.Start, Step.End);
+    Events->push_back(json::Object{
+        {"pid", 1},
+        {"tid", Tid},
+        {"ph", "X"},
+        {"ts", toMicroseconds(Info.Start, Step.Start)},
+        {"dur", Dur},
+        {"name", "Step"},
+        {"args",
+         json::Object{{"detail", Step.Name},
+                      {"memory delta",
+                       int64_t(Step.MemoryEnd) - int64_t(Step.MemoryStart)}}}});
+  }
+  for (auto &Counter : Info.Counters)
+    Events->push_back(json::Object{
+        {"pid", 1},
+        {"tid", Tid},
+        {"ph", "i"},
+        {"s", "t"},
+        {"ts", toMicroseconds(Info.Start, Counter.Time)},
+        {"name", Counter.Name},
+        {"args", json::Object{{"detail", Counter.Function},
+                              {"value", int64_t(Counter.Value)}}}});
+  for (auto &Task : Info.Tasks)
+    Events->push_back(json::Object{
+        {"pid", 1},
+        {"tid", int64_t(Task.ThreadId)},
+        {"ph", "X"},
+        {"ts", toMicroseconds(Info.Start, Task.Start)},
+        {"dur", toMicroseconds(Task.Start, Task.End)},
+        {"name", Task.Name},
+        {"args", json::Object{{"detail", Task.Detail}}}});
+  Info.Steps.clear();
+  Info.Counters.clear();
+  Info.Tasks.clear();
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::OF_Text);
+  if (EC)
+    return createFileError(Path, EC);
+  OS << *Trace << '\n';
+  return Error::success();
+}
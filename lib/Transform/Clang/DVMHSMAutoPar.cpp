@@ -24,14 +24,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "SharedMemoryAutoPar.h"
+#include "tsar/ADT/DataFlow.h"
 #include "tsar/Analysis/DFRegionInfo.h"
 #include "tsar/Analysis/Clang/ASTDependenceAnalysis.h"
 #include "tsar/Analysis/Clang/CanonicalLoop.h"
 #include "tsar/Analysis/Clang/LoopMatcher.h"
 #include "tsar/Analysis/Clang/PerfectLoop.h"
 #include "tsar/Analysis/Clang/Utils.h"
+#include "tsar/Analysis/KnownFunctionTraits.h"
 #include "tsar/Analysis/Memory/DIArrayAccess.h"
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
+#include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Analysis/Passes.h"
 #include "tsar/Analysis/Parallel/Passes.h"
 #include "tsar/Analysis/Parallel/Parallellelization.h"
@@ -41,9 +44,17 @@
 #include "tsar/Frontend/Clang/TransformationContext.h"
 #include "tsar/Support/Clang/Diagnostic.h"
 #include "tsar/Support/Clang/Utils.h"
+#include "tsar/Support/MetadataUtils.h"
 #include "tsar/Transform/Clang/Passes.h"
 #include <clang/AST/ParentMapContext.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/CaptureTracking.h>
 #include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 
 using namespace clang;
 using namespace llvm;
@@ -52,6 +63,8 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "clang-dvmh-sm-parallel"
 
+STATISTIC(NumTransfersRemoved, "Number of removed redundant data transfers");
+
 namespace {
 class PragmaRegion : public ParallelLevel {
 public:
@@ -185,6 +198,10 @@ private:
   void optimizeLevel(PointerUnion<Loop *, Function *> Level,
     const FunctionAnalysis &Provider) override;
 
+  /// Remove redundant actualization directives and hoist them out of loops
+  /// if possible.
+  void optimizeDataTransfers(Function &F, const FunctionAnalysis &Provider);
+
   Parallelization mParallelizationInfo;
 };
 
@@ -662,6 +679,664 @@ void ClangDVMHSMParallelization::optimizeLevel(
   }
 }
 
+namespace {
+/// Set of variables mentioned in actualization directives, each variable is
+/// identified by a bit number.
+using VariableSet = BitVector;
+
+/// Return size of a variable in bytes if it is known.
+Optional<uint64_t> getVariableSize(const DIVariable &Var) {
+  auto *Ty = stripDIType(Var.getType());
+  if (!Ty || Ty->getTag() == dwarf::DW_TAG_pointer_type ||
+      Ty->getSizeInBits() == 0)
+    return None;
+  return tsar::getSize(Ty);
+}
+
+/// This summarizes information which is necessary to place actualization
+/// directives in a function.
+///
+/// Variables are identified by their metadata-level descriptions. A name in
+/// a directive is resolved to a variable which is visible at the beginning of
+/// the loop the directive is attached to, so variables with the same name from
+/// different scopes are distinguished.
+class TransferInfo : private bcl::Uncopyable {
+public:
+  /// Variables which may be accessed in host code.
+  struct HostAccess {
+    VariableSet Read;
+    VariableSet Write;
+  };
+
+  TransferInfo(Function &F, const FunctionAnalysis &Provider,
+               Parallelization &ParallelizationInfo);
+
+  unsigned getNumVars() const noexcept { return mVars.size(); }
+
+  /// Return size of a variable in bytes if it is known.
+  Optional<uint64_t> getSize(unsigned Id) const {
+    return getVariableSize(*mVars[Id]);
+  }
+
+  /// Return identifier of a variable with a specified name which is visible
+  /// at the beginning of a specified loop or None if it is not known.
+  Optional<unsigned> getId(StringRef Name, const Loop *L) const {
+    auto I = mVarIds.find(findVariable(Name, L));
+    if (I == mVarIds.end())
+      return None;
+    return I->second;
+  }
+
+  /// Return variables from a directive which is attached to a specified loop.
+  VariableSet toSet(const Loop *L,
+                    const PragmaActual::SortedVarListT &Vars) const {
+    VariableSet Set(getNumVars());
+    for (auto &Var : Vars)
+      if (auto Id = getId(Var, L))
+        Set.set(*Id);
+    return Set;
+  }
+
+  /// Return true if a specified loop is executed inside a DVMH region.
+  bool isDevice(const Loop *L) const { return mDeviceLoops.count(L); }
+
+  const HostAccess &getHostAccess(const BasicBlock *BB) const {
+    auto I = mBlockAccess.find(BB);
+    return I != mBlockAccess.end() ? I->second : mNoAccess;
+  }
+
+  const HostAccess &getHostAccess(const Loop *L) const {
+    auto I = mLoopAccess.find(L);
+    return I != mLoopAccess.end() ? I->second : mNoAccess;
+  }
+
+  /// Return 'actual' directive which is executed before a specified loop.
+  PragmaActual *getActual(const Loop *L) const {
+    if (!L->getLoopID())
+      return nullptr;
+    return mParallelizationInfo
+        .find<PragmaActual>(L->getHeader(), L->getLoopID(), true)
+        .dyn_cast();
+  }
+
+  /// Return 'get_actual' directive which is executed after a specified loop.
+  PragmaGetActual *getGetActual(const Loop *L) const {
+    if (!L->getLoopID() || !L->getExitingBlock())
+      return nullptr;
+    return mParallelizationInfo
+        .find<PragmaGetActual>(L->getExitingBlock(), L->getLoopID(), false)
+        .dyn_cast();
+  }
+
+  /// Return 'actual' directive which is executed before a specified loop,
+  /// create a new one if it does not exist.
+  PragmaActual &getOrCreateActual(Loop *L) {
+    if (auto *A = getActual(L))
+      return *A;
+    auto &PB = getOrCreateLocation(L->getHeader(), L->getLoopID()).Entry;
+    PB.insert(PB.begin(), std::make_unique<PragmaActual>());
+    return cast<PragmaActual>(*PB.front());
+  }
+
+  /// Return 'get_actual' directive which is executed after a specified loop,
+  /// create a new one if it does not exist.
+  PragmaGetActual &getOrCreateGetActual(Loop *L) {
+    if (auto *GA = getGetActual(L))
+      return *GA;
+    auto &PB = getOrCreateLocation(L->getExitingBlock(), L->getLoopID()).Exit;
+    PB.push_back(std::make_unique<PragmaGetActual>());
+    return cast<PragmaGetActual>(*PB.back());
+  }
+
+  /// Return variables from all 'actual' directives inside a specified loop.
+  VariableSet getInnerActual(const Loop *L) const {
+    VariableSet Set(getNumVars());
+    for (auto *Inner : L->getLoopsInPreorder())
+      if (Inner != L)
+        if (auto *A = getActual(Inner))
+          Set |= toSet(Inner, A->getMemory());
+    return Set;
+  }
+
+private:
+  ParallelLocation &getOrCreateLocation(BasicBlock *BB, ObjectID ID) {
+    auto &PLs = mParallelizationInfo.try_emplace(BB).first->
+        template get<ParallelLocation>();
+    auto PLItr = find_if(PLs, [ID](ParallelLocation &PL) {
+      return PL.Anchor.is<MDNode *>() && PL.Anchor.get<MDNode *>() == ID;
+    });
+    if (PLItr != PLs.end())
+      return *PLItr;
+    PLs.emplace_back();
+    PLs.back().Anchor = ID;
+    return PLs.back();
+  }
+
+  void addCandidate(const DIVariable *Var) {
+    auto &Candidates = mCandidates[Var->getName()];
+    if (!is_contained(Candidates, Var))
+      Candidates.push_back(Var);
+  }
+
+  void addVariables(const Loop *L, const PragmaActual::SortedVarListT &Vars) {
+    for (auto &Name : Vars)
+      if (auto *Var = findVariable(Name, L))
+        if (mVarIds.try_emplace(Var, mVars.size()).second)
+          mVars.push_back(Var);
+  }
+
+  /// Return a variable with a specified name which is visible at
+  /// the beginning of a specified loop or nullptr if it is not known.
+  const DIVariable *findVariable(StringRef Name, const Loop *L) const;
+
+  /// Return true if memory of a specified object may be accessed via pointers.
+  bool mayBeReferenced(const Value *Obj);
+
+  void collectHostAccess(BasicBlock &BB, HostAccess &Access);
+
+  Parallelization &mParallelizationInfo;
+  StringMap<SmallVector<const DIVariable *, 1>> mCandidates;
+  DenseMap<const DIVariable *, unsigned> mVarIds;
+  std::vector<const DIVariable *> mVars;
+  /// Variables which contain pointers to transferred memory.
+  VariableSet mPointers;
+  /// Variables which memory may be accessed via pointers.
+  VariableSet mMayBePointee;
+  DenseMap<const Value *, bool> mIsReferenced;
+  SmallPtrSet<const Loop *, 16> mDeviceLoops;
+  DenseMap<const BasicBlock *, HostAccess> mBlockAccess;
+  DenseMap<const Loop *, HostAccess> mLoopAccess;
+  HostAccess mNoAccess;
+};
+
+/// Source-level variable which is accessed in a host code.
+struct AccessedVariable {
+  const DIVariable *Var;
+  const Value *Storage;
+  /// True if memory is accessed via a pointer which is stored in a variable.
+  bool IsIndirect;
+};
+
+/// Return a source-level variable which is accessed via a specified pointer,
+/// or None if it is not known.
+Optional<AccessedVariable> getAccessedVariable(Value *Ptr) {
+  auto *Obj = getUnderlyingObject(Ptr, 0);
+  bool IsIndirect = false;
+  // Elements of an array which is referenced via a pointer are accessed
+  // through the value of this pointer, so look for the pointer variable.
+  if (auto *LI = dyn_cast<LoadInst>(Obj)) {
+    Obj = getUnderlyingObject(LI->getPointerOperand(), 0);
+    IsIndirect = true;
+  }
+  SmallVector<DIMemoryLocation, 1> DILocs;
+  if (auto *GV = dyn_cast<GlobalVariable>(Obj)) {
+    if (findGlobalMetadata(GV, DILocs))
+      return AccessedVariable{DILocs.front().Var, Obj, IsIndirect};
+  } else if (isa<AllocaInst>(Obj)) {
+    if (auto DILoc =
+            findMetadata(Obj, DILocs, nullptr, MDSearch::AddressOfVariable))
+      return AccessedVariable{DILoc->Var, Obj, IsIndirect};
+  }
+  return None;
+}
+
+TransferInfo::TransferInfo(Function &F, const FunctionAnalysis &Provider,
+                           Parallelization &ParallelizationInfo)
+    : mParallelizationInfo(ParallelizationInfo) {
+  for (auto &GV : F.getParent()->globals()) {
+    SmallVector<DIMemoryLocation, 1> DILocs;
+    if (findGlobalMetadata(&GV, DILocs))
+      addCandidate(DILocs.front().Var);
+  }
+  for (auto &I : instructions(F))
+    if (auto *DVI = dyn_cast<DbgVariableIntrinsic>(&I))
+      addCandidate(DVI->getVariable());
+  auto &LI = Provider.value<LoopInfoWrapperPass *>()->getLoopInfo();
+  for (auto *L : LI.getLoopsInPreorder()) {
+    if (isDevice(L))
+      continue;
+    if (auto *DVMHParallel = isParallel(L, mParallelizationInfo))
+      if (isa_and_nonnull<PragmaRegion>(DVMHParallel->getParent()))
+        for (auto *Inner : L->getLoopsInPreorder())
+          mDeviceLoops.insert(Inner);
+    if (auto *A = getActual(L))
+      addVariables(L, A->getMemory());
+    if (auto *GA = getGetActual(L))
+      addVariables(L, GA->getMemory());
+  }
+  mNoAccess.Read.resize(getNumVars());
+  mNoAccess.Write.resize(getNumVars());
+  if (getNumVars() == 0)
+    return;
+  // Global variables, local variables which address may be taken and
+  // variables without known storage may be accessed via pointers.
+  mPointers.resize(getNumVars());
+  mMayBePointee.resize(getNumVars(), true);
+  for (unsigned Id = 0, EId = getNumVars(); Id < EId; ++Id) {
+    auto *Ty = stripDIType(mVars[Id]->getType());
+    if (!Ty || Ty->getTag() == dwarf::DW_TAG_pointer_type)
+      mPointers.set(Id);
+  }
+  VariableSet HasCapturedStorage(getNumVars());
+  for (auto &I : F.getEntryBlock())
+    if (auto *AI = dyn_cast<AllocaInst>(&I)) {
+      SmallVector<DIMemoryLocation, 1> DILocs;
+      auto DILoc =
+          findMetadata(AI, DILocs, nullptr, MDSearch::AddressOfVariable);
+      auto IdItr = DILoc ? mVarIds.find(DILoc->Var) : mVarIds.end();
+      if (IdItr == mVarIds.end())
+        continue;
+      if (mayBeReferenced(AI))
+        HasCapturedStorage.set(IdItr->second);
+      else
+        mMayBePointee.reset(IdItr->second);
+    }
+  for (unsigned Id = 0, EId = getNumVars(); Id < EId; ++Id)
+    if (isa<DIGlobalVariable>(mVars[Id]))
+      mMayBePointee.set(Id);
+  mMayBePointee |= HasCapturedStorage;
+  for (auto &BB : F) {
+    auto *L = LI.getLoopFor(&BB);
+    if (L && isDevice(L))
+      continue;
+    auto &Access = mBlockAccess.try_emplace(&BB, mNoAccess).first->second;
+    collectHostAccess(BB, Access);
+    for (; L; L = L->getParentLoop()) {
+      auto &LoopAccess = mLoopAccess.try_emplace(L, mNoAccess).first->second;
+      LoopAccess.Read |= Access.Read;
+      LoopAccess.Write |= Access.Write;
+    }
+  }
+}
+
+const DIVariable *TransferInfo::findVariable(StringRef Name,
+                                             const Loop *L) const {
+  auto CandidateItr = mCandidates.find(Name);
+  if (CandidateItr == mCandidates.end())
+    return nullptr;
+  // Look for the innermost local variable which is declared before the loop.
+  auto Loc = L->getStartLoc();
+  for (DILocalScope *Scope = Loc ? Loc->getScope() : nullptr; Scope;
+       Scope = isa<DILexicalBlockBase>(Scope)
+                   ? cast<DILexicalBlockBase>(Scope)->getScope()
+                   : nullptr)
+    for (auto *Var : CandidateItr->second)
+      if (auto *LV = dyn_cast<DILocalVariable>(Var))
+        if (LV->getScope() == Scope &&
+            (LV->isParameter() || LV->getLine() == 0 ||
+             LV->getLine() <= Loc.getLine()))
+          return LV;
+  // Global variables with the same name may come from different translation
+  // units, conservatively ignore them.
+  const DIVariable *Global = nullptr;
+  for (auto *Var : CandidateItr->second)
+    if (isa<DIGlobalVariable>(Var)) {
+      if (Global)
+        return nullptr;
+      Global = Var;
+    }
+  return Global;
+}
+
+bool TransferInfo::mayBeReferenced(const Value *Obj) {
+  if (!isa<AllocaInst>(Obj))
+    return true;
+  auto Itr = mIsReferenced.try_emplace(Obj, false);
+  if (Itr.second)
+    Itr.first->second = PointerMayBeCaptured(Obj, true, true);
+  return Itr.first->second;
+}
+
+void TransferInfo::collectHostAccess(BasicBlock &BB, HostAccess &Access) {
+  for (auto &I : BB) {
+    if (auto *Call = dyn_cast<CallBase>(&I)) {
+      if (isDbgInfoIntrinsic(Call->getIntrinsicID()) ||
+          isMemoryMarkerIntrinsic(Call->getIntrinsicID()) ||
+          Call->doesNotAccessMemory())
+        continue;
+      Access.Read.set();
+      if (!Call->onlyReadsMemory())
+        Access.Write.set();
+      continue;
+    }
+    if (!I.mayReadOrWriteMemory())
+      continue;
+    Optional<AccessedVariable> Accessed;
+    if (auto *Ptr = getLoadStorePointerOperand(&I))
+      Accessed = getAccessedVariable(Ptr);
+    auto &Set = isa<LoadInst>(I) ? Access.Read : Access.Write;
+    // An access which can not be bound to a variable may access any memory.
+    if (!Accessed) {
+      Set.set();
+      continue;
+    }
+    auto IdItr = mVarIds.find(Accessed->Var);
+    if (IdItr != mVarIds.end())
+      Set.set(IdItr->second);
+    if (Accessed->IsIndirect) {
+      // Memory which is referenced via a pointer may be referenced via other
+      // pointers or it may be memory of a variable which address is taken.
+      Set |= mPointers;
+      Set |= mMayBePointee;
+    } else if (mayBeReferenced(Accessed->Storage)) {
+      // Storage of a variable may be referenced via some pointer.
+      Set |= mPointers;
+    }
+  }
+}
+
+/// Results of data-flow analyses which determine redundant transfers.
+struct TransferDFResults {
+  /// Variables which may be modified on host before an 'actual' directive
+  /// (the directive is attached to the loop in the pair).
+  DenseMap<PragmaActual *, std::pair<const Loop *, VariableSet>> ActualIn;
+  /// Variables which may be accessed on host after a 'get_actual' directive
+  /// (the directive is attached to the loop in the pair).
+  DenseMap<PragmaGetActual *, std::pair<const Loop *, VariableSet>>
+      GetActualOut;
+};
+
+/// Data-flow framework to find variables which may be modified on host since
+/// the last 'actual' directive.
+class HostWriteDFFwk : private bcl::Uncopyable {
+public:
+  HostWriteDFFwk(const TransferInfo &Info, TransferDFResults &Results,
+                 VariableSet Boundary)
+      : mInfo(Info), mResults(Results), mBoundary(std::move(Boundary)) {}
+
+  const TransferInfo &getInfo() const noexcept { return mInfo; }
+  const VariableSet &getBoundary() const noexcept { return mBoundary; }
+  DenseMap<DFNode *, VariableSet> &getValues() noexcept { return mValues; }
+
+  /// Return boundary condition for an inner loop region.
+  const VariableSet &getBoundary(DFRegion *R) { return mInnerBoundary[R]; }
+
+  void transfer(VariableSet &V, DFNode *N) {
+    if (auto *DFB = dyn_cast<DFBlock>(N)) {
+      V |= mInfo.getHostAccess(DFB->getBlock()).Write;
+      return;
+    }
+    auto *DFL = dyn_cast<DFLoop>(N);
+    if (!DFL)
+      return;
+    if (auto *A = mInfo.getActual(DFL->getLoop())) {
+      mResults.ActualIn[A] = std::make_pair(DFL->getLoop(), V);
+      V.reset(mInfo.toSet(DFL->getLoop(), A->getMemory()));
+    }
+    if (!mInfo.isDevice(DFL->getLoop())) {
+      V |= mInfo.getHostAccess(DFL->getLoop()).Write;
+      mInnerBoundary[DFL] = V;
+    }
+  }
+
+private:
+  const TransferInfo &mInfo;
+  TransferDFResults &mResults;
+  VariableSet mBoundary;
+  DenseMap<DFNode *, VariableSet> mValues;
+  DenseMap<DFRegion *, VariableSet> mInnerBoundary;
+};
+
+/// Data-flow framework to find variables which may be accessed on host before
+/// the next 'get_actual' directive.
+class HostUseDFFwk : private bcl::Uncopyable {
+public:
+  HostUseDFFwk(const TransferInfo &Info, TransferDFResults &Results,
+               VariableSet Boundary)
+      : mInfo(Info), mResults(Results), mBoundary(std::move(Boundary)) {}
+
+  const TransferInfo &getInfo() const noexcept { return mInfo; }
+  const VariableSet &getBoundary() const noexcept { return mBoundary; }
+  DenseMap<DFNode *, VariableSet> &getValues() noexcept { return mValues; }
+
+  /// Return boundary condition for an inner loop region.
+  const VariableSet &getBoundary(DFRegion *R) { return mInnerBoundary[R]; }
+
+  void transfer(VariableSet &V, DFNode *N) {
+    if (auto *DFB = dyn_cast<DFBlock>(N)) {
+      auto &Access = mInfo.getHostAccess(DFB->getBlock());
+      V |= Access.Read;
+      V |= Access.Write;
+      return;
+    }
+    auto *DFL = dyn_cast<DFLoop>(N);
+    if (!DFL)
+      return;
+    auto *L = DFL->getLoop();
+    if (auto *GA = mInfo.getGetActual(L)) {
+      mResults.GetActualOut[GA] = std::make_pair(L, V);
+      V.reset(mInfo.toSet(L, GA->getMemory()));
+    }
+    if (!mInfo.isDevice(L)) {
+      // A host copy is accessed in the loop and it is also necessary
+      // at the beginning of the next iteration.
+      auto &Access = mInfo.getHostAccess(L);
+      V |= Access.Read;
+      V |= Access.Write;
+      V |= mInfo.getInnerActual(L);
+      mInnerBoundary[DFL] = V;
+    }
+    // Directive 'actual' implies that a host copy is up to date.
+    if (auto *A = mInfo.getActual(L))
+      V |= mInfo.toSet(L, A->getMemory());
+  }
+
+private:
+  const TransferInfo &mInfo;
+  TransferDFResults &mResults;
+  VariableSet mBoundary;
+  DenseMap<DFNode *, VariableSet> mValues;
+  DenseMap<DFRegion *, VariableSet> mInnerBoundary;
+};
+} // namespace
+
+namespace tsar {
+template <> struct DataFlowTraits<HostWriteDFFwk *> {
+  using GraphType = Forward<DFRegion *>;
+  using ValueType = VariableSet;
+  static ValueType topElement(HostWriteDFFwk *DFF, GraphType) {
+    return ValueType(DFF->getInfo().getNumVars());
+  }
+  static ValueType boundaryCondition(HostWriteDFFwk *DFF, GraphType) {
+    return DFF->getBoundary();
+  }
+  static void setValue(ValueType V, DFNode *N, HostWriteDFFwk *DFF) {
+    DFF->getValues()[N] = std::move(V);
+  }
+  static const ValueType &getValue(DFNode *N, HostWriteDFFwk *DFF) {
+    return DFF->getValues()[N];
+  }
+  static void initialize(DFNode *, HostWriteDFFwk *, GraphType) {}
+  static void meetOperator(const ValueType &LHS, ValueType &RHS,
+                           HostWriteDFFwk *, GraphType) {
+    RHS |= LHS;
+  }
+  static bool transferFunction(ValueType V, DFNode *N, HostWriteDFFwk *DFF,
+                               GraphType) {
+    DFF->transfer(V, N);
+    auto &Out = DFF->getValues()[N];
+    if (Out == V)
+      return false;
+    Out = std::move(V);
+    return true;
+  }
+};
+
+template <> struct DataFlowTraits<HostUseDFFwk *> {
+  using GraphType = Backward<DFRegion *>;
+  using ValueType = VariableSet;
+  static ValueType topElement(HostUseDFFwk *DFF, GraphType) {
+    return ValueType(DFF->getInfo().getNumVars());
+  }
+  static ValueType boundaryCondition(HostUseDFFwk *DFF, GraphType) {
+    return DFF->getBoundary();
+  }
+  static void setValue(ValueType V, DFNode *N, HostUseDFFwk *DFF) {
+    DFF->getValues()[N] = std::move(V);
+  }
+  static const ValueType &getValue(DFNode *N, HostUseDFFwk *DFF) {
+    return DFF->getValues()[N];
+  }
+  static void initialize(DFNode *, HostUseDFFwk *, GraphType) {}
+  static void meetOperator(const ValueType &LHS, ValueType &RHS,
+                           HostUseDFFwk *, GraphType) {
+    RHS |= LHS;
+  }
+  static bool transferFunction(ValueType V, DFNode *N, HostUseDFFwk *DFF,
+                               GraphType) {
+    DFF->transfer(V, N);
+    auto &In = DFF->getValues()[N];
+    if (In == V)
+      return false;
+    In = std::move(V);
+    return true;
+  }
+};
+} // namespace tsar
+
+/// Solve a data-flow problem for a specified region and for all inner regions
+/// which are executed on host.
+template <class DFFwk, class GraphT>
+static void solveTransferDataFlow(DFRegion *R, const TransferInfo &Info,
+                                  TransferDFResults &Results,
+                                  VariableSet Boundary) {
+  DFFwk DFF(Info, Results, std::move(Boundary));
+  // The region is traversed using its compact view, so in backward direction
+  // the latch node is connected with the exit node without modification of
+  // the region which may be accessed concurrently
+  // (see IndexedGraphTraits<Backward<DFRegion *>>).
+  assert(!R->getGraphView().empty() &&
+         "Region must be built by DFRegionInfo!");
+  solveDataFlow(&DFF, GraphT(R));
+  for (auto *Inner : R->getRegions())
+    if (auto *DFL = dyn_cast<DFLoop>(Inner))
+      if (!Info.isDevice(DFL->getLoop()))
+        solveTransferDataFlow<DFFwk, GraphT>(Inner, Info, Results,
+                                             DFF.getBoundary(Inner));
+}
+
+void ClangDVMHSMParallelization::optimizeDataTransfers(
+    Function &F, const FunctionAnalysis &Provider) {
+  TransferInfo Info(F, Provider, mParallelizationInfo);
+  if (Info.getNumVars() == 0)
+    return;
+  auto &LI = Provider.value<LoopInfoWrapperPass *>()->getLoopInfo();
+  auto &LM = Provider.value<LoopMatcherPass *>()->getMatcher();
+  auto &RI = Provider.value<DFRegionInfoPass *>()->getRegionInfo();
+  auto *TopRegion = cast<DFRegion>(RI.getTopLevelRegion());
+  // A directive can be attached to a loop which has a source-level
+  // representation only.
+  auto canAttach = [&LM, &Info](Loop *L, bool OnExit) {
+    return !Info.isDevice(L) && L->getLoopID() && LM.find<IR>(L) != LM.end() &&
+           (!OnExit || L->getExitingBlock());
+  };
+  unsigned NumRemoved = 0;
+  // Hoisted directives are accounted as additional transfers, so the estimate
+  // may be negative if nothing has been removed.
+  int64_t SavedBytes = 0;
+  auto updateSaved = [&Info, &SavedBytes](unsigned Id, int64_t Factor) {
+    if (auto Size = Info.getSize(Id))
+      SavedBytes += Factor * static_cast<int64_t>(*Size);
+  };
+  // Hoist 'actual' directives out of loops which do not modify variables on
+  // host. A host copy is up to date at the beginning of such loops.
+  for (auto *L : LI.getLoopsInPreorder()) {
+    auto *A = Info.isDevice(L) ? Info.getActual(L) : nullptr;
+    if (!A)
+      continue;
+    for (auto &Var : A->getMemory()) {
+      auto Id = Info.getId(Var, L);
+      if (!Id)
+        continue;
+      // A directive can be hoisted while its name refers to the same variable.
+      Loop *Target = nullptr;
+      for (auto *P = L->getParentLoop();
+           P && !Info.isDevice(P) && !Info.getHostAccess(P).Write.test(*Id) &&
+           Info.getId(Var, P) == Id;
+           P = P->getParentLoop())
+        if (canAttach(P, false))
+          Target = P;
+      if (Target &&
+          Info.getOrCreateActual(Target).getMemory().insert(Var).second)
+        updateSaved(*Id, -1);
+    }
+  }
+  TransferDFResults Results;
+  VariableSet All(Info.getNumVars(), true);
+  solveTransferDataFlow<HostWriteDFFwk, Forward<DFRegion *>>(TopRegion, Info,
+                                                             Results, All);
+  for (auto &ActualIn : Results.ActualIn) {
+    auto &Memory = ActualIn.first->getMemory();
+    auto *L = ActualIn.second.first;
+    auto &MayBeModified = ActualIn.second.second;
+    for (auto I = Memory.begin(), EI = Memory.end(); I != EI;) {
+      auto Id = Info.getId(*I, L);
+      if (!Id || MayBeModified.test(*Id)) {
+        ++I;
+        continue;
+      }
+      LLVM_DEBUG(dbgs() << "[DVMH SM]: remove redundant actual for " << *I
+                        << "\n");
+      ++NumRemoved;
+      updateSaved(*Id, 1);
+      I = Memory.erase(I);
+    }
+  }
+  // Hoist 'get_actual' directives out of loops which do not access variables
+  // on host.
+  for (auto *L : LI.getLoopsInPreorder()) {
+    auto *GA = Info.isDevice(L) ? Info.getGetActual(L) : nullptr;
+    if (!GA)
+      continue;
+    for (auto &Var : GA->getMemory()) {
+      auto Id = Info.getId(Var, L);
+      if (!Id)
+        continue;
+      Loop *Target = nullptr;
+      for (auto *P = L->getParentLoop(); P && !Info.isDevice(P);
+           P = P->getParentLoop()) {
+        auto &Access = Info.getHostAccess(P);
+        if (Access.Read.test(*Id) || Access.Write.test(*Id) ||
+            Info.getInnerActual(P).test(*Id) || Info.getId(Var, P) != Id)
+          break;
+        if (canAttach(P, true))
+          Target = P;
+      }
+      if (Target &&
+          Info.getOrCreateGetActual(Target).getMemory().insert(Var).second)
+        updateSaved(*Id, -1);
+    }
+  }
+  solveTransferDataFlow<HostUseDFFwk, Backward<DFRegion *>>(TopRegion, Info,
+                                                            Results, All);
+  for (auto &GetActualOut : Results.GetActualOut) {
+    auto &Memory = GetActualOut.first->getMemory();
+    auto *L = GetActualOut.second.first;
+    auto &MayBeUsed = GetActualOut.second.second;
+    for (auto I = Memory.begin(), EI = Memory.end(); I != EI;) {
+      auto Id = Info.getId(*I, L);
+      if (!Id || MayBeUsed.test(*Id)) {
+        ++I;
+        continue;
+      }
+      LLVM_DEBUG(dbgs() << "[DVMH SM]: remove redundant get_actual for " << *I
+                        << "\n");
+      ++NumRemoved;
+      updateSaved(*Id, 1);
+      I = Memory.erase(I);
+    }
+  }
+  if (NumRemoved == 0)
+    return;
+  NumTransfersRemoved += NumRemoved;
+  auto *TfmCtx =
+      getAnalysis<TransformationEnginePass>()->getContext(*F.getParent());
+  if (auto *D = TfmCtx->getDeclForMangledName(F.getName()))
+    toDiag(TfmCtx->getContext().getDiagnostics(), D->getLocation(),
+           tsar::diag::remark_parallel_transfer_removed)
+        << NumRemoved << std::to_string(std::max<int64_t>(SavedBytes, 0));
+}
+
 static inline void addVarList(
     const ClangDependenceAnalyzer::SortedVarListT &VarInfoList,
     SmallVectorImpl<char> &Clause) {
@@ -770,9 +1445,15 @@ static void addReductionIfNeed(
 bool ClangDVMHSMParallelization::runOnModule(llvm::Module &M) {
   ClangSMParallelization::runOnModule(M);
   auto *TfmCtx = getAnalysis<TransformationEnginePass>()->getContext(M);
-  for (auto F : make_range(mParallelizationInfo.func_begin(),
-                           mParallelizationInfo.func_end())) {
+  // New parallel locations may be attached to functions, so we iterate over
+  // a copy of the list of functions.
+  SmallVector<Function *, 16> ParallelFuncs(mParallelizationInfo.func_begin(),
+                                            mParallelizationInfo.func_end());
+  for (auto *F : ParallelFuncs) {
+    // The same results of function analysis are used to optimize data
+    // transfers and to emit directives, so analyze each function once.
     auto Provider = analyzeFunction(*F);
+    optimizeDataTransfers(*F, Provider);
     auto &LI = Provider.value<LoopInfoWrapperPass*>()->getLoopInfo();
     auto &LM = Provider.value<LoopMatcherPass *>()->getMatcher();
     for (auto &BB : *F) {
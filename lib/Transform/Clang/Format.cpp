@@ -25,6 +25,7 @@
 #include "tsar/Transform/Clang/Format.h"
 #include "tsar/Frontend/Clang/TransformationContext.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Support/Clang/Diagnostic.h"
 #include "tsar/Support/Clang/Utils.h"
 #include <clang/AST/ASTContext.h>
@@ -32,9 +33,15 @@
 #include <clang/Basic/SourceManager.h>
 #include <clang/Lex/Lexer.h>
 #include <clang/Rewrite/Core/Rewriter.h>
+#include <clang/Tooling/Core/Replacement.h>
 #include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Support/Debug.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/ThreadPool.h>
+#include <chrono>
 #include <vector>
 
 using namespace clang;
@@ -44,6 +51,128 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "ast-format"
 
+namespace {
+/// Maximum number of different lines which are searched for in a file.
+///
+/// If a file is changed more, it is reformatted entirely.
+constexpr unsigned MaxDiffLines = 1000;
+
+/// Split a specified text into lines, each line includes a trailing newline.
+void splitLines(StringRef Text, SmallVectorImpl<StringRef> &Lines) {
+  while (!Text.empty()) {
+    auto Pos = Text.find('\n');
+    auto Line = Text.take_front(Pos == StringRef::npos ? Text.size() : Pos + 1);
+    Lines.push_back(Line);
+    Text = Text.drop_front(Line.size());
+  }
+}
+
+/// Find ranges of a transformed source which differ from an original source.
+///
+/// This function uses the Myers' difference algorithm over lines of sources.
+/// Inserted and replaced lines are represented as ranges which cover these
+/// lines, removed lines are represented as empty ranges at the position of
+/// removal.
+/// \return False if the number of different lines exceeds MaxDiffLines.
+bool findEditedRanges(StringRef Orig, StringRef Tfm,
+    std::vector<tooling::Range> &Ranges) {
+  SmallVector<StringRef, 256> A, B;
+  splitLines(Orig, A);
+  splitLines(Tfm, B);
+  // Offsets of lines in the transformed source.
+  SmallVector<unsigned, 256> Offsets;
+  Offsets.reserve(B.size() + 1);
+  Offsets.push_back(0);
+  for (auto &Line : B)
+    Offsets.push_back(Offsets.back() + Line.size());
+  int Prefix = 0;
+  while (Prefix < (int)A.size() && Prefix < (int)B.size() &&
+         A[Prefix] == B[Prefix])
+    ++Prefix;
+  int N = A.size(), M = B.size();
+  while (N > Prefix && M > Prefix && A[N - 1] == B[M - 1])
+    --N, --M;
+  // Lines in the range [Prefix, N) of the original source are replaced with
+  // lines in the range [Prefix, M) of the transformed source.
+  int Max = std::min<int>(N + M - 2 * Prefix, MaxDiffLines);
+  std::vector<int> V(2 * Max + 3, 0);
+  auto at = [&V, Max](int K) -> int & { return V[K + Max + 1]; };
+  at(1) = Prefix;
+  std::vector<std::vector<int>> Trace;
+  int FinalD = -1;
+  for (int D = 0; D <= Max && FinalD < 0; ++D) {
+    Trace.emplace_back(V.begin() + Max + 1 - D, V.begin() + Max + 2 + D);
+    for (int K = -D; K <= D; K += 2) {
+      int X = (K == -D || (K != D && at(K - 1) < at(K + 1))) ?
+        at(K + 1) : at(K - 1) + 1;
+      int Y = X - K;
+      while (X < N && Y < M && A[X] == B[Y])
+        ++X, ++Y;
+      at(K) = X;
+      if (X >= N && Y >= M) {
+        FinalD = D;
+        break;
+      }
+    }
+  }
+  if (FinalD < 0)
+    return false;
+  // Diagonals are shifted by Prefix because both sources start at Prefix.
+  SmallVector<std::pair<int, bool>, 16> Edits;
+  int X = N, Y = M;
+  for (int D = FinalD; D > 0; --D) {
+    auto &PrevV = Trace[D];
+    auto prev = [&PrevV, D](int K) { return PrevV[K + D]; };
+    int K = X - Y;
+    bool IsInsert = K == -D || (K != D && prev(K - 1) < prev(K + 1));
+    int PrevK = IsInsert ? K + 1 : K - 1;
+    int PrevX = prev(PrevK), PrevY = PrevX - PrevK;
+    // An inserted line of the transformed source or a position of removal.
+    Edits.emplace_back(PrevY, IsInsert);
+    X = PrevX, Y = PrevY;
+  }
+  for (auto &E : llvm::reverse(Edits)) {
+    unsigned Offset = Offsets[E.first];
+    unsigned Length = E.second ? B[E.first].size() : 0;
+    if (!Ranges.empty() &&
+        Ranges.back().getOffset() + Ranges.back().getLength() == Offset)
+      Ranges.back() = tooling::Range(Ranges.back().getOffset(),
+                                     Ranges.back().getLength() + Length);
+    else
+      Ranges.emplace_back(Offset, Length);
+  }
+  return true;
+}
+
+/// Source file which should be reformatted.
+struct FormatTask {
+  FileID File;
+  std::string Filename;
+  std::string Source;
+  std::vector<tooling::Range> Ranges;
+  std::string Result;
+  bool IsValid = false;
+  std::chrono::steady_clock::time_point Start;
+  std::chrono::steady_clock::time_point End;
+  uint64_t ThreadId = 0;
+};
+
+void reformatFile(FormatTask &Task) {
+  Task.Start = std::chrono::steady_clock::now();
+  Task.ThreadId = get_threadid();
+  auto ReformatSrc = Task.Ranges.empty() ?
+    tsar::reformat(Task.Source, Task.Filename) :
+    tsar::reformat(Task.Source, Task.Filename, Task.Ranges);
+  if (ReformatSrc) {
+    Task.Result = std::move(*ReformatSrc);
+    Task.IsValid = true;
+  } else {
+    consumeError(ReformatSrc.takeError());
+  }
+  Task.End = std::chrono::steady_clock::now();
+}
+}
+
 bool tsar::formatSourceAndPrepareToRelease(
     const GlobalOptions &GlobalOpts, ClangTransformationContext &TfmCtx,
     const FilenameAdjuster &Adjuster) {
@@ -55,6 +184,7 @@ bool tsar::formatSourceAndPrepareToRelease(
   StringSet<> TransformedFiles;
 #endif
   bool IsAllValid{true};
+  std::vector<FormatTask> Tasks;
   for (auto &Buffer :
        make_range(TfmRewriter.buffer_begin(), TfmRewriter.buffer_end())) {
     auto StartLoc{SrcMgr.getLocForStartOfFile(Buffer.first)};
@@ -79,17 +209,48 @@ bool tsar::formatSourceAndPrepareToRelease(
       }
     }
     if (!GlobalOpts.NoFormat) {
-      std::string TfmSrc(Buffer.second.begin(), Buffer.second.end());
-      auto EndLoc = SrcMgr.getLocForEndOfFile(Buffer.first);
-      auto ReformatSrc = reformat(TfmSrc, Adjuster(OrigFile->getName()));
-      if (!ReformatSrc) {
-        toDiag(Diags, StartLoc, tsar::diag::warn_reformat);
-        continue;
-      }
-      auto CurrSize = Buffer.second.size();
-      Buffer.second.InsertTextBefore(0, ReformatSrc.get());
-      Buffer.second.RemoveText(0, CurrSize);
+      Tasks.emplace_back();
+      auto &Task{Tasks.back()};
+      Task.File = Buffer.first;
+      Task.Filename = Adjuster(OrigFile->getName());
+      Task.Source.assign(Buffer.second.begin(), Buffer.second.end());
+      // Reformat the whole file if there are too many changes.
+      if (!findEditedRanges(SrcMgr.getBufferData(Buffer.first), Task.Source,
+                            Task.Ranges))
+        Task.Ranges.clear();
+      else if (Task.Ranges.empty())
+        Tasks.pop_back();
+    }
+  }
+  if (Tasks.size() > 1) {
+    ThreadPool Pool(hardware_concurrency(GlobalOpts.FormatThreads));
+    for (auto &Task : Tasks)
+      Pool.async([&Task]() { reformatFile(Task); });
+    Pool.wait();
+  } else if (!Tasks.empty()) {
+    reformatFile(Tasks.front());
+  }
+  for (auto &Task : Tasks) {
+    LLVM_DEBUG(
+      dbgs() << "[FORMAT]: " << Task.Filename << ": ";
+      if (Task.Ranges.empty())
+        dbgs() << "whole file";
+      else
+        dbgs() << Task.Ranges.size() << " edited range(s)";
+      dbgs() << ", "
+             << std::chrono::duration<double>(Task.End - Task.Start).count()
+             << " s\n");
+    addProfileTask("Format", Task.Filename, Task.Start, Task.End,
+                   Task.ThreadId);
+    if (!Task.IsValid) {
+      toDiag(Diags, SrcMgr.getLocForStartOfFile(Task.File),
+             tsar::diag::warn_reformat);
+      continue;
     }
+    auto &Buffer{TfmRewriter.getEditBuffer(Task.File)};
+    auto CurrSize = Buffer.size();
+    Buffer.InsertTextBefore(0, Task.Result);
+    Buffer.RemoveText(0, CurrSize);
   }
   return IsAllValid;
 }
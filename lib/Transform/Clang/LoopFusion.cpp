@@ -0,0 +1,890 @@
+//===- LoopFusion.cpp ---- Source-level Loop Fusion -------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2021 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements passes to fuse adjacent loops and to distribute a loop
+// into several loops at the source level.
+//
+// Fusion merges a chain of adjacent canonical loops with identical iteration
+// spaces if each dependence between loops in the chain remains forward after
+// fusion. Fusion allows us to reuse data which are accessed in different loops
+// and reduce the total amount of memory traffic.
+//
+// Distribution splits a loop which can not be parallelized into several loops
+// if loop-carried dependencies exist in a single statement of the loop body
+// only. In this case all loops except one may be parallelized.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SharedMemoryAutoPar.h"
+#include "tsar/Analysis/AnalysisServer.h"
+#include "tsar/Analysis/Clang/CanonicalLoop.h"
+#include "tsar/Analysis/Clang/DIMemoryMatcher.h"
+#include "tsar/Analysis/Clang/LoopMatcher.h"
+#include "tsar/Analysis/Clang/MemoryMatcher.h"
+#include "tsar/Analysis/Clang/VariableCollector.h"
+#include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/Memory/ClonedDIMemoryMatcher.h"
+#include "tsar/Analysis/Memory/DIArrayAccess.h"
+#include "tsar/Analysis/Memory/DIClientServerInfo.h"
+#include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
+#include "tsar/Analysis/Memory/DIMemoryTrait.h"
+#include "tsar/Analysis/Memory/MemoryTraitUtils.h"
+#include "tsar/Analysis/Memory/PassAAProvider.h"
+#include "tsar/Analysis/Parallel/ParallelLoop.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Core/TransformationContext.h"
+#include "tsar/Frontend/Clang/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/MetadataUtils.h"
+#include "tsar/Transform/Clang/Passes.h"
+#include <clang/AST/ParentMapContext.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/AST/Stmt.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/SmallBitVector.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Support/Debug.h>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-loop-fusion"
+
+STATISTIC(NumFused, "Number of fused loops");
+STATISTIC(NumDistributed, "Number of distributed loops");
+
+namespace {
+using ClangLoopFusionProvider =
+    FunctionPassAAProvider<LoopInfoWrapperPass, CanonicalLoopPass,
+                           LoopMatcherPass, DFRegionInfoPass,
+                           ClangDIMemoryMatcherPass, ParallelLoopPass>;
+
+/// This is a base class for passes which restructure loops at the source
+/// level. It collects analysis results which are common for such passes.
+class ClangLoopRestructuring : public ModulePass, private bcl::Uncopyable {
+public:
+  explicit ClangLoopRestructuring(char &ID) : ModulePass(ID) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override {
+    mTfmCtx = nullptr;
+    mGlobalOpts = nullptr;
+    mAccessInfo = nullptr;
+    mSocketInfo = nullptr;
+  }
+
+protected:
+  /// Initialize the provider and common analysis results, return false if
+  /// the transformation is not possible.
+  bool initializeProvider(Module &M);
+
+  /// Return canonical loop which is matched to a specified AST loop or nullptr.
+  ForStmt *getForStmt(Loop &L, ClangLoopFusionProvider &Provider);
+
+  ClangTransformationContext *mTfmCtx = nullptr;
+  const GlobalOptions *mGlobalOpts = nullptr;
+  DIArrayAccessInfo *mAccessInfo = nullptr;
+  AnalysisSocketInfo *mSocketInfo = nullptr;
+};
+
+/// This pass fuses adjacent loops with identical iteration spaces.
+class ClangLoopFusion : public ClangLoopRestructuring {
+public:
+  static char ID;
+
+  ClangLoopFusion() : ClangLoopRestructuring(ID) {
+    initializeClangLoopFusionPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  /// Chain of adjacent loops to be fused.
+  using LoopChain = SmallVector<std::pair<Loop *, ForStmt *>, 4>;
+
+  /// Number of loops in a chain which accesses an array (except the first
+  /// one). Client-side memory is used as a key.
+  using ReuseMap = SmallDenseMap<DIMemory *, unsigned, 8>;
+
+  /// Fuse loops from a specified range and visit inner loops of loops which
+  /// have not been fused.
+  template <class ItrT>
+  void visitLoops(ItrT I, ItrT EI, ClangLoopFusionProvider &Provider,
+                  const DIClientServerInfo &DIInfo);
+
+  /// Return true if loops have identical iteration spaces.
+  bool isConformable(Loop &L1, ForStmt &For1, Loop &L2, ForStmt &For2,
+                     ClangLoopFusionProvider &Provider);
+
+  /// Return true if it is legal to fuse loop `L1` with the subsequent
+  /// loop `L2`, remember arrays accessed in both loops.
+  bool isLegal(Loop &L1, Loop &L2, const DIClientServerInfo &DIInfo,
+               SmallPtrSetImpl<DIMemory *> &Shared);
+
+  /// Return true if all dependencies between accesses to a specified array
+  /// in loop `L1` and in loop `L2` remain forward after fusion.
+  bool isForwardDependence(DIMemory &A, Loop &L1, Loop &L2);
+
+  /// Merge bodies of loops from a chain in a source code.
+  bool fuse(const LoopChain &Chain);
+
+  /// Estimate number of bytes which will not be loaded from memory after
+  /// fusion.
+  Optional<uint64_t> estimateSavedTraffic(Loop &L, const ReuseMap &Reuse,
+                                          ClangLoopFusionProvider &Provider);
+};
+
+/// This pass distributes loops in order to separate a statement which
+/// prevents parallelization.
+class ClangLoopDistribution : public ClangLoopRestructuring {
+public:
+  static char ID;
+
+  ClangLoopDistribution() : ClangLoopRestructuring(ID) {
+    initializeClangLoopDistributionPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  /// Distribute loops from a specified range and visit inner loops of loops
+  /// which have not been distributed.
+  template <class ItrT>
+  void visitLoops(ItrT I, ItrT EI, ClangLoopFusionProvider &Provider,
+                  const DIClientServerInfo &DIInfo,
+                  const ClonedDIMemoryMatcher *ServerMatcher);
+
+  /// Try to distribute a specified loop, return true on success.
+  bool distribute(Loop &L, ForStmt &For, ClangLoopFusionProvider &Provider,
+                  const DIClientServerInfo &DIInfo,
+                  const ClonedDIMemoryMatcher &ServerMatcher);
+};
+
+/// Look up for statements which transfer control outside a loop body.
+class ControlTransferVisitor
+    : public RecursiveASTVisitor<ControlTransferVisitor> {
+public:
+  bool hasControlTransfer() const noexcept { return mHasTransfer; }
+
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    // Statements 'break' and 'continue' inside nested loops and switches
+    // do not transfer control outside the analyzed loop.
+    if (isa<ForStmt>(S) || isa<WhileStmt>(S) || isa<DoStmt>(S) ||
+        isa<SwitchStmt>(S)) {
+      ++mNestedLevel;
+      auto Res = RecursiveASTVisitor::TraverseStmt(S);
+      --mNestedLevel;
+      return Res;
+    }
+    return RecursiveASTVisitor::TraverseStmt(S);
+  }
+
+  bool VisitBreakStmt(BreakStmt *) { return mNestedLevel > 0 || transfer(); }
+  bool VisitContinueStmt(ContinueStmt *) {
+    return mNestedLevel > 0 || transfer();
+  }
+  bool VisitReturnStmt(ReturnStmt *) { return transfer(); }
+  bool VisitGotoStmt(GotoStmt *) { return transfer(); }
+  bool VisitIndirectGotoStmt(IndirectGotoStmt *) { return transfer(); }
+  bool VisitLabelStmt(LabelStmt *) { return transfer(); }
+
+private:
+  bool transfer() {
+    mHasTransfer = true;
+    return false;
+  }
+
+  unsigned mNestedLevel = 0;
+  bool mHasTransfer = false;
+};
+} // namespace
+
+char ClangLoopFusion::ID = 0;
+char ClangLoopDistribution::ID = 0;
+
+INITIALIZE_PROVIDER(ClangLoopFusionProvider, "clang-loop-fusion-provider",
+                    "Loop Fusion (Clang, Provider)")
+
+#define INITIALIZE_LOOP_RESTRUCTURING_DEPS                                     \
+  INITIALIZE_PASS_IN_GROUP_INFO(ClangSMParallelizationInfo)                    \
+  INITIALIZE_PASS_DEPENDENCY(ClangLoopFusionProvider)                          \
+  INITIALIZE_PASS_DEPENDENCY(AnalysisSocketImmutableWrapper)                   \
+  INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)                         \
+  INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)                    \
+  INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)                    \
+  INITIALIZE_PASS_DEPENDENCY(GlobalsAAWrapperPass)                             \
+  INITIALIZE_PASS_DEPENDENCY(DIMemoryEnvironmentWrapper)                       \
+  INITIALIZE_PASS_DEPENDENCY(DIArrayAccessWrapper)
+
+INITIALIZE_PASS_IN_GROUP_BEGIN(ClangLoopFusion, "clang-loop-fusion",
+  "Loop Fusion (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+INITIALIZE_LOOP_RESTRUCTURING_DEPS
+INITIALIZE_PASS_IN_GROUP_END(ClangLoopFusion, "clang-loop-fusion",
+  "Loop Fusion (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+
+INITIALIZE_PASS_IN_GROUP_BEGIN(ClangLoopDistribution, "clang-loop-distribution",
+  "Loop Distribution (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+INITIALIZE_LOOP_RESTRUCTURING_DEPS
+INITIALIZE_PASS_IN_GROUP_END(ClangLoopDistribution, "clang-loop-distribution",
+  "Loop Distribution (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+
+ModulePass *llvm::createClangLoopFusion() { return new ClangLoopFusion; }
+
+ModulePass *llvm::createClangLoopDistribution() {
+  return new ClangLoopDistribution;
+}
+
+void ClangLoopRestructuring::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<ClangLoopFusionProvider>();
+  AU.addRequired<AnalysisSocketImmutableWrapper>();
+  AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<MemoryMatcherImmutableWrapper>();
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.addRequired<GlobalsAAWrapperPass>();
+  AU.addRequired<DIMemoryEnvironmentWrapper>();
+  AU.addRequired<DIArrayAccessWrapper>();
+  AU.setPreservesAll();
+}
+
+bool ClangLoopRestructuring::initializeProvider(Module &M) {
+  releaseMemory();
+  auto &TfmInfo = getAnalysis<TransformationEnginePass>();
+  mTfmCtx = TfmInfo ? TfmInfo->getContext(M) : nullptr;
+  if (!mTfmCtx || !mTfmCtx->hasInstance()) {
+    M.getContext().emitError("can not transform sources"
+                             ": transformation context is not available");
+    return false;
+  }
+  auto &SocketInfo = getAnalysis<AnalysisSocketImmutableWrapper>().get();
+  auto &MemoryMatcher = getAnalysis<MemoryMatcherImmutableWrapper>().get();
+  auto &GlobalsAA = getAnalysis<GlobalsAAWrapperPass>().getResult();
+  auto &DIMEnv = getAnalysis<DIMemoryEnvironmentWrapper>().get();
+  mSocketInfo = &SocketInfo;
+  mGlobalOpts = &getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  mAccessInfo = getAnalysis<DIArrayAccessWrapper>().getAccessInfo();
+  ClangLoopFusionProvider::initialize<GlobalOptionsImmutableWrapper>(
+      [this](GlobalOptionsImmutableWrapper &Wrapper) {
+        Wrapper.setOptions(mGlobalOpts);
+      });
+  ClangLoopFusionProvider::initialize<AnalysisSocketImmutableWrapper>(
+      [&SocketInfo](AnalysisSocketImmutableWrapper &Wrapper) {
+        Wrapper.set(SocketInfo);
+      });
+  ClangLoopFusionProvider::initialize<TransformationEnginePass>(
+      [&TfmInfo](TransformationEnginePass &Wrapper) {
+        Wrapper.set(TfmInfo.get());
+      });
+  ClangLoopFusionProvider::initialize<MemoryMatcherImmutableWrapper>(
+      [&MemoryMatcher](MemoryMatcherImmutableWrapper &Wrapper) {
+        Wrapper.set(MemoryMatcher);
+      });
+  ClangLoopFusionProvider::initialize<GlobalsAAResultImmutableWrapper>(
+      [&GlobalsAA](GlobalsAAResultImmutableWrapper &Wrapper) {
+        Wrapper.set(GlobalsAA);
+      });
+  ClangLoopFusionProvider::initialize<DIMemoryEnvironmentWrapper>(
+      [&DIMEnv](DIMemoryEnvironmentWrapper &Wrapper) { Wrapper.set(DIMEnv); });
+  return true;
+}
+
+ForStmt *ClangLoopRestructuring::getForStmt(Loop &L,
+                                            ClangLoopFusionProvider &Provider) {
+  auto &CL = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
+  auto &RI = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
+  if (!L.getLoopID())
+    return nullptr;
+  auto MatchItr = LM.find<IR>(&L);
+  if (MatchItr == LM.end())
+    return nullptr;
+  auto CanonItr = CL.find_as(RI.getRegionFor(&L));
+  if (CanonItr == CL.end() || !(**CanonItr).isCanonical() ||
+      !(**CanonItr).getASTLoop() ||
+      !isa_and_nonnull<SCEVConstant>((**CanonItr).getStep()))
+    return nullptr;
+  return dyn_cast<ForStmt>(MatchItr->get<AST>());
+}
+
+/// Return induction variable which is declared or initialized in the header
+/// of a specified canonical loop.
+static VarDecl *getInduction(const ForStmt &For) {
+  if (auto *DS = dyn_cast_or_null<DeclStmt>(For.getInit()))
+    return DS->isSingleDecl() ? dyn_cast<VarDecl>(DS->getSingleDecl())
+                              : nullptr;
+  if (auto *BO = dyn_cast_or_null<BinaryOperator>(For.getInit()))
+    if (BO->isAssignmentOp())
+      if (auto *DRE =
+              dyn_cast<DeclRefExpr>(BO->getLHS()->IgnoreParenImpCasts()))
+        return dyn_cast<VarDecl>(DRE->getDecl());
+  return nullptr;
+}
+
+/// Return true if both values are the same or they are equal constants.
+static bool isSameBound(Value *LHS, Value *RHS) {
+  if (!LHS || !RHS)
+    return false;
+  if (LHS == RHS)
+    return true;
+  auto *LHSC = dyn_cast<ConstantInt>(LHS);
+  auto *RHSC = dyn_cast<ConstantInt>(RHS);
+  return LHSC && RHSC &&
+         APInt::isSameValue(LHSC->getValue(), RHSC->getValue());
+}
+
+/// Return integer value if it fits into 64 bits.
+static Optional<int64_t> toInt64(const APSInt &V) {
+  if (V.getMinSignedBits() > 64)
+    return None;
+  return V.getExtValue();
+}
+
+/// Return number of iterations of a loop if it is known at compile time.
+static Optional<uint64_t> getTripCount(const CanonicalLoopInfo &Info) {
+  auto *Start = dyn_cast_or_null<ConstantInt>(Info.getStart());
+  auto *End = dyn_cast_or_null<ConstantInt>(Info.getEnd());
+  auto *Step = dyn_cast_or_null<SCEVConstant>(Info.getStep());
+  if (!Start || !End || !Step || Step->getAPInt().isNullValue())
+    return None;
+  auto Diff = End->getSExtValue() - Start->getSExtValue();
+  auto StepValue = Step->getAPInt().getSExtValue();
+  if (Diff != 0 && (Diff > 0) != (StepValue > 0))
+    return 0;
+  return static_cast<uint64_t>(Diff / StepValue);
+}
+
+/// Return size of an element of a specified array or None if it is unknown.
+static Optional<uint64_t> getElementSize(const DIMemory &A) {
+  auto *DIEM = dyn_cast<DIEstimateMemory>(&A);
+  if (!DIEM)
+    return None;
+  auto *ElTy = arrayElementDIType(DIEM->getVariable()->getType());
+  if (!ElTy)
+    return None;
+  return getSize(ElTy);
+}
+
+/// Return true if `Node` is `Ancestor` or if `Ancestor` contains `Node`.
+static bool isAncestorOrSelf(const DIAliasNode *Ancestor,
+                             const DIAliasNode *Node) {
+  for (; Node; Node = Node->getParent())
+    if (Node == Ancestor)
+      return true;
+  return false;
+}
+
+/// Return true if one of nodes contains another one, so, memory locations
+/// from these nodes may overlap.
+static bool mayOverlap(const DIAliasNode *LHS, const DIAliasNode *RHS) {
+  return isAncestorOrSelf(LHS, RHS) || isAncestorOrSelf(RHS, LHS);
+}
+
+bool ClangLoopFusion::isConformable(Loop &L1, ForStmt &For1, Loop &L2,
+                                    ForStmt &For2,
+                                    ClangLoopFusionProvider &Provider) {
+  auto &CL = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
+  auto &RI = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto &Info1 = **CL.find_as(RI.getRegionFor(&L1));
+  auto &Info2 = **CL.find_as(RI.getRegionFor(&L2));
+  if (!isSameBound(Info1.getStart(), Info2.getStart()) ||
+      !isSameBound(Info1.getEnd(), Info2.getEnd()) ||
+      Info1.getStep() != Info2.getStep() ||
+      Info1.getPredicate() != Info2.getPredicate())
+    return false;
+  if (!isa<CompoundStmt>(For1.getBody()) || !isa<CompoundStmt>(For2.getBody()))
+    return false;
+  auto *I1 = getInduction(For1);
+  auto *I2 = getInduction(For2);
+  if (!I1 || !I2)
+    return false;
+  if (I1->getCanonicalDecl() == I2->getCanonicalDecl())
+    return true;
+  // Induction variables declared in loop headers are renamed implicitly
+  // after fusion, so they must have the same name and type.
+  return isa<DeclStmt>(For1.getInit()) && isa<DeclStmt>(For2.getInit()) &&
+         I1->getName() == I2->getName() &&
+         I1->getASTContext().hasSameType(I1->getType(), I2->getType());
+}
+
+bool ClangLoopFusion::isForwardDependence(DIMemory &A, Loop &L1, Loop &L2) {
+  for (auto &Access1 : mAccessInfo->array_accesses(&A, L1.getLoopID()))
+    for (auto &Access2 : mAccessInfo->array_accesses(&A, L2.getLoopID())) {
+      if (Access1.isReadOnly() && Access2.isReadOnly())
+        continue;
+      if (Access1.size() != Access2.size() || Access1.empty())
+        return false;
+      // Each subscript is `C * N + K` where `N` is a number of iteration.
+      // The same element is accessed at iterations N1 and N2 if
+      // N1 - N2 = (K2 - K1) / C. Dependence remains forward after fusion if
+      // N1 <= N2 for all such iterations.
+      Optional<int64_t> Distance;
+      bool IsIndependent = false;
+      for (unsigned Dim = 0, DimE = Access1.size(); Dim < DimE; ++Dim) {
+        auto *S1 = dyn_cast_or_null<DIAffineSubscript>(Access1[Dim]);
+        auto *S2 = dyn_cast_or_null<DIAffineSubscript>(Access2[Dim]);
+        if (!S1 || !S2 || S1->getNumberOfMonoms() > 1 ||
+            S2->getNumberOfMonoms() > 1)
+          return false;
+        auto getFactor = [](const DIAffineSubscript &S,
+                            ObjectID ID) -> Optional<int64_t> {
+          if (S.getNumberOfMonoms() == 0)
+            return 0;
+          auto Monom = S.getMonom(0);
+          if (Monom.Column != ID)
+            return None;
+          return toInt64(Monom.Value);
+        };
+        auto C1 = getFactor(*S1, L1.getLoopID());
+        auto C2 = getFactor(*S2, L2.getLoopID());
+        auto K1 = toInt64(S1->getConstant());
+        auto K2 = toInt64(S2->getConstant());
+        if (!C1 || !C2 || !K1 || !K2 || *C1 != *C2)
+          return false;
+        if (*C1 == 0) {
+          if (*K1 != *K2) {
+            IsIndependent = true;
+            break;
+          }
+          continue;
+        }
+        if ((*K2 - *K1) % *C1 != 0 ||
+            Distance && *Distance != (*K2 - *K1) / *C1) {
+          IsIndependent = true;
+          break;
+        }
+        Distance = (*K2 - *K1) / *C1;
+      }
+      if (IsIndependent)
+        continue;
+      if (!Distance || *Distance > 0)
+        return false;
+    }
+  return true;
+}
+
+bool ClangLoopFusion::isLegal(Loop &L1, Loop &L2,
+                              const DIClientServerInfo &DIInfo,
+                              SmallPtrSetImpl<DIMemory *> &Shared) {
+  if (!mAccessInfo)
+    return false;
+  SmallVector<DIDependenceSet *, 2> DepSets;
+  SmallVector<DenseSet<const DIAliasNode *>, 2> Coverage(2);
+  for (auto *L : {&L1, &L2}) {
+    auto *LoopID = DIInfo.getObjectID(L->getLoopID());
+    if (!LoopID)
+      return false;
+    auto DepItr = DIInfo.DIDepInfo->find(LoopID);
+    if (DepItr == DIInfo.DIDepInfo->end())
+      return false;
+    DepSets.push_back(&DepItr->get<DIDependenceSet>());
+    accessCoverage<bcl::SimpleInserter>(*DepSets.back(), *DIInfo.DIAT,
+                                        Coverage[DepSets.size() - 1],
+                                        mGlobalOpts->IgnoreRedundantMemory);
+  }
+  // Map from server-side memory to client-side arrays.
+  DenseMap<const DIMemory *, DIMemory *> ServerToClient;
+  for (auto *L : {&L1, &L2})
+    for (auto &Access : mAccessInfo->scope_accesses(L->getLoopID()))
+      if (auto *M = DIInfo.getMemory(Access.getArray()))
+        ServerToClient.try_emplace(M, Access.getArray());
+  for (auto &TS1 : *DepSets[0]) {
+    if (!Coverage[0].count(TS1.getNode()))
+      continue;
+    for (auto &TS2 : *DepSets[1]) {
+      if (!Coverage[1].count(TS2.getNode()) ||
+          !mayOverlap(TS1.getNode(), TS2.getNode()))
+        continue;
+      if (TS1.is<trait::AddressAccess>() || TS2.is<trait::AddressAccess>())
+        return false;
+      bool IsReadonly = TS1.is<trait::Readonly>() && TS2.is<trait::Readonly>();
+      if (!IsReadonly &&
+          (TS1.is<trait::Private>() && TS2.is<trait::Private>() ||
+           TS1.is<trait::Induction>() && TS2.is<trait::Induction>()))
+        continue;
+      if (TS1.size() != 1 || TS2.size() != 1)
+        return IsReadonly;
+      auto *M1 = (*TS1.begin())->getMemory();
+      auto *M2 = (*TS2.begin())->getMemory();
+      auto ClientItr = ServerToClient.find(M1);
+      if (M1 != M2 || ClientItr == ServerToClient.end()) {
+        if (IsReadonly)
+          continue;
+        return false;
+      }
+      if (!IsReadonly && !isForwardDependence(*ClientItr->second, L1, L2))
+        return false;
+      Shared.insert(ClientItr->second);
+    }
+  }
+  return true;
+}
+
+Optional<uint64_t>
+ClangLoopFusion::estimateSavedTraffic(Loop &L, const ReuseMap &Reuse,
+                                      ClangLoopFusionProvider &Provider) {
+  auto &CL = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
+  auto &RI = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto TripCount = getTripCount(**CL.find_as(RI.getRegionFor(&L)));
+  if (!TripCount)
+    return None;
+  uint64_t Bytes = 0;
+  for (auto &A : Reuse) {
+    auto Size = getElementSize(*A.first);
+    if (!Size)
+      return None;
+    Bytes += A.second * *Size * *TripCount;
+  }
+  return Bytes;
+}
+
+bool ClangLoopFusion::fuse(const LoopChain &Chain) {
+  assert(Chain.size() > 1 && "At least two loops must be fused!");
+  auto &Rewriter = mTfmCtx->getRewriter();
+  auto &SrcMgr = Rewriter.getSourceMgr();
+  auto &LangOpts = Rewriter.getLangOpts();
+  auto *First = Chain.front().second;
+  auto *Last = Chain.back().second;
+  for (auto &Link : Chain) {
+    auto Begin = Link.second->getBeginLoc();
+    auto End = Link.second->getEndLoc();
+    if (Begin.isMacroID() || End.isMacroID() ||
+        !SrcMgr.isWrittenInSameFile(Begin, End) ||
+        !SrcMgr.isWrittenInSameFile(First->getBeginLoc(), Begin)) {
+      toDiag(SrcMgr.getDiagnostics(), First->getBeginLoc(),
+             tsar::diag::warn_disable_fusion);
+      toDiag(SrcMgr.getDiagnostics(), Link.second->getBeginLoc(),
+             tsar::diag::note_fusion_macro_prevent);
+      return false;
+    }
+  }
+  std::string Body("{\n");
+  for (auto &Link : Chain) {
+    Body += Lexer::getSourceText(
+                CharSourceRange::getTokenRange(
+                    Link.second->getBody()->getSourceRange()),
+                SrcMgr, LangOpts)
+                .str();
+    Body += "\n";
+  }
+  Body += "}";
+  Rewriter.RemoveText(CharSourceRange::getCharRange(
+      Lexer::getLocForEndOfToken(First->getEndLoc(), 0, SrcMgr, LangOpts),
+      Lexer::getLocForEndOfToken(Last->getEndLoc(), 0, SrcMgr, LangOpts)));
+  Rewriter.ReplaceText(First->getBody()->getSourceRange(), Body);
+  return true;
+}
+
+template <class ItrT>
+void ClangLoopFusion::visitLoops(ItrT I, ItrT EI,
+                                 ClangLoopFusionProvider &Provider,
+                                 const DIClientServerInfo &DIInfo) {
+  auto &ASTCtx = mTfmCtx->getContext();
+  auto &Diags = ASTCtx.getDiagnostics();
+  // Collect candidates and their parents, a parent of each candidate must be
+  // a compound statement to find adjacent loops.
+  DenseMap<const Stmt *, Loop *> Candidates;
+  SmallVector<const CompoundStmt *, 4> Parents;
+  SmallPtrSet<const CompoundStmt *, 4> VisitedParents;
+  for (auto LoopItr = I; LoopItr != EI; ++LoopItr)
+    if (auto *For = getForStmt(**LoopItr, Provider)) {
+      auto ParentList = ASTCtx.getParentMapContext().getParents(*For);
+      if (ParentList.empty())
+        continue;
+      if (auto *Parent = ParentList.begin()->get<CompoundStmt>()) {
+        Candidates.try_emplace(For, *LoopItr);
+        if (VisitedParents.insert(Parent).second)
+          Parents.push_back(Parent);
+      }
+    }
+  SmallPtrSet<Loop *, 8> Fused;
+  LoopChain Chain;
+  ReuseMap Reuse;
+  auto processChain = [this, &Chain, &Reuse, &Fused, &Provider, &Diags]() {
+    if (Chain.size() > 1 && fuse(Chain)) {
+      NumFused += Chain.size();
+      for (auto &Link : Chain)
+        Fused.insert(Link.first);
+      auto Bytes = estimateSavedTraffic(*Chain.front().first, Reuse, Provider);
+      std::string BytesStr = Bytes ? std::to_string(*Bytes) : "unknown";
+      toDiag(Diags, Chain.front().second->getBeginLoc(),
+             tsar::diag::remark_fusion)
+          << static_cast<unsigned>(Chain.size()) << BytesStr;
+      LLVM_DEBUG(dbgs() << "[LOOP FUSION]: fuse " << Chain.size()
+                        << " loops at ";
+                 Chain.front().first->getStartLoc().print(dbgs());
+                 dbgs() << ", estimated memory traffic saved " << BytesStr
+                        << " bytes\n");
+    }
+    Chain.clear();
+    Reuse.clear();
+  };
+  for (auto *Parent : Parents) {
+    for (auto *S : Parent->body()) {
+      auto CandidateItr = Candidates.find(S);
+      if (CandidateItr == Candidates.end()) {
+        processChain();
+        continue;
+      }
+      auto *L = CandidateItr->second;
+      auto *For = cast<ForStmt>(S);
+      if (!Chain.empty()) {
+        SmallPtrSet<DIMemory *, 8> Shared;
+        auto IsFusible = DIInfo && all_of(Chain, [&](auto &Link) {
+          return isConformable(*Link.first, *Link.second, *L, *For,
+                               Provider) &&
+                 isLegal(*Link.first, *L, DIInfo, Shared);
+        });
+        // Fusion is profitable if loops access the same arrays.
+        if (IsFusible && !Shared.empty()) {
+          Chain.emplace_back(L, For);
+          for (auto *A : Shared)
+            ++Reuse[A];
+          continue;
+        }
+        LLVM_DEBUG(dbgs() << "[LOOP FUSION]: unable to fuse loop at ";
+                   L->getStartLoc().print(dbgs()); dbgs() << "\n");
+        processChain();
+      }
+      Chain.emplace_back(L, For);
+    }
+    processChain();
+  }
+  for (; I != EI; ++I)
+    if (!Fused.count(*I))
+      visitLoops((*I)->begin(), (*I)->end(), Provider, DIInfo);
+}
+
+bool ClangLoopFusion::runOnModule(Module &M) {
+  if (!initializeProvider(M))
+    return false;
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.isIntrinsic())
+      continue;
+    LLVM_DEBUG(dbgs() << "[LOOP FUSION]: process function " << F.getName()
+                      << "\n");
+    auto &Provider = getAnalysis<ClangLoopFusionProvider>(F);
+    auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
+    DIClientServerInfo DIInfo(*this, F);
+    visitLoops(LI.begin(), LI.end(), Provider, DIInfo);
+  }
+  return false;
+}
+
+bool ClangLoopDistribution::distribute(
+    Loop &L, ForStmt &For, ClangLoopFusionProvider &Provider,
+    const DIClientServerInfo &DIInfo,
+    const ClonedDIMemoryMatcher &ServerMatcher) {
+  auto &ASTCtx = mTfmCtx->getContext();
+  auto *Body = dyn_cast<CompoundStmt>(For.getBody());
+  if (!Body || Body->size() < 2)
+    return false;
+  if (For.getCond() && For.getCond()->HasSideEffects(ASTCtx))
+    return false;
+  for (auto *S : Body->body())
+    if (isa<DeclStmt>(S))
+      return false;
+  ControlTransferVisitor CTV;
+  CTV.TraverseStmt(Body);
+  if (CTV.hasControlTransfer())
+    return false;
+  auto *LoopID = DIInfo.getObjectID(L.getLoopID());
+  if (!LoopID)
+    return false;
+  auto DepItr = DIInfo.DIDepInfo->find(LoopID);
+  if (DepItr == DIInfo.DIDepInfo->end())
+    return false;
+  auto &DIDepSet = DepItr->get<DIDependenceSet>();
+  DenseSet<const DIAliasNode *> Coverage;
+  accessCoverage<bcl::SimpleInserter>(DIDepSet, *DIInfo.DIAT, Coverage,
+                                      mGlobalOpts->IgnoreRedundantMemory);
+  auto &ASTToClient = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
+  // The last collector describes a loop header.
+  SmallVector<VariableCollector, 8> Collectors(Body->size() + 1);
+  for (auto StmtItr : enumerate(Body->body()))
+    Collectors[StmtItr.index()].TraverseStmt(StmtItr.value());
+  Collectors.back().TraverseStmt(For.getInit());
+  Collectors.back().TraverseStmt(For.getCond());
+  Collectors.back().TraverseStmt(For.getInc());
+  Optional<unsigned> Sequential;
+  for (auto &TS : DIDepSet) {
+    if (!Coverage.count(TS.getNode()) || TS.is<trait::Readonly>() ||
+        TS.is<trait::Induction>())
+      continue;
+    if (TS.is<trait::AddressAccess>())
+      return false;
+    SmallBitVector Refs(Collectors.size());
+    for (auto &T : TS)
+      for (auto CollectorItr : enumerate(Collectors)) {
+        auto Search = CollectorItr.value().findDecl(*T->getMemory(),
+                                                    ASTToClient, ServerMatcher);
+        if (Search.second == VariableCollector::CoincideLocal ||
+            Search.second == VariableCollector::CoincideGlobal ||
+            Search.second == VariableCollector::Derived)
+          Refs.set(CollectorItr.index());
+        else if (Search.second != VariableCollector::Implicit)
+          Refs.set();
+      }
+    // Memory which is written in the loop must be referenced in a single
+    // statement. Otherwise, distribution breaks data flow between
+    // statements.
+    if (Refs.count() > 1 || Refs.test(Collectors.size() - 1))
+      return false;
+    if (Refs.none() || !TS.is_any<trait::Flow, trait::Anti, trait::Output>())
+      continue;
+    auto StmtIdx = Refs.find_first();
+    if (Sequential && *Sequential != static_cast<unsigned>(StmtIdx))
+      return false;
+    Sequential = StmtIdx;
+  }
+  if (!Sequential)
+    return false;
+  auto &Rewriter = mTfmCtx->getRewriter();
+  auto &SrcMgr = Rewriter.getSourceMgr();
+  auto &LangOpts = Rewriter.getLangOpts();
+  if (For.getBeginLoc().isMacroID() || For.getEndLoc().isMacroID() ||
+      !SrcMgr.isWrittenInSameFile(For.getBeginLoc(), For.getEndLoc()) ||
+      any_of(Body->body(), [](Stmt *S) {
+        return S->getBeginLoc().isMacroID() || S->getEndLoc().isMacroID();
+      })) {
+    toDiag(SrcMgr.getDiagnostics(), For.getBeginLoc(),
+           tsar::diag::warn_disable_distribution);
+    toDiag(SrcMgr.getDiagnostics(), For.getBeginLoc(),
+           tsar::diag::note_distribution_macro_prevent);
+    return false;
+  }
+  auto Header = Lexer::getSourceText(
+      CharSourceRange::getTokenRange(For.getBeginLoc(), For.getRParenLoc()),
+      SrcMgr, LangOpts);
+  SmallVector<Stmt *, 8> Stmts(Body->body_begin(), Body->body_end());
+  SmallVector<std::pair<unsigned, unsigned>, 3> Groups;
+  if (*Sequential > 0)
+    Groups.emplace_back(0, *Sequential);
+  Groups.emplace_back(*Sequential, *Sequential + 1);
+  if (*Sequential + 1 < Stmts.size())
+    Groups.emplace_back(*Sequential + 1, Stmts.size());
+  std::string Text;
+  for (auto &G : Groups) {
+    auto Begin = G.first == 0 ? Body->getLBracLoc().getLocWithOffset(1)
+                              : Stmts[G.first]->getBeginLoc();
+    auto End = G.second == Stmts.size() ? Body->getRBracLoc()
+                                        : Stmts[G.second]->getBeginLoc();
+    Text += Header;
+    Text += " {";
+    Text += Lexer::getSourceText(CharSourceRange::getCharRange(Begin, End),
+                                 SrcMgr, LangOpts);
+    Text += "}\n";
+  }
+  Rewriter.ReplaceText(For.getSourceRange(), Text);
+  auto &CL = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
+  auto &RI = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto TripCount = getTripCount(**CL.find_as(RI.getRegionFor(&L)));
+  // Readonly memory may be loaded in each of distributed loops, so memory
+  // traffic may increase.
+  Optional<uint64_t> Bytes = 0;
+  for (auto &TS : DIDepSet) {
+    if (!Coverage.count(TS.getNode()) || !TS.is<trait::Readonly>())
+      continue;
+    for (auto &T : TS) {
+      unsigned NumberOfGroups = 0;
+      for (auto &G : Groups)
+        for (unsigned Idx = G.first; Idx < G.second; ++Idx) {
+          auto Search = Collectors[Idx].findDecl(*T->getMemory(), ASTToClient,
+                                                 ServerMatcher);
+          if (Search.second != VariableCollector::Implicit) {
+            ++NumberOfGroups;
+            break;
+          }
+        }
+      if (NumberOfGroups < 2)
+        continue;
+      auto Size = getElementSize(*T->getMemory());
+      if (!Size || !TripCount || !Bytes) {
+        Bytes = None;
+        break;
+      }
+      *Bytes += (NumberOfGroups - 1) * *Size * *TripCount;
+    }
+  }
+  std::string BytesStr = Bytes ? std::to_string(*Bytes) : "unknown";
+  toDiag(SrcMgr.getDiagnostics(), For.getBeginLoc(),
+         tsar::diag::remark_distribution)
+      << static_cast<unsigned>(Groups.size()) << BytesStr;
+  LLVM_DEBUG(dbgs() << "[LOOP DISTRIBUTION]: distribute loop at ";
+             L.getStartLoc().print(dbgs());
+             dbgs() << " into " << Groups.size()
+                    << " loops, estimated extra memory traffic " << BytesStr
+                    << " bytes\n");
+  return true;
+}
+
+template <class ItrT>
+void ClangLoopDistribution::visitLoops(
+    ItrT I, ItrT EI, ClangLoopFusionProvider &Provider,
+    const DIClientServerInfo &DIInfo,
+    const ClonedDIMemoryMatcher *ServerMatcher) {
+  auto &PL = Provider.get<ParallelLoopPass>().getParallelLoopInfo();
+  for (; I != EI; ++I) {
+    // It is not necessary to distribute loops which can be parallelized.
+    if (!PL.count(*I) && DIInfo && ServerMatcher)
+      if (auto *For = getForStmt(**I, Provider))
+        if (distribute(**I, *For, Provider, DIInfo, *ServerMatcher)) {
+          ++NumDistributed;
+          continue;
+        }
+    visitLoops((*I)->begin(), (*I)->end(), Provider, DIInfo, ServerMatcher);
+  }
+}
+
+bool ClangLoopDistribution::runOnModule(Module &M) {
+  if (!initializeProvider(M))
+    return false;
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.isIntrinsic())
+      continue;
+    LLVM_DEBUG(dbgs() << "[LOOP DISTRIBUTION]: process function "
+                      << F.getName() << "\n");
+    auto &Provider = getAnalysis<ClangLoopFusionProvider>(F);
+    auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
+    DIClientServerInfo DIInfo(*this, F);
+    // Server-side memory must be matched to source-level variables.
+    const ClonedDIMemoryMatcher *ServerMatcher = nullptr;
+    if (auto *Socket = mSocketInfo->getActiveSocket())
+      if (auto R = Socket->getAnalysis<AnalysisClientServerMatcherWrapper,
+                                       ClonedDIMemoryMatcherWrapper>()) {
+        auto *ServerF = cast_or_null<Function>(DIInfo.getValue(&F));
+        if (ServerF)
+          ServerMatcher =
+              (**R->value<ClonedDIMemoryMatcherWrapper *>())[*ServerF];
+      }
+    visitLoops(LI.begin(), LI.end(), Provider, DIInfo, ServerMatcher);
+  }
+  return false;
+}
@@ -0,0 +1,434 @@
+//===- LoopInterchange.cpp - Source-level Loop Interchange ------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2021 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass to reorder loops in perfect loop nests. The goal
+// is to make the innermost loop traverse the fastest-varying (the last in C)
+// dimension of arrays accessed in the nest. Headers of loops are permuted in
+// a source code, bodies of loops remain unchanged.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SharedMemoryAutoPar.h"
+#include "tsar/Analysis/AnalysisServer.h"
+#include "tsar/Analysis/Clang/CanonicalLoop.h"
+#include "tsar/Analysis/Clang/LoopMatcher.h"
+#include "tsar/Analysis/Clang/MemoryMatcher.h"
+#include "tsar/Analysis/Clang/PerfectLoop.h"
+#include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/Memory/DIArrayAccess.h"
+#include "tsar/Analysis/Memory/DIClientServerInfo.h"
+#include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
+#include "tsar/Analysis/Memory/DIMemoryTrait.h"
+#include "tsar/Analysis/Memory/MemoryTraitUtils.h"
+#include "tsar/Analysis/Memory/PassAAProvider.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Core/TransformationContext.h"
+#include "tsar/Frontend/Clang/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Transform/Clang/Passes.h"
+#include <clang/AST/Stmt.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Support/Debug.h>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-loop-interchange"
+
+STATISTIC(NumNests, "Number of perfect loop nests analyzed");
+STATISTIC(NumInterchanged, "Number of interchanged loop nests");
+
+namespace {
+using ClangLoopInterchangeProvider =
+    FunctionPassAAProvider<LoopInfoWrapperPass, CanonicalLoopPass,
+                           LoopMatcherPass, DFRegionInfoPass,
+                           ClangPerfectLoopPass>;
+
+/// This pass reorders loops in perfect loop nests to obtain stride-1 accesses
+/// in the innermost loop.
+class ClangLoopInterchange : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ClangLoopInterchange() : ModulePass(ID) {
+    initializeClangLoopInterchangePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override {
+    mTfmCtx = nullptr;
+    mGlobalOpts = nullptr;
+    mAccessInfo = nullptr;
+  }
+
+private:
+  /// Loop nest from the outermost to the innermost loop.
+  using LoopNest = SmallVector<Loop *, 4>;
+
+  /// Permutation of loops in a nest: the I-th loop of the new nest is
+  /// the Permutation[I]-th loop of the original one.
+  using Permutation = SmallVector<unsigned, 4>;
+
+  /// Find perfect loop nests in a specified range of loops and try to
+  /// interchange them.
+  template <class ItrT>
+  void visitLoops(ItrT I, ItrT EI, ClangLoopInterchangeProvider &Provider,
+                  const DIClientServerInfo &DIInfo);
+
+  /// Check whether a loop nest should be interchanged, compute the best
+  /// permutation and return it (None if the order of loops remains unchanged).
+  Optional<Permutation> computePermutation(const LoopNest &Nest);
+
+  /// Return true if all data dependencies in the nest permit a specified
+  /// permutation.
+  bool isLegal(const LoopNest &Nest, const Permutation &Perm,
+               const DIClientServerInfo &DIInfo);
+
+  /// Permute headers of loops in a source code.
+  bool interchange(const LoopNest &Nest, const Permutation &Perm,
+                   ClangLoopInterchangeProvider &Provider);
+
+  ClangTransformationContext *mTfmCtx = nullptr;
+  const GlobalOptions *mGlobalOpts = nullptr;
+  DIArrayAccessInfo *mAccessInfo = nullptr;
+};
+} // namespace
+
+char ClangLoopInterchange::ID = 0;
+INITIALIZE_PROVIDER(ClangLoopInterchangeProvider,
+                    "clang-loop-interchange-provider",
+                    "Loop Interchange (Clang, Provider)")
+
+INITIALIZE_PASS_IN_GROUP_BEGIN(ClangLoopInterchange, "clang-loop-interchange",
+  "Loop Interchange (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+INITIALIZE_PASS_IN_GROUP_INFO(ClangSMParallelizationInfo)
+INITIALIZE_PASS_DEPENDENCY(ClangLoopInterchangeProvider)
+INITIALIZE_PASS_DEPENDENCY(AnalysisSocketImmutableWrapper)
+INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_DEPENDENCY(GlobalsAAWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DIMemoryEnvironmentWrapper)
+INITIALIZE_PASS_DEPENDENCY(DIArrayAccessWrapper)
+INITIALIZE_PASS_IN_GROUP_END(ClangLoopInterchange, "clang-loop-interchange",
+  "Loop Interchange (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+
+ModulePass *llvm::createClangLoopInterchange() {
+  return new ClangLoopInterchange;
+}
+
+void ClangLoopInterchange::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<ClangLoopInterchangeProvider>();
+  AU.addRequired<AnalysisSocketImmutableWrapper>();
+  AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<MemoryMatcherImmutableWrapper>();
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.addRequired<GlobalsAAWrapperPass>();
+  AU.addRequired<DIMemoryEnvironmentWrapper>();
+  AU.addRequired<DIArrayAccessWrapper>();
+  AU.setPreservesAll();
+}
+
+Optional<ClangLoopInterchange::Permutation>
+ClangLoopInterchange::computePermutation(const LoopNest &Nest) {
+  if (!mAccessInfo)
+    return None;
+  // Score of a loop is a number of accesses which have unit stride along
+  // the last dimension of an array if this loop is the innermost one. Each
+  // access which uses the loop to index other dimensions reduces score.
+  SmallVector<int, 4> Score(Nest.size(), 0);
+  for (auto &Access : mAccessInfo->scope_accesses(Nest.back()->getLoopID())) {
+    if (Access.empty())
+      continue;
+    for (auto *Subscript : Access) {
+      auto *Affine = dyn_cast_or_null<DIAffineSubscript>(Subscript);
+      if (!Affine)
+        continue;
+      bool IsLastDim = Affine->getDimension() + 1 == Access.size();
+      for (unsigned MIdx = 0, MIdxE = Affine->getNumberOfMonoms(); MIdx < MIdxE;
+           ++MIdx) {
+        auto Monom = Affine->getMonom(MIdx);
+        auto LevelItr = find_if(Nest, [&Monom](const Loop *L) {
+          return L->getLoopID() == Monom.Column;
+        });
+        if (LevelItr == Nest.end())
+          continue;
+        unsigned Level = std::distance(Nest.begin(), LevelItr);
+        if (!IsLastDim)
+          --Score[Level];
+        else if (Monom.Value.abs() == 1)
+          ++Score[Level];
+      }
+    }
+  }
+  LLVM_DEBUG(dbgs() << "[LOOP INTERCHANGE]: score of loops in the nest:";
+             for (auto S : Score) dbgs() << " " << S; dbgs() << "\n");
+  auto BestItr = std::max_element(Score.begin(), Score.end());
+  unsigned Best = std::distance(Score.begin(), BestItr);
+  if (*BestItr <= Score.back())
+    return None;
+  Permutation Perm;
+  for (unsigned Level = 0, LevelE = Nest.size(); Level < LevelE; ++Level)
+    if (Level != Best)
+      Perm.push_back(Level);
+  Perm.push_back(Best);
+  return Perm;
+}
+
+/// Return true if a distance vector remains lexicographically nonnegative
+/// after a specified permutation.
+///
+/// Distances at levels [0, Level) are assumed to be zero, the first distance
+/// in the vector corresponds to the `Level`-th loop in the nest.
+static bool isLexNonNegative(const trait::DIDependence &Dep, unsigned Level,
+                             ArrayRef<unsigned> Perm) {
+  if (Dep.getKnownLevel() + Level < Perm.size())
+    return false;
+  for (auto Idx : Perm) {
+    if (Idx < Level)
+      continue;
+    auto Range = Dep.getDistance(Idx - Level);
+    assert(Range.first && Range.second && "Distance must be known!");
+    // The dependence is carried by the current loop, so, it is satisfied
+    // regardless of distances of inner loops.
+    if (Range.first->isStrictlyPositive())
+      return true;
+    // Possible negative distance makes the dependence backward.
+    if (Range.first->isNegative())
+      return false;
+  }
+  return true;
+}
+
+bool ClangLoopInterchange::isLegal(const LoopNest &Nest,
+                                   const Permutation &Perm,
+                                   const DIClientServerInfo &DIInfo) {
+  for (unsigned Level = 0, LevelE = Nest.size(); Level < LevelE; ++Level) {
+    auto *LoopID = DIInfo.getObjectID(Nest[Level]->getLoopID());
+    if (!LoopID)
+      return false;
+    auto DepItr = DIInfo.DIDepInfo->find(LoopID);
+    if (DepItr == DIInfo.DIDepInfo->end())
+      return false;
+    auto &DIDepSet = DepItr->get<DIDependenceSet>();
+    DenseSet<const DIAliasNode *> Coverage;
+    accessCoverage<bcl::SimpleInserter>(DIDepSet, *DIInfo.DIAT, Coverage,
+                                        mGlobalOpts->IgnoreRedundantMemory);
+    for (auto &TS : DIDepSet) {
+      if (!Coverage.count(TS.getNode()))
+        continue;
+      if (TS.is<trait::AddressAccess>())
+        return false;
+      if (!TS.is_any<trait::Flow, trait::Anti, trait::Output>())
+        continue;
+      for (auto &T : TS) {
+        auto check = [Level, &Perm, &T](auto Kind) {
+          if (!T->is<decltype(Kind)>())
+            return true;
+          auto *Dep = T->get<decltype(Kind)>();
+          return Dep && Dep->isKnownDistance() &&
+                 isLexNonNegative(*Dep, Level, Perm);
+        };
+        if (!check(trait::Flow{}) || !check(trait::Anti{}) ||
+            !check(trait::Output{}))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool ClangLoopInterchange::interchange(const LoopNest &Nest,
+                                       const Permutation &Perm,
+                                       ClangLoopInterchangeProvider &Provider) {
+  auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
+  auto &Rewriter = mTfmCtx->getRewriter();
+  auto &SrcMgr = Rewriter.getSourceMgr();
+  auto &LangOpts = Rewriter.getLangOpts();
+  SmallVector<CharSourceRange, 4> Headers;
+  for (auto *L : Nest) {
+    auto MatchItr = LM.find<IR>(L);
+    auto *For = cast<ForStmt>(MatchItr->get<AST>());
+    auto LParenLoc = For->getLParenLoc();
+    auto RParenLoc = For->getRParenLoc();
+    if (LParenLoc.isMacroID() || RParenLoc.isMacroID() ||
+        !SrcMgr.isWrittenInSameFile(LParenLoc, RParenLoc)) {
+      toDiag(SrcMgr.getDiagnostics(), For->getBeginLoc(),
+             tsar::diag::warn_disable_interchange);
+      toDiag(SrcMgr.getDiagnostics(), For->getBeginLoc(),
+             tsar::diag::note_interchange_macro_prevent);
+      return false;
+    }
+    Headers.push_back(
+        CharSourceRange::getCharRange(LParenLoc.getLocWithOffset(1), RParenLoc));
+  }
+  SmallVector<std::string, 4> HeaderText;
+  for (auto &Range : Headers)
+    HeaderText.push_back(Lexer::getSourceText(Range, SrcMgr, LangOpts).str());
+  for (unsigned Level = 0, LevelE = Nest.size(); Level < LevelE; ++Level) {
+    if (Perm[Level] == Level)
+      continue;
+    Rewriter.ReplaceText(Headers[Level].getBegin(),
+                         Rewriter.getRangeSize(Headers[Level]),
+                         HeaderText[Perm[Level]]);
+  }
+  return true;
+}
+
+template <class ItrT>
+void ClangLoopInterchange::visitLoops(ItrT I, ItrT EI,
+                                      ClangLoopInterchangeProvider &Provider,
+                                      const DIClientServerInfo &DIInfo) {
+  auto &CL = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
+  auto &RI = Provider.get<DFRegionInfoPass>().getRegionInfo();
+  auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
+  auto &PLI = Provider.get<ClangPerfectLoopPass>().getPerfectLoopInfo();
+  auto &Diags = mTfmCtx->getContext().getDiagnostics();
+  for (; I != EI; ++I) {
+    LoopNest Nest;
+    Nest.push_back(*I);
+    while (Nest.back()->getSubLoops().size() == 1 &&
+           PLI.count(RI.getRegionFor(Nest.back())))
+      Nest.push_back(Nest.back()->getSubLoops().front());
+    if (Nest.size() < 2) {
+      visitLoops(Nest.back()->begin(), Nest.back()->end(), Provider, DIInfo);
+      continue;
+    }
+    ++NumNests;
+    auto *OuterFor = [&LM, L = Nest.front()]() -> Stmt * {
+      auto MatchItr = LM.find<IR>(L);
+      return MatchItr != LM.end() ? MatchItr->get<AST>() : nullptr;
+    }();
+    auto IsCanonical = all_of(Nest, [&CL, &RI, &LM](Loop *L) {
+      auto CanonItr = CL.find_as(RI.getRegionFor(L));
+      return L->getLoopID() && LM.find<IR>(L) != LM.end() &&
+             CanonItr != CL.end() && (**CanonItr).isCanonical() &&
+             (**CanonItr).getASTLoop() &&
+             isa_and_nonnull<SCEVConstant>((**CanonItr).getStep());
+    });
+    if (!OuterFor || !IsCanonical) {
+      LLVM_DEBUG(dbgs() << "[LOOP INTERCHANGE]: nest is not canonical at ";
+                 Nest.front()->getStartLoc().print(dbgs()); dbgs() << "\n");
+      // Perfect sub-nests which start at inner loops may be still canonical.
+      visitLoops(Nest.front()->begin(), Nest.front()->end(), Provider, DIInfo);
+      continue;
+    }
+    auto Perm = computePermutation(Nest);
+    if (!Perm) {
+      LLVM_DEBUG(dbgs() << "[LOOP INTERCHANGE]: unprofitable interchange at ";
+                 Nest.front()->getStartLoc().print(dbgs()); dbgs() << "\n");
+      continue;
+    }
+    // Bounds of each loop must be invariant in the whole nest.
+    auto IsRectangular = all_of(Nest, [&CL, &RI, &Nest](Loop *L) {
+      auto &Info = **CL.find_as(RI.getRegionFor(L));
+      return Info.getStart() && Info.getEnd() &&
+             Nest.front()->isLoopInvariant(Info.getStart()) &&
+             Nest.front()->isLoopInvariant(Info.getEnd());
+    });
+    if (!IsRectangular) {
+      toDiag(Diags, OuterFor->getBeginLoc(),
+             tsar::diag::warn_disable_interchange);
+      toDiag(Diags, OuterFor->getBeginLoc(),
+             tsar::diag::note_interchange_not_rectangular);
+      continue;
+    }
+    if (!DIInfo || !isLegal(Nest, *Perm, DIInfo)) {
+      toDiag(Diags, OuterFor->getBeginLoc(),
+             tsar::diag::warn_disable_interchange);
+      toDiag(Diags, OuterFor->getBeginLoc(),
+             tsar::diag::note_interchange_dependence);
+      continue;
+    }
+    if (!interchange(Nest, *Perm, Provider))
+      continue;
+    ++NumInterchanged;
+    std::string PermStr;
+    raw_string_ostream OS(PermStr);
+    OS << "(";
+    interleaveComma(*Perm, OS);
+    OS << ")";
+    toDiag(Diags, OuterFor->getBeginLoc(), tsar::diag::remark_interchange)
+        << OS.str();
+    LLVM_DEBUG(dbgs() << "[LOOP INTERCHANGE]: apply permutation " << OS.str()
+                      << " at "; Nest.front()->getStartLoc().print(dbgs());
+               dbgs() << "\n");
+  }
+}
+
+bool ClangLoopInterchange::runOnModule(Module &M) {
+  releaseMemory();
+  auto &TfmInfo = getAnalysis<TransformationEnginePass>();
+  mTfmCtx = TfmInfo ? TfmInfo->getContext(M) : nullptr;
+  if (!mTfmCtx || !mTfmCtx->hasInstance()) {
+    M.getContext().emitError("can not transform sources"
+                             ": transformation context is not available");
+    return false;
+  }
+  auto &SocketInfo = getAnalysis<AnalysisSocketImmutableWrapper>().get();
+  auto &MemoryMatcher = getAnalysis<MemoryMatcherImmutableWrapper>().get();
+  auto &GlobalsAA = getAnalysis<GlobalsAAWrapperPass>().getResult();
+  auto &DIMEnv = getAnalysis<DIMemoryEnvironmentWrapper>().get();
+  mGlobalOpts = &getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  mAccessInfo = getAnalysis<DIArrayAccessWrapper>().getAccessInfo();
+  ClangLoopInterchangeProvider::initialize<GlobalOptionsImmutableWrapper>(
+      [this](GlobalOptionsImmutableWrapper &Wrapper) {
+        Wrapper.setOptions(mGlobalOpts);
+      });
+  ClangLoopInterchangeProvider::initialize<AnalysisSocketImmutableWrapper>(
+      [&SocketInfo](AnalysisSocketImmutableWrapper &Wrapper) {
+        Wrapper.set(SocketInfo);
+      });
+  ClangLoopInterchangeProvider::initialize<TransformationEnginePass>(
+      [&TfmInfo](TransformationEnginePass &Wrapper) {
+        Wrapper.set(TfmInfo.get());
+      });
+  ClangLoopInterchangeProvider::initialize<MemoryMatcherImmutableWrapper>(
+      [&MemoryMatcher](MemoryMatcherImmutableWrapper &Wrapper) {
+        Wrapper.set(MemoryMatcher);
+      });
+  ClangLoopInterchangeProvider::initialize<GlobalsAAResultImmutableWrapper>(
+      [&GlobalsAA](GlobalsAAResultImmutableWrapper &Wrapper) {
+        Wrapper.set(GlobalsAA);
+      });
+  ClangLoopInterchangeProvider::initialize<DIMemoryEnvironmentWrapper>(
+      [&DIMEnv](DIMemoryEnvironmentWrapper &Wrapper) { Wrapper.set(DIMEnv); });
+  for (auto &F : M) {
+    if (F.isDeclaration() || F.isIntrinsic())
+      continue;
+    LLVM_DEBUG(dbgs() << "[LOOP INTERCHANGE]: process function " << F.getName()
+                      << "\n");
+    auto &Provider = getAnalysis<ClangLoopInterchangeProvider>(F);
+    auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
+    DIClientServerInfo DIInfo(*this, F);
+    visitLoops(LI.begin(), LI.end(), Provider, DIInfo);
+  }
+  return false;
+}
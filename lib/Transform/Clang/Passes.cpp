@@ -35,4 +35,7 @@ void llvm::initializeClangTransform(PassRegistry &Registry) {
   initializeClangDeadDeclsEliminationPass(Registry);
   initializeClangOpenMPParallelizationPass(Registry);
   initializeClangDVMHSMParallelizationPass(Registry);
+  initializeClangLoopInterchangePass(Registry);
+  initializeClangLoopFusionPass(Registry);
+  initializeClangLoopDistributionPass(Registry);
 }
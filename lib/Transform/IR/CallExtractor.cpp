@@ -21,10 +21,18 @@
 // This file implements a pass to extract each call instruction
 // (except debug instructions) into its own new basic block.
 //
+// Interprocedural analysis uses data-flow values of a basic block which
+// contains a call to obtain memory which is live after the call. However,
+// each extracted call increases the number of nodes in data-flow graphs.
+// So, in sparse mode only calls of functions with bodies (which are
+// analyzed interprocedurally) are extracted and other calls are kept in place.
+//
 //===---------------------------------------------------------------------===//
 #include "tsar/Transform/IR/Passes.h"
 #include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Support/GlobalOptions.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/Pass.h>
@@ -49,6 +57,10 @@ public:
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "extract-call"
 
+STATISTIC(NumExtractedCalls, "Number of calls extracted into new blocks");
+STATISTIC(NumKeptCalls, "Number of calls kept in place in sparse mode");
+STATISTIC(NumNewBlocks, "Number of basic blocks created to extract calls");
+
 char CallExtractorPass::ID = 0;
 INITIALIZE_PASS(CallExtractorPass, "extract-call",
   "Extract calls into new basic block", false, false)
@@ -57,11 +69,21 @@ FunctionPass * llvm::createCallExtractorPass() {
   return new CallExtractorPass();
 }
 
-inline static CallInst * needToExtract(Instruction *Inst) {
+inline static CallInst * needToExtract(Instruction *Inst, bool IsSparse) {
+  CallInst *Call = nullptr;
   if (auto *II = dyn_cast<IntrinsicInst>(Inst))
-    return isMemoryMarkerIntrinsic(II->getIntrinsicID()) ||
+    Call = isMemoryMarkerIntrinsic(II->getIntrinsicID()) ||
       isDbgInfoIntrinsic(II->getIntrinsicID()) ? nullptr : cast<CallInst>(Inst);
-  return dyn_cast<CallInst>(Inst);
+  else
+    Call = dyn_cast<CallInst>(Inst);
+  if (!Call || !IsSparse)
+    return Call;
+  auto *Callee =
+    dyn_cast<Function>(Call->getCalledOperand()->stripPointerCasts());
+  if (Callee && !Callee->isDeclaration())
+    return Call;
+  ++NumKeptCalls;
+  return nullptr;
 }
 
 inline static Instruction *getNextUsefulInstruction(Instruction *Inst) {
@@ -78,6 +100,8 @@ inline static Instruction *getNextUsefulInstruction(Instruction *Inst) {
 bool CallExtractorPass::runOnFunction(Function& F) {
   LLVM_DEBUG(dbgs() << "[EXTRACT CALL]: start processing of the function "
                     << F.getName() << "\n");
+  auto *GOP = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+  bool IsSparse = GOP && GOP->getOptions().SparseCallExtraction;
   if (!F.empty()) {
     for (auto CurrBB = F.begin(), LastBB = F.end();
         CurrBB != LastBB; ++CurrBB) {
@@ -85,20 +109,27 @@ bool CallExtractorPass::runOnFunction(Function& F) {
       if (TermInst == nullptr || CurrBB->size() < 2)
         continue;
       auto CurrInstr = CurrBB->begin();
-      if (auto CallCurrInst = needToExtract(&*CurrInstr)) {
+      if (auto CallCurrInst = needToExtract(&*CurrInstr, IsSparse)) {
         auto NextInstr = getNextUsefulInstruction(CallCurrInst);
         assert(NextInstr && "Instruction must not be null!");
-        if (NextInstr != TermInst)
+        if (NextInstr != TermInst) {
           CurrBB->splitBasicBlock(NextInstr);
+          ++NumNewBlocks;
+          ++NumExtractedCalls;
+        }
       } else {
         for (Instruction* I = &*(++CurrInstr); I != TermInst;
              ++CurrInstr, I = &*CurrInstr) {
-          if (auto* CallCurrInst = needToExtract(I)) {
+          if (auto* CallCurrInst = needToExtract(I, IsSparse)) {
             BasicBlock* NewBB = CurrBB->splitBasicBlock(CallCurrInst);
+            ++NumNewBlocks;
+            ++NumExtractedCalls;
             auto NextInstr = getNextUsefulInstruction(CallCurrInst);
             assert(NextInstr && "Instruction must not be null!");
-            if (NextInstr != TermInst)
+            if (NextInstr != TermInst) {
               NewBB->splitBasicBlock(NextInstr);
+              ++NumNewBlocks;
+            }
             break;
           }
         }
@@ -21,6 +21,12 @@
 // This file implements a custom inliner that handles only functions which
 // prevent data dependence analysis.
 //
+// Instead of inlining a call may be redirected to a specialized clone of
+// the callee. Clones are created for each aliasing context of pointer
+// arguments. In a clone arguments which point to distinct not captured
+// objects are marked as 'noalias', so the callee and the caller can be
+// analyzed separately, and the IR grows much slower than after inlining.
+//
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Attributes.h"
@@ -34,21 +40,36 @@
 #include "tsar/Transform/IR/InterprocAttr.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/Profiler.h"
 #include "tsar/Transform/IR/Passes.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/CFG.h>
 #include <llvm/Analysis/InlineCost.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/Analysis/CallGraph.h>
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/InitializePasses.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Transforms/IPO/Inliner.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <map>
 
 #define DEBUG_TYPE "dependence-inline"
 
 STATISTIC(CallsToInline, "Number of calls to inline");
+STATISTIC(CallsSpecialized, "Number of calls redirected to specialized clones");
+STATISTIC(NumSpecializations, "Number of specialized clones");
+STATISTIC(InlineIRGrowth, "Number of instructions added by inlining");
+STATISTIC(SpecializeIRGrowth, "Number of instructions added by specialization");
 
 using namespace llvm;
 using namespace tsar;
@@ -89,10 +110,29 @@ public:
   }
 
 private:
+  /// Aliasing context of a call: positions of arguments which can be marked
+  /// as 'noalias' in a specialized callee.
+  using AliasingContext = std::vector<unsigned>;
+
   void evaluateCostOnSCC(CallGraphSCC &SCC);
 
+  /// Redirect calls which should be inlined to specialized clones of callees
+  /// if it is possible.
+  bool specializeCalls(CallGraphSCC &SCC);
+
+  /// Compute aliasing context of a call.
+  AliasingContext computeAliasingContext(CallBase &CB, const DominatorTree &DT,
+                                         AAResults &AA) const;
+
+  /// Return a clone of a function specialized for a specified context.
+  Function *getOrCreateSpecialization(Function &Callee,
+                                      const AliasingContext &Context,
+                                      CallGraph &CG);
+
   DenseMap<Function *, unsigned> mAnalysisCost;
   unsigned mCurrentSCCCost;
+  std::map<std::pair<Function *, AliasingContext>, Function *>
+      mSpecializations;
 };
 }
 
@@ -131,6 +171,7 @@ INITIALIZE_PASS_DEPENDENCY(AssumptionCacheTracker)
 INITIALIZE_PASS_DEPENDENCY(CallGraphWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(ProfileSummaryInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_END(DependenceInlinerPass, "dependence-inline",
   "Inliner for Dependence Analysis", false, false)
 
@@ -165,16 +206,187 @@ void DependenceInlinerPass::evaluateCostOnSCC(CallGraphSCC &SCC) {
   }
 }
 
+namespace {
+/// Check whether a pointer may be captured before a specified call.
+///
+/// In contrast to PointerMayBeCapturedBefore() any use of a pointer as
+/// an argument of a call (except calls of intrinsics) is treated as a capture
+/// even if the argument is marked 'nocapture'.
+struct CapturedBeforeCallTracker : public CaptureTracker {
+  CapturedBeforeCallTracker(const CallBase &CB, const DominatorTree &DT)
+      : Call(CB), DT(DT) {}
+
+  void tooManyUses() override { Captured = true; }
+
+  bool shouldExplore(const Use *U) override {
+    auto *I = dyn_cast<Instruction>(U->getUser());
+    if (!I)
+      return true;
+    if (I == &Call || !isPotentiallyReachable(I, &Call, nullptr, &DT))
+      return false;
+    if (auto *CB = dyn_cast<CallBase>(I))
+      if (!isa<IntrinsicInst>(CB) && CB->isArgOperand(U)) {
+        Captured = true;
+        return false;
+      }
+    return true;
+  }
+
+  bool captured(const Use *U) override {
+    Captured = true;
+    return true;
+  }
+
+  const CallBase &Call;
+  const DominatorTree &DT;
+  bool Captured = false;
+};
+}
+
+DependenceInlinerPass::AliasingContext
+DependenceInlinerPass::computeAliasingContext(CallBase &CB,
+                                              const DominatorTree &DT,
+                                              AAResults &AA) const {
+  auto *Callee = CB.getCalledFunction();
+  assert(Callee && "Callee must be known!");
+  auto NumArgs = std::min<unsigned>(CB.arg_size(), Callee->arg_size());
+  // Underlying objects of each pointer argument (the list is empty if
+  // an argument is not a pointer).
+  SmallVector<SmallVector<const Value *, 4>, 8> Objects(NumArgs);
+  for (unsigned I = 0; I < NumArgs; ++I)
+    if (CB.getArgOperand(I)->getType()->isPointerTy())
+      getUnderlyingObjects(CB.getArgOperand(I), Objects[I]);
+  auto isLocalNotCaptured = [&CB, &DT](const Value *V) {
+    if (!isIdentifiedFunctionLocal(V))
+      return false;
+    CapturedBeforeCallTracker Tracker(CB, DT);
+    PointerMayBeCaptured(V, &Tracker);
+    return !Tracker.Captured;
+  };
+  AliasingContext Context;
+  for (unsigned I = 0; I < NumArgs; ++I) {
+    if (Objects[I].empty() ||
+        !Callee->hasParamAttribute(I, Attribute::NoCapture))
+      continue;
+    // Only objects which are local for a caller can be checked. Other
+    // objects may be accessed in a callee without the use of arguments.
+    if (!all_of(Objects[I], isLocalNotCaptured))
+      continue;
+    // Each other pointer argument must point to different objects. If it is
+    // not evident from the lists of identified underlying objects use alias
+    // analysis.
+    auto isDisjoint = [&CB, &AA, &Objects, I](unsigned J) {
+      if (all_of(Objects[J],
+                 [&Objects, I](const Value *V) {
+                   return isIdentifiedObject(V) && !is_contained(Objects[I], V);
+                 }))
+        return true;
+      MemoryLocation LocI(CB.getArgOperand(I), MemoryLocation::UnknownSize);
+      MemoryLocation LocJ(CB.getArgOperand(J), MemoryLocation::UnknownSize);
+      return AA.alias(LocI, LocJ) == NoAlias;
+    };
+    bool IsNoAlias = true;
+    for (unsigned J = 0; J < NumArgs && IsNoAlias; ++J)
+      if (J != I && !Objects[J].empty())
+        IsNoAlias = isDisjoint(J);
+    if (IsNoAlias)
+      Context.push_back(I);
+  }
+  return Context;
+}
+
+Function *DependenceInlinerPass::getOrCreateSpecialization(
+    Function &Callee, const AliasingContext &Context, CallGraph &CG) {
+  auto Itr = mSpecializations.try_emplace(std::make_pair(&Callee, Context));
+  if (!Itr.second)
+    return Itr.first->second;
+  ValueToValueMapTy VMap;
+  auto *Clone = CloneFunction(&Callee, VMap);
+  // A specialization has no AST counterpart, so source-level consumers do not
+  // find a declaration for it and results for a clone remain at IR level.
+  Clone->setName(Callee.getName() + ".spec");
+  Clone->setLinkage(GlobalValue::InternalLinkage);
+  for (auto ArgNo : Context)
+    Clone->addParamAttr(ArgNo, Attribute::NoAlias);
+  CG.addToCallGraph(Clone);
+  Itr.first->second = Clone;
+  ++NumSpecializations;
+  SpecializeIRGrowth += Clone->getInstructionCount();
+  addProfileCounter("specialization IR growth", *Clone,
+                    Clone->getInstructionCount());
+  LLVM_DEBUG(dbgs() << "[DEPENDENCE INLINER]: create specialization "
+                    << Clone->getName() << " with " << Context.size()
+                    << " noalias arguments\n");
+  return Clone;
+}
+
+bool DependenceInlinerPass::specializeCalls(CallGraphSCC &SCC) {
+  auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  auto InlineMDKind = CG.getModule().getContext().getMDKindID(
+      getAsString(AttrKind::Inline));
+  SmallPtrSet<Function *, 8> SCCFunctions;
+  for (auto *CGN : SCC)
+    if (auto *F{CGN->getFunction()})
+      SCCFunctions.insert(F);
+  LegacyAARGetter AARGetter(*this);
+  bool IsChanged = false;
+  for (auto *CGN : SCC) {
+    auto *F = CGN->getFunction();
+    if (!F || F->isDeclaration())
+      continue;
+    SmallVector<CallBase *, 8> Calls;
+    for (auto &I : instructions(F))
+      if (auto *CB = dyn_cast<CallBase>(&I))
+        if (CB->hasMetadata(InlineMDKind))
+          if (auto *Callee = CB->getCalledFunction())
+            if (!Callee->isDeclaration() && !SCCFunctions.count(Callee))
+              Calls.push_back(CB);
+    if (Calls.empty())
+      continue;
+    DominatorTree DT(*F);
+    auto &AA = AARGetter(*F);
+    for (auto *CB : Calls) {
+      auto Context = computeAliasingContext(*CB, DT, AA);
+      // There is no additional information in the specialized clone, so
+      // the call will be inlined if it is profitable.
+      if (Context.empty())
+        continue;
+      auto *Clone =
+          getOrCreateSpecialization(*CB->getCalledFunction(), Context, CG);
+      CB->setCalledFunction(Clone);
+      CB->setMetadata(InlineMDKind, nullptr);
+      CGN->replaceCallEdge(*CB, *CB, CG[Clone]);
+      ++CallsSpecialized;
+      IsChanged = true;
+    }
+  }
+  return IsChanged;
+}
+
 bool DependenceInlinerPass::runOnSCC(CallGraphSCC &SCC) {
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  bool IsChanged = false;
+  if (GO.InlineStrategy == GlobalOptions::ISK_Specialize)
+    IsChanged |= specializeCalls(SCC);
   evaluateCostOnSCC(SCC);
+  SmallDenseMap<Function *, unsigned, 8> SizeBefore;
   for (auto &CGN : SCC)
-    if (auto *F{CGN->getFunction()})
+    if (auto *F{CGN->getFunction()}) {
       mAnalysisCost[F] = mCurrentSCCCost;
-  auto Res = inlineCalls(SCC);
+      SizeBefore.try_emplace(F, F->getInstructionCount());
+    }
+  IsChanged |= inlineCalls(SCC);
   for (auto &CGN : SCC)
-    if (auto *F{CGN->getFunction()})
+    if (auto *F{CGN->getFunction()}) {
       mAnalysisCost[F] = mCurrentSCCCost;
-  return Res;
+      auto Size = F->getInstructionCount();
+      auto Itr = SizeBefore.find(F);
+      if (Itr != SizeBefore.end() && Size > Itr->second) {
+        InlineIRGrowth += Size - Itr->second;
+        addProfileCounter("inline IR growth", *F, Size - Itr->second);
+      }
+    }
+  return IsChanged;
 }
 
 InlineCost DependenceInlinerPass::getInlineCost(CallBase &CB) {
@@ -0,0 +1,367 @@
+//===--- Bench.cpp ------- Analysis Pipeline Benchmark ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark runs TSAR on a corpus of kernels and generated stress tests.
+// Each kernel is processed with the default analysis, parallelization passes
+// and instrumentation. Profile of each run is collected with -tsar-profile
+// option and time and memory consumed by each processing step and each pass
+// are summarized in a report in JSON format.
+//
+//===----------------------------------------------------------------------===//
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::OptionCategory BenchCategory("Benchmark options");
+
+static cl::opt<std::string> TsarPath("tsar", cl::cat(BenchCategory),
+  cl::value_desc("path"), cl::Required,
+  cl::desc("Path to TSAR executable"));
+static cl::opt<std::string> CorpusDir("corpus", cl::cat(BenchCategory),
+  cl::value_desc("directory"), cl::Required,
+  cl::desc("Directory which contains kernels (*.c files)"));
+static cl::opt<std::string> WorkDir("work-dir", cl::cat(BenchCategory),
+  cl::value_desc("directory"), cl::Required,
+  cl::desc("Directory to store processed kernels and profiles"));
+static cl::opt<std::string> ReportFilename("o", cl::cat(BenchCategory),
+  cl::value_desc("file"), cl::init("-"),
+  cl::desc("Write report to <file>"));
+static cl::list<std::string> OnlyPipelines("pipeline", cl::cat(BenchCategory),
+  cl::CommaSeparated, cl::value_desc("pipelines"),
+  cl::desc("Run specified pipelines only (analysis, openmp, dvmh-sm, "
+           "instrumentation)"));
+static cl::list<std::string> OnlyKernels("kernel", cl::cat(BenchCategory),
+  cl::CommaSeparated, cl::value_desc("kernels"),
+  cl::desc("Process specified kernels only"));
+static cl::opt<unsigned> StressLoops("stress-loops", cl::cat(BenchCategory),
+  cl::value_desc("number"), cl::init(1000),
+  cl::desc("Number of loops in a generated stress test (0 to disable)"));
+static cl::opt<unsigned> StressFunctions("stress-functions",
+  cl::cat(BenchCategory), cl::value_desc("number"), cl::init(500),
+  cl::desc("Number of functions in a generated stress test (0 to disable)"));
+static cl::list<std::string> ExtraArgs("extra-arg", cl::cat(BenchCategory),
+  cl::value_desc("argument"),
+  cl::desc("Additional argument to pass to TSAR"));
+
+namespace {
+/// Pipeline of passes which is evaluated on each kernel.
+struct Pipeline {
+  StringRef Name;
+  std::vector<StringRef> Args;
+  /// True if the pipeline emits LLVM IR to a file specified with -o option.
+  bool HasOutput;
+};
+
+/// Time and memory consumed by a processing step or by a pass.
+struct StageInfo {
+  std::string Name;
+  int64_t Time = 0;
+  int64_t Memory = 0;
+  unsigned Count = 0;
+};
+
+struct RunInfo {
+  std::string Kernel;
+  StringRef Pipeline;
+  int Status = 0;
+  std::string Error;
+  int64_t Time = 0;
+  uint64_t PeakMemory = 0;
+  std::vector<StageInfo> Steps;
+  std::vector<StageInfo> Passes;
+};
+
+/// Generate a test with a large number of loops in a single function.
+void generateStressLoops(raw_ostream &OS, unsigned NumLoops) {
+  OS << "#define N 100\n";
+  OS << "double A[N], B[N], C[N];\n";
+  OS << "int main() {\n";
+  OS << "  double S = 0;\n";
+  for (unsigned L = 0; L < NumLoops; ++L) {
+    switch (L % 3) {
+    case 0:
+      OS << "  for (int I = 0; I < N; ++I)\n"
+         << "    A[I] = B[I] + " << L << ";\n";
+      break;
+    case 1:
+      OS << "  for (int I = 1; I < N; ++I)\n"
+         << "    B[I] = B[I - 1] * C[I];\n";
+      break;
+    case 2:
+      OS << "  for (int I = 0; I < N; ++I)\n"
+         << "    S += A[I] * C[I];\n";
+      break;
+    }
+  }
+  OS << "  return S > 0;\n";
+  OS << "}\n";
+}
+
+/// Generate a test with a large number of functions with loops which call
+/// each other.
+void generateStressFunctions(raw_ostream &OS, unsigned NumFunctions) {
+  OS << "#define N 100\n";
+  OS << "double A[N], B[N];\n";
+  OS << "double f0(double *X) { return X[0]; }\n";
+  for (unsigned F = 1; F < NumFunctions; ++F) {
+    OS << "double f" << F << "(double *X) {\n";
+    OS << "  double S = f" << F - 1 << "(X);\n";
+    OS << "  for (int I = 0; I < N; ++I) {\n";
+    OS << "    X[I] += " << F << ";\n";
+    OS << "    S += X[I];\n";
+    OS << "  }\n";
+    OS << "  return S;\n";
+    OS << "}\n";
+  }
+  OS << "int main() { return f" << NumFunctions - 1 << "(A) > 0; }\n";
+}
+
+/// Extract time and memory consumed by steps and passes from a profile in
+/// Chrome trace format.
+///
+/// Time of a pass includes time of passes executed on the fly.
+Error parseProfile(StringRef Path, RunInfo &Info) {
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return createFileError(Path, Buffer.getError());
+  auto Trace = json::parse((**Buffer).getBuffer());
+  if (!Trace)
+    return Trace.takeError();
+  auto *Events = Trace->getAsObject()
+                     ? Trace->getAsObject()->getArray("traceEvents")
+                     : nullptr;
+  if (!Events)
+    return createStringError(std::errc::invalid_argument,
+                             "list of trace events is not available");
+  StringMap<unsigned> PassIdx;
+  for (auto &E : *Events) {
+    auto *Event = E.getAsObject();
+    if (!Event || Event->getString("ph") != StringRef("X"))
+      continue;
+    auto Name = Event->getString("name");
+    auto *Args = Event->getObject("args");
+    if (!Name || !Args)
+      continue;
+    auto Detail = Args->getString("detail");
+    auto Dur = Event->getInteger("dur");
+    if (!Detail || !Dur)
+      continue;
+    if (*Name == "Step") {
+      Info.Steps.emplace_back();
+      Info.Steps.back().Name = Detail->str();
+      Info.Steps.back().Time = *Dur;
+      Info.Steps.back().Memory =
+          Args->getInteger("memory delta").getValueOr(0);
+      Info.Steps.back().Count = 1;
+    } else if (*Name == "RunPass") {
+      auto I = PassIdx.try_emplace(*Detail, Info.Passes.size());
+      if (I.second) {
+        Info.Passes.emplace_back();
+        Info.Passes.back().Name = Detail->str();
+      }
+      auto &Pass = Info.Passes[I.first->second];
+      Pass.Time += *Dur;
+      ++Pass.Count;
+    }
+  }
+  llvm::sort(Info.Passes, [](const StageInfo &LHS, const StageInfo &RHS) {
+    return LHS.Time > RHS.Time;
+  });
+  return Error::success();
+}
+
+void runPipeline(StringRef KernelPath, const Pipeline &P, RunInfo &Info) {
+  SmallString<128> Dir(WorkDir);
+  sys::path::append(Dir, P.Name);
+  if (auto EC = sys::fs::create_directories(Dir)) {
+    Info.Error = EC.message();
+    return;
+  }
+  // Transformation passes update sources, so copy a kernel at first.
+  SmallString<128> Src(Dir);
+  sys::path::append(Src, sys::path::filename(KernelPath));
+  if (auto EC = sys::fs::copy_file(KernelPath, Src)) {
+    Info.Error = EC.message();
+    return;
+  }
+  SmallString<128> Profile(Dir);
+  sys::path::append(Profile, Info.Kernel + ".trace.json");
+  SmallString<128> Output(Dir);
+  sys::path::append(Output, Info.Kernel + ".ll");
+  std::string ProfileArg = ("-tsar-profile=" + Profile).str();
+  SmallVector<StringRef, 16> Args{TsarPath, Src};
+  Args.append(P.Args.begin(), P.Args.end());
+  if (P.HasOutput) {
+    Args.push_back("-o");
+    Args.push_back(Output);
+  }
+  for (auto &Arg : ExtraArgs)
+    Args.push_back(Arg);
+  Args.push_back(ProfileArg);
+  SmallString<128> Log(Dir);
+  sys::path::append(Log, Info.Kernel + ".log");
+  Optional<StringRef> Redirects[] = {None, StringRef(Log), StringRef(Log)};
+  Optional<sys::ProcessStatistics> Stat;
+  auto Start = std::chrono::steady_clock::now();
+  Info.Status = sys::ExecuteAndWait(TsarPath, Args, None, Redirects, 0, 0,
+                                    &Info.Error, nullptr, &Stat);
+  Info.Time = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - Start)
+                  .count();
+  if (Stat)
+    Info.PeakMemory = Stat->PeakMemory;
+  if (Info.Status != 0) {
+    if (Info.Error.empty())
+      Info.Error = ("see " + Log).str();
+    return;
+  }
+  if (auto E = parseProfile(Profile, Info))
+    Info.Error = toString(std::move(E));
+}
+
+void writeStages(json::OStream &J, StringRef Name,
+                 ArrayRef<StageInfo> Stages) {
+  J.attributeArray(Name, [&J, &Stages]() {
+    for (auto &S : Stages)
+      J.object([&J, &S]() {
+        J.attribute("name", S.Name);
+        J.attribute("time", S.Time);
+        J.attribute("memory delta", S.Memory);
+        J.attribute("count", S.Count);
+      });
+  });
+}
+
+void writeReport(raw_ostream &OS, ArrayRef<RunInfo> Runs) {
+  json::OStream J(OS, 2);
+  J.object([&J, &Runs]() {
+    J.attribute("tsar", TsarPath.getValue());
+    J.attribute("time unit", "us");
+    J.attribute("peak memory unit", "KiB");
+    J.attributeArray("runs", [&J, &Runs]() {
+      for (auto &R : Runs)
+        J.object([&J, &R]() {
+          J.attribute("kernel", R.Kernel);
+          J.attribute("pipeline", R.Pipeline);
+          J.attribute("status", R.Status);
+          if (!R.Error.empty())
+            J.attribute("error", R.Error);
+          J.attribute("time", R.Time);
+          J.attribute("peak memory", int64_t(R.PeakMemory));
+          writeStages(J, "steps", R.Steps);
+          writeStages(J, "passes", R.Passes);
+        });
+    });
+  });
+  OS << "\n";
+}
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions(BenchCategory);
+  cl::ParseCommandLineOptions(Argc, Argv,
+    "TSAR analysis pipeline benchmark\n");
+  const Pipeline Pipelines[] = {
+    {"analysis", {}, false},
+    {"openmp", {"-clang-openmp-parallel", "-output-suffix=bench"}, false},
+    {"dvmh-sm", {"-clang-dvmh-sm-parallel", "-output-suffix=bench"}, false},
+    {"instrumentation", {"-instr-llvm"}, true},
+  };
+  std::vector<std::string> Kernels;
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(CorpusDir, EC), EI; I != EI && !EC;
+       I.increment(EC))
+    if (sys::path::extension(I->path()) == ".c")
+      Kernels.push_back(I->path());
+  if (EC) {
+    errs() << "error: unable to read corpus: " << EC.message() << "\n";
+    return 1;
+  }
+  if (auto EC = sys::fs::create_directories(WorkDir)) {
+    errs() << "error: unable to create working directory: " << EC.message()
+           << "\n";
+    return 1;
+  }
+  auto addStressTest = [&Kernels](StringRef Name, unsigned Size,
+                                  void (*Generator)(raw_ostream &, unsigned)) {
+    if (Size == 0)
+      return true;
+    SmallString<128> Path(WorkDir);
+    sys::path::append(Path, Name);
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::OF_Text);
+    if (EC) {
+      errs() << "error: unable to generate stress test: " << EC.message()
+             << "\n";
+      return false;
+    }
+    Generator(OS, Size);
+    Kernels.push_back(Path.str().str());
+    return true;
+  };
+  if (!addStressTest("stress-loops.c", StressLoops, generateStressLoops) ||
+      !addStressTest("stress-functions.c", StressFunctions,
+                     generateStressFunctions))
+    return 1;
+  llvm::sort(Kernels);
+  std::vector<RunInfo> Runs;
+  for (auto &Kernel : Kernels) {
+    auto Name = sys::path::stem(Kernel);
+    if (!OnlyKernels.empty() && !is_contained(OnlyKernels, Name))
+      continue;
+    for (auto &P : Pipelines) {
+      if (!OnlyPipelines.empty() && !is_contained(OnlyPipelines, P.Name))
+        continue;
+      Runs.emplace_back();
+      Runs.back().Kernel = Name.str();
+      Runs.back().Pipeline = P.Name;
+      runPipeline(Kernel, P, Runs.back());
+      errs() << formatv("{0,-20} {1,-16} {2,10:N} us {3}\n", Name, P.Name,
+                        Runs.back().Time,
+                        Runs.back().Error.empty() ? "" : "FAILED");
+    }
+  }
+  std::unique_ptr<raw_fd_ostream> File;
+  if (ReportFilename != "-") {
+    File = std::make_unique<raw_fd_ostream>(ReportFilename, EC,
+                                            sys::fs::OF_Text);
+    if (EC) {
+      errs() << "error: unable to write report: " << EC.message() << "\n";
+      return 1;
+    }
+  }
+  writeReport(File ? *File : outs(), Runs);
+  return any_of(Runs, [](const RunInfo &R) { return !R.Error.empty(); }) ? 2
+                                                                          : 0;
+}
@@ -0,0 +1,92 @@
+//===--- cg.c --------------- Conjugate Gradient ------------------*- C -*-===//
+//
+// This file implements conjugate gradient method for a sparse matrix stored
+// in CSR format similar to NAS Parallel Benchmarks CG. Accesses to vectors
+// in sparse matrix-vector product are indirect.
+//
+//===----------------------------------------------------------------------===//
+
+#include <math.h>
+#include <stdio.h>
+
+#define NA 14000
+#define NONZER 11
+#define NITER 15
+#define CGITMAX 25
+
+int RowStr[NA + 1];
+int ColIdx[NA * NONZER];
+double Val[NA * NONZER];
+double X[NA], Z[NA], P[NA], Q[NA], R[NA];
+
+void makea() {
+  int Nz = 0;
+  for (int I = 0; I < NA; ++I) {
+    RowStr[I] = Nz;
+    for (int K = 0; K < NONZER; ++K) {
+      int J = (I + K * 1237) % NA;
+      ColIdx[Nz] = J;
+      Val[Nz] = I == J ? 20.0 : 1.0 / (1 + K);
+      ++Nz;
+    }
+  }
+  RowStr[NA] = Nz;
+}
+
+void spmv(const double *restrict In, double *restrict Out) {
+  for (int I = 0; I < NA; ++I) {
+    double Sum = 0;
+    for (int K = RowStr[I]; K < RowStr[I + 1]; ++K)
+      Sum += Val[K] * In[ColIdx[K]];
+    Out[I] = Sum;
+  }
+}
+
+double dot(const double *A, const double *B) {
+  double Sum = 0;
+  for (int I = 0; I < NA; ++I)
+    Sum += A[I] * B[I];
+  return Sum;
+}
+
+double conjGrad() {
+  for (int I = 0; I < NA; ++I) {
+    Q[I] = Z[I] = 0;
+    R[I] = P[I] = X[I];
+  }
+  double Rho = dot(R, R);
+  for (int It = 0; It < CGITMAX; ++It) {
+    spmv(P, Q);
+    double Alpha = Rho / dot(P, Q);
+    for (int I = 0; I < NA; ++I) {
+      Z[I] += Alpha * P[I];
+      R[I] -= Alpha * Q[I];
+    }
+    double Rho0 = Rho;
+    Rho = dot(R, R);
+    double Beta = Rho / Rho0;
+    for (int I = 0; I < NA; ++I)
+      P[I] = R[I] + Beta * P[I];
+  }
+  spmv(Z, R);
+  double Sum = 0;
+  for (int I = 0; I < NA; ++I)
+    Sum += (X[I] - R[I]) * (X[I] - R[I]);
+  return sqrt(Sum);
+}
+
+int main() {
+  makea();
+  for (int I = 0; I < NA; ++I)
+    X[I] = 1.0;
+  double Zeta = 0;
+  for (int It = 1; It <= NITER; ++It) {
+    double RNorm = conjGrad();
+    double ZNorm = 1.0 / sqrt(dot(Z, Z));
+    Zeta = 10.0 + 1.0 / dot(X, Z);
+    for (int I = 0; I < NA; ++I)
+      X[I] = ZNorm * Z[I];
+    printf("It=%4i   RNorm=%e   Zeta=%e\n", It, RNorm, Zeta);
+  }
+  return 0;
+}
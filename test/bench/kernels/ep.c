@@ -0,0 +1,60 @@
+//===--- ep.c ----------- Embarrassingly Parallel -----------------*- C -*-===//
+//
+// This file implements generation of Gaussian random deviates similar to
+// NAS Parallel Benchmarks EP. The main loop contains reductions over scalars
+// and over elements of an array.
+//
+//===----------------------------------------------------------------------===//
+
+#include <math.h>
+#include <stdio.h>
+
+#define M 24
+#define NQ 10
+#define A 1220703125.0
+#define S 271828183.0
+
+static double randlc(double *X) {
+  const double R23 = 1.0 / 8388608.0, T23 = 8388608.0;
+  const double R46 = R23 * R23, T46 = T23 * T23;
+  double T1 = R23 * A;
+  double A1 = (int)T1;
+  double A2 = A - T23 * A1;
+  T1 = R23 * *X;
+  double X1 = (int)T1;
+  double X2 = *X - T23 * X1;
+  T1 = A1 * X2 + A2 * X1;
+  double T2 = (int)(R23 * T1);
+  double Z = T1 - T23 * T2;
+  double T3 = T23 * Z + A2 * X2;
+  double T4 = (int)(R46 * T3);
+  *X = T3 - T46 * T4;
+  return R46 * *X;
+}
+
+int main() {
+  double Q[NQ] = {0};
+  double SX = 0, SY = 0;
+  long N = 1L << M;
+  for (long K = 0; K < N; ++K) {
+    double Seed = S + K;
+    double X1 = 2.0 * randlc(&Seed) - 1.0;
+    double X2 = 2.0 * randlc(&Seed) - 1.0;
+    double T1 = X1 * X1 + X2 * X2;
+    if (T1 <= 1.0) {
+      double T2 = sqrt(-2.0 * log(T1) / T1);
+      double T3 = fabs(X1 * T2);
+      double T4 = fabs(X2 * T2);
+      int L = (int)(T3 > T4 ? T3 : T4);
+      if (L < NQ)
+        Q[L] += 1.0;
+      SX += X1 * T2;
+      SY += X2 * T2;
+    }
+  }
+  double GC = 0;
+  for (int I = 0; I < NQ; ++I)
+    GC += Q[I];
+  printf("SX=%e   SY=%e   GC=%e\n", SX, SY, GC);
+  return 0;
+}
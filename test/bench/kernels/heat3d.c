@@ -0,0 +1,47 @@
+//===--- heat3d.c --------- 3D Heat Equation Stencil --------------*- C -*-===//
+//
+// This file implements explicit solution of 3D heat equation with 7-point
+// stencil. Arrays are passed to functions through pointers, so the analysis
+// have to recover shape of arrays.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdio.h>
+
+#define N 128
+#define TSTEPS 50
+
+double U[N][N][N];
+double V[N][N][N];
+
+static void step(int Size, double (*restrict In)[N][N],
+                 double (*restrict Out)[N][N]) {
+  for (int I = 1; I < Size - 1; ++I)
+    for (int J = 1; J < Size - 1; ++J)
+      for (int K = 1; K < Size - 1; ++K)
+        Out[I][J][K] = 0.125 * (In[I + 1][J][K] - 2.0 * In[I][J][K] +
+                                In[I - 1][J][K]) +
+                       0.125 * (In[I][J + 1][K] - 2.0 * In[I][J][K] +
+                                In[I][J - 1][K]) +
+                       0.125 * (In[I][J][K + 1] - 2.0 * In[I][J][K] +
+                                In[I][J][K - 1]) +
+                       In[I][J][K];
+}
+
+int main() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J)
+      for (int K = 0; K < N; ++K)
+        U[I][J][K] = V[I][J][K] = (double)(I + J + (N - K)) * 10 / N;
+  for (int T = 1; T <= TSTEPS; ++T) {
+    step(N, U, V);
+    step(N, V, U);
+  }
+  double Sum = 0;
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J)
+      for (int K = 0; K < N; ++K)
+        Sum += U[I][J][K];
+  printf("Sum=%e\n", Sum);
+  return 0;
+}
@@ -0,0 +1,44 @@
+//===--- matmul.c ----------- Matrix Multiplication ---------------*- C -*-===//
+//
+// This file implements multiplication of dense square matrices. The outer
+// loops are parallel, the innermost loop contains a reduction.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdio.h>
+
+#define N 512
+
+double A[N][N];
+double B[N][N];
+double C[N][N];
+
+void init() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J) {
+      A[I][J] = I + J;
+      B[I][J] = I - J;
+      C[I][J] = 0;
+    }
+}
+
+void multiply() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J) {
+      double S = 0;
+      for (int K = 0; K < N; ++K)
+        S += A[I][K] * B[K][J];
+      C[I][J] = S;
+    }
+}
+
+int main() {
+  init();
+  multiply();
+  double Sum = 0;
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J)
+      Sum += C[I][J];
+  printf("Sum=%e\n", Sum);
+  return 0;
+}
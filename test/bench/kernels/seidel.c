@@ -0,0 +1,32 @@
+//===--- seidel.c --------- Gauss-Seidel 2D Stencil ---------------*- C -*-===//
+//
+// This file implements Gauss-Seidel iterations with 9-point stencil. Loops
+// carry flow and anti dependencies with constant distances, so they can be
+// parallelized with pipeline only.
+//
+//===----------------------------------------------------------------------===//
+
+#include <stdio.h>
+
+#define N 2000
+#define TSTEPS 20
+
+double A[N][N];
+
+int main() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J)
+      A[I][J] = ((double)I * (J + 2) + 2) / N;
+  for (int T = 0; T < TSTEPS; ++T)
+    for (int I = 1; I < N - 1; ++I)
+      for (int J = 1; J < N - 1; ++J)
+        A[I][J] = (A[I - 1][J - 1] + A[I - 1][J] + A[I - 1][J + 1] +
+                   A[I][J - 1] + A[I][J] + A[I][J + 1] + A[I + 1][J - 1] +
+                   A[I + 1][J] + A[I + 1][J + 1]) / 9.0;
+  double Sum = 0;
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J)
+      Sum += A[I][J];
+  printf("Sum=%e\n", Sum);
+  return 0;
+}
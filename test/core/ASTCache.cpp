@@ -0,0 +1,118 @@
+//===- ASTCache.cpp ------- Cache of Clang AST Files Test -------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file checks that a cache of Clang AST files reuses an AST file of
+// an unchanged source and that the source is parsed again if a file which
+// it includes has been changed.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Core/ASTCache.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace clang;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+bool writeFile(StringRef Path, StringRef Content) {
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::OF_Text);
+  if (EC)
+    return false;
+  OS << Content;
+  return true;
+}
+
+/// Parse a source and emit its AST file in the same way as the tool does.
+bool emitAST(ASTCache &Cache, StringRef Source) {
+  FixedCompilationDatabase Compilations(".", {});
+  ClangTool Tool(Compilations, {Source.str()});
+  auto ASTFile = Cache.getASTFilename(Source);
+  Tool.appendArgumentsAdjuster([&ASTFile](const CommandLineArguments &CL,
+                                          StringRef) {
+    CommandLineArguments Adjusted;
+    for (auto &Arg : CL)
+      if (StringRef(Arg).startswith("-fsyntax-only"))
+        Adjusted.emplace_back("-emit-ast");
+      else
+        Adjusted.push_back(Arg);
+    Adjusted.emplace_back("-o");
+    Adjusted.push_back(ASTFile);
+    return Adjusted;
+  });
+  return Tool.run(newFrontendActionFactory<GeneratePCHAction>().get()) == 0 &&
+         Cache.insert(Source);
+}
+
+int check(bool Condition, StringRef Message) {
+  if (Condition)
+    return 0;
+  errs() << "error: " << Message << "\n";
+  return 1;
+}
+}
+
+int main() {
+  SmallString<128> Dir;
+  if (sys::fs::createUniqueDirectory("tsar-ast-cache-test", Dir)) {
+    errs() << "error: unable to create a temporary directory\n";
+    return 1;
+  }
+  SmallString<128> Source(Dir), Header(Dir);
+  sys::path::append(Source, "main.c");
+  sys::path::append(Header, "main.h");
+  int Errors = 0;
+  Errors += check(writeFile(Header, "#define N 10\n") &&
+                      writeFile(Source, "#include \"main.h\"\nint A[N];\n"),
+                  "unable to write sources");
+  {
+    ASTCache Cache;
+    Cache.startRun();
+    Errors += check(Cache.lookup(Source).empty() && Cache.getNumRebuilt() == 1,
+                    "unknown source must be parsed");
+    Errors += check(emitAST(Cache, Source), "unable to emit AST");
+    Cache.startRun();
+    Errors += check(!Cache.lookup(Source).empty() && Cache.getNumReused() == 1,
+                    "AST of an unchanged source must be reused");
+    Errors += check(writeFile(Header, "#define N 20\n"),
+                    "unable to write header");
+    Cache.startRun();
+    Errors += check(Cache.lookup(Source).empty() && Cache.getNumRebuilt() == 1,
+                    "change of an included file must invalidate AST");
+    Errors += check(emitAST(Cache, Source), "unable to emit AST");
+    Cache.startRun();
+    Errors += check(!Cache.lookup(Source).empty() && Cache.getNumReused() == 1,
+                    "AST of a parsed again source must be reused");
+    Cache.invalidate(Header);
+    Cache.startRun();
+    Errors += check(Cache.lookup(Source).empty(),
+                    "invalidation of an included file must be noticed");
+  }
+  sys::fs::remove_directories(Dir);
+  return Errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+//===--- Benchmark.h ------ Microbenchmark Utilities ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines helpers to run microbenchmarks and to print their results.
+//
+// Each benchmark prints a single line with tab separated fields:
+//   <suite> <benchmark> <size> <iterations> <median time> <minimum time>
+// Time is measured in seconds. Lines which start with '#' are comments.
+// This format should be kept stable, so results of different implementations
+// and different revisions can be compared with simple scripts.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_PERF_BENCHMARK_H
+#define TSAR_PERF_BENCHMARK_H
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace tsar {
+namespace perf {
+/// Accumulator which prevents the compiler from removing computations
+/// which results are not used.
+inline volatile std::size_t Sink = 0;
+
+/// Mark a value as used.
+inline void doNotOptimize(std::size_t V) { Sink = Sink + V; }
+
+/// Set of benchmarks which are evaluated for the same size of data set.
+class BenchmarkSuite {
+public:
+  using TimeT = std::chrono::duration<double>;
+
+  /// Create a suite, only benchmarks which names contain `Filter` are
+  /// evaluated.
+  BenchmarkSuite(llvm::StringRef Name, std::size_t Size, unsigned MaxIter,
+                 llvm::StringRef Filter = "")
+      : mName(Name), mSize(Size), mMaxIter(MaxIter), mFilter(Filter) {}
+
+  /// Return size of data set.
+  std::size_t size() const noexcept { return mSize; }
+
+  /// Evaluate a benchmark `MaxIter` times.
+  ///
+  /// The `Setup` function is not measured, it is called before each iteration
+  /// and its result is passed to the `Body` function.
+  template<class SetupT, class BodyT>
+  void run(llvm::StringRef Name, SetupT Setup, BodyT Body) {
+    if (!Name.contains(mFilter))
+      return;
+    std::vector<double> Time;
+    Time.reserve(mMaxIter);
+    for (unsigned I = 0; I < mMaxIter; ++I) {
+      auto State = Setup();
+      auto Start = std::chrono::steady_clock::now();
+      Body(State);
+      auto End = std::chrono::steady_clock::now();
+      Time.push_back(TimeT(End - Start).count());
+    }
+    std::sort(Time.begin(), Time.end());
+    llvm::outs() << mName << "\t" << Name << "\t" << mSize << "\t" << mMaxIter
+                 << "\t" << llvm::format("%.9f", Time[Time.size() / 2])
+                 << "\t" << llvm::format("%.9f", Time.front()) << "\n";
+  }
+
+  /// Evaluate a benchmark which does not require setup.
+  template<class BodyT> void run(llvm::StringRef Name, BodyT Body) {
+    run(Name, []() { return 0; }, [&Body](int) { Body(); });
+  }
+
+  /// Print header which describes fields in output.
+  static void printHeader() {
+    llvm::outs() << "# suite\tbenchmark\tsize\titerations\t"
+                    "median time (s)\tmin time (s)\n";
+  }
+
+private:
+  std::string mName;
+  std::size_t mSize;
+  unsigned mMaxIter;
+  std::string mFilter;
+};
+
+/// Parse command line arguments `<size> [iterations] [filter]`.
+///
+/// \return False if arguments are invalid.
+inline bool parseArguments(int Argc, const char **Argv, std::size_t &Size,
+                           unsigned &MaxIter, llvm::StringRef &Filter) {
+  std::string Help =
+    "parameter: <size of data set> [number of iterations] "
+    "[benchmark name filter]\n";
+  if (Argc < 2) {
+    llvm::errs() << "error: too few arguments\n" << Help;
+    return false;
+  } else if (Argc > 4) {
+    llvm::errs() << "error: too many arguments\n" << Help;
+    return false;
+  }
+  Size = std::atoll(Argv[1]);
+  MaxIter = (Argc > 2) ? std::atoi(Argv[2]) : 10;
+  Filter = (Argc > 3) ? Argv[3] : "";
+  if (Size == 0) {
+    llvm::errs() << "error: invalid size of data set\n" << Help;
+    return false;
+  }
+  if (MaxIter == 0) {
+    llvm::errs() << "error: invalid number of iterations\n" << Help;
+    return false;
+  }
+  return true;
+}
+}
+}
+#endif//TSAR_PERF_BENCHMARK_H
@@ -0,0 +1,170 @@
+//===- CallExtractor.cpp --- Call Extraction Benchmarks ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains microbenchmarks which compare full and sparse modes of
+// extraction of calls into separate basic blocks. A synthetic function
+// contains a loop with a lot of calls, most of them are calls of external
+// functions. For each mode the number of basic blocks after extraction is
+// printed and the time of a data-flow problem solved over the resulting
+// control-flow graph is measured.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include <tsar/Core/tsar-config.h>
+#include <tsar/Support/GlobalOptions.h>
+#include <tsar/Transform/IR/Passes.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <memory>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::perf;
+
+namespace {
+/// Build a module with a function 'kernel' which contains a loop with
+/// a specified number of calls. Each fourth call is a call of a function
+/// with a body, other calls are calls of an external function.
+std::unique_ptr<Module> buildModule(LLVMContext &Ctx, std::size_t NumCalls) {
+  auto M = std::make_unique<Module>("call-heavy", Ctx);
+  auto *Int32Ty = Type::getInt32Ty(Ctx);
+  auto *PtrTy = Int32Ty->getPointerTo();
+  auto *CalleeTy = FunctionType::get(Type::getVoidTy(Ctx), {PtrTy}, false);
+  auto *Ext = Function::Create(CalleeTy, GlobalValue::ExternalLinkage, "ext",
+                               *M);
+  auto *Helper = Function::Create(CalleeTy, GlobalValue::ExternalLinkage,
+                                  "helper", *M);
+  IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Helper));
+  auto *Ptr = &*Helper->arg_begin();
+  B.CreateStore(B.CreateAdd(B.CreateLoad(Int32Ty, Ptr), B.getInt32(1)), Ptr);
+  B.CreateRetVoid();
+  auto *KernelTy =
+    FunctionType::get(Type::getVoidTy(Ctx), {PtrTy, Int32Ty}, false);
+  auto *Kernel = Function::Create(KernelTy, GlobalValue::ExternalLinkage,
+                                  "kernel", *M);
+  auto *A = &*Kernel->arg_begin();
+  auto *N = &*(Kernel->arg_begin() + 1);
+  auto *EntryBB = BasicBlock::Create(Ctx, "entry", Kernel);
+  auto *LoopBB = BasicBlock::Create(Ctx, "loop", Kernel);
+  auto *ExitBB = BasicBlock::Create(Ctx, "exit", Kernel);
+  B.SetInsertPoint(EntryBB);
+  B.CreateBr(LoopBB);
+  B.SetInsertPoint(LoopBB);
+  auto *I = B.CreatePHI(Int32Ty, 2);
+  I->addIncoming(B.getInt32(0), EntryBB);
+  for (std::size_t K = 0; K < NumCalls; ++K) {
+    auto *Elem = B.CreateGEP(Int32Ty, A, B.getInt32(K % 16));
+    B.CreateCall(CalleeTy, K % 4 == 0 ? Helper : Ext, {Elem});
+    B.CreateStore(B.CreateAdd(B.CreateLoad(Int32Ty, Elem), I), Elem);
+  }
+  auto *Next = B.CreateAdd(I, B.getInt32(1));
+  I->addIncoming(Next, LoopBB);
+  B.CreateCondBr(B.CreateICmpSLT(Next, N), LoopBB, ExitBB);
+  B.SetInsertPoint(ExitBB);
+  B.CreateRetVoid();
+  return M;
+}
+
+void extractCalls(Module &M, const GlobalOptions &GO) {
+  legacy::PassManager PM;
+  PM.add(createGlobalOptionsImmutableWrapper(&GO));
+  PM.add(createCallExtractorPass());
+  PM.run(M);
+}
+
+/// Solve reaching definitions problem over basic blocks of a function, each
+/// instruction which may write memory is a definition.
+std::size_t solveReachDefs(Function &F) {
+  unsigned NumDefs = 0;
+  for (auto &BB : F)
+    for (auto &I : BB)
+      if (I.mayWriteToMemory())
+        ++NumDefs;
+  DenseMap<BasicBlock *, BitVector> Gen, Out;
+  unsigned Idx = 0;
+  for (auto &BB : F) {
+    auto &G = Gen.try_emplace(&BB, NumDefs).first->second;
+    Out.try_emplace(&BB, NumDefs);
+    for (auto &I : BB)
+      if (I.mayWriteToMemory())
+        G.set(Idx++);
+  }
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  std::size_t NumVisits = 0;
+  bool IsChanged = true;
+  BitVector In(NumDefs);
+  while (IsChanged) {
+    IsChanged = false;
+    for (auto *BB : RPOT) {
+      ++NumVisits;
+      In.reset();
+      for (auto *Pred : predecessors(BB))
+        In |= Out[Pred];
+      In |= Gen[BB];
+      auto &BBOut = Out[BB];
+      if (In != BBOut) {
+        BBOut = In;
+        IsChanged = true;
+      }
+    }
+  }
+  return NumVisits;
+}
+
+void runExtractor(BenchmarkSuite &S, StringRef Mode, bool IsSparse) {
+  LLVMContext Ctx;
+  auto M = buildModule(Ctx, S.size());
+  GlobalOptions GO;
+  GO.SparseCallExtraction = IsSparse;
+  S.run(("CallExtractor/" + Mode).str(), [&M]() { return CloneModule(*M); },
+        [&GO](std::unique_ptr<Module> &Clone) {
+          extractCalls(*Clone, GO);
+          doNotOptimize(Clone->getFunction("kernel")->size());
+        });
+  auto Extracted = CloneModule(*M);
+  extractCalls(*Extracted, GO);
+  auto *Kernel = Extracted->getFunction("kernel");
+  outs() << "# " << Mode << ": " << Kernel->size() << " basic blocks in "
+         << Kernel->getName() << "\n";
+  S.run(("ReachDefs/" + Mode).str(),
+        [Kernel]() { doNotOptimize(solveReachDefs(*Kernel)); });
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::size_t Size;
+  unsigned MaxIter;
+  StringRef Filter;
+  if (!parseArguments(Argc, Argv, Size, MaxIter, Filter))
+    return 1;
+  BenchmarkSuite S("call-extractor", Size, MaxIter, Filter);
+  BenchmarkSuite::printHeader();
+  runExtractor(S, "full", false);
+  runExtractor(S, "sparse", true);
+  return 0;
+}
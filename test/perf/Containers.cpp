@@ -0,0 +1,207 @@
+//===--- Containers.cpp ----- Container Benchmarks --------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains microbenchmarks for containers which are widely used
+// in analysis passes: Bimap (with list and flat storage), PersistentSet and
+// MemorySet.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include <tsar/Core/tsar-config.h>
+#include <tsar/ADT/Bimap.h>
+#include <tsar/ADT/PersistentSet.h>
+#include <tsar/Analysis/Memory/MemoryLocationRange.h>
+#include <tsar/Analysis/Memory/MemorySet.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::perf;
+
+namespace {
+using DataSetT = std::vector<std::size_t>;
+
+/// Return a set of unique keys in a random order.
+DataSetT initializeDataSet(std::size_t Size) {
+  DataSetT Data(Size);
+  for (std::size_t I = 0; I < Size; ++I)
+    Data[I] = I;
+  std::shuffle(Data.begin(), Data.end(), std::mt19937(Size));
+  return Data;
+}
+
+template<class StorageTy>
+void runBimap(BenchmarkSuite &S, StringRef Prefix) {
+  using BimapT = Bimap<std::size_t, std::size_t,
+                       DenseMapInfo<std::size_t>, DenseMapInfo<std::size_t>,
+                       StorageTy>;
+  auto Data = initializeDataSet(S.size());
+  auto Size = S.size();
+  auto makeBimap = [&Data, Size]() {
+    BimapT BM;
+    for (auto K : Data)
+      BM.emplace(K, K + Size);
+    return BM;
+  };
+  S.run((Prefix + "/emplace").str(), []() { return BimapT(); },
+        [&Data, Size](BimapT &BM) {
+          for (auto K : Data)
+            BM.emplace(K, K + Size);
+          doNotOptimize(BM.size());
+        });
+  S.run((Prefix + "/find_first").str(), makeBimap, [Size](BimapT &BM) {
+    std::size_t Sum = 0;
+    for (std::size_t K = 0; K < Size; ++K)
+      Sum += BM.find_first(K)->second;
+    doNotOptimize(Sum);
+  });
+  S.run((Prefix + "/find_second").str(), makeBimap, [Size](BimapT &BM) {
+    std::size_t Sum = 0;
+    for (std::size_t K = 0; K < Size; ++K)
+      Sum += BM.find_second(K + Size)->first;
+    doNotOptimize(Sum);
+  });
+  S.run((Prefix + "/erase_first").str(), makeBimap, [Size](BimapT &BM) {
+    for (std::size_t K = 0; K < Size; ++K)
+      BM.erase_first(K);
+    doNotOptimize(BM.size());
+  });
+  S.run((Prefix + "/copy").str(), makeBimap, [](BimapT &BM) {
+    BimapT Copy(BM);
+    doNotOptimize(Copy.size());
+  });
+}
+
+void runPersistentSet(BenchmarkSuite &S) {
+  using SetT = PersistentSet<std::size_t>;
+  auto Data = initializeDataSet(S.size());
+  auto Size = S.size();
+  auto makeSet = [&Data]() {
+    SetT PS;
+    for (auto K : Data)
+      PS.insert(K);
+    return PS;
+  };
+  S.run("PersistentSet/insert", []() { return SetT(); }, [&Data](SetT &PS) {
+    for (auto K : Data)
+      PS.insert(K);
+    doNotOptimize(PS.size());
+  });
+  S.run("PersistentSet/count", makeSet, [Size](SetT &PS) {
+    std::size_t Sum = 0;
+    for (std::size_t K = 0; K < 2 * Size; ++K)
+      Sum += PS.count(K);
+    doNotOptimize(Sum);
+  });
+  S.run("PersistentSet/erase", makeSet, [Size](SetT &PS) {
+    for (std::size_t K = 0; K < Size; ++K)
+      PS.erase(K);
+    doNotOptimize(PS.size());
+  });
+}
+
+/// Generate memory locations which are similar to locations accessed in
+/// a function: there are a lot of base pointers and a small number of
+/// ranges for each pointer.
+std::vector<MemoryLocationRange> initializeLocations(Module &M,
+                                                     std::size_t Size,
+                                                     unsigned Seed) {
+  const std::size_t LocationsPerBase = 8;
+  const uint64_t BaseSize = 1024;
+  auto *Ty = ArrayType::get(Type::getInt8Ty(M.getContext()), BaseSize);
+  while (M.global_size() < std::max<std::size_t>(1, Size / LocationsPerBase))
+    new GlobalVariable(M, Ty, false, GlobalValue::InternalLinkage,
+                       ConstantAggregateZero::get(Ty));
+  std::vector<GlobalVariable *> Bases;
+  for (auto &GV : M.globals())
+    Bases.push_back(&GV);
+  std::mt19937 Gen(Seed);
+  std::uniform_int_distribution<std::size_t> BaseDist(0, Bases.size() - 1);
+  std::uniform_int_distribution<uint64_t> OffsetDist(0, BaseSize - 64);
+  std::uniform_int_distribution<uint64_t> SizeDist(1, 64);
+  std::vector<MemoryLocationRange> Locs;
+  Locs.reserve(Size);
+  for (std::size_t I = 0; I < Size; ++I) {
+    auto Lower = OffsetDist(Gen);
+    Locs.emplace_back(Bases[BaseDist(Gen)], Lower, Lower + SizeDist(Gen));
+  }
+  return Locs;
+}
+
+void runMemorySet(BenchmarkSuite &S) {
+  using SetT = MemorySet<MemoryLocationRange>;
+  LLVMContext Ctx;
+  Module M("memory-set", Ctx);
+  auto Locs = initializeLocations(M, S.size(), 1);
+  auto Queries = initializeLocations(M, S.size(), 2);
+  auto makeSet = [](const std::vector<MemoryLocationRange> &Locs) {
+    SetT MS;
+    for (auto &Loc : Locs)
+      MS.insert(Loc);
+    return MS;
+  };
+  S.run("MemorySet/insert", []() { return SetT(); }, [&Locs](SetT &MS) {
+    for (auto &Loc : Locs)
+      MS.insert(Loc);
+    doNotOptimize(MS.empty());
+  });
+  S.run("MemorySet/overlap", [&]() { return makeSet(Locs); },
+        [&Queries](SetT &MS) {
+          std::size_t Sum = 0;
+          for (auto &Loc : Queries)
+            Sum += MS.overlap(Loc);
+          doNotOptimize(Sum);
+        });
+  S.run("MemorySet/cover", [&]() { return makeSet(Locs); },
+        [&Queries](SetT &MS) {
+          std::size_t Sum = 0;
+          for (auto &Loc : Queries)
+            Sum += MS.cover(Loc);
+          doNotOptimize(Sum);
+        });
+  auto Other = makeSet(Queries);
+  S.run("MemorySet/merge", [&]() { return makeSet(Locs); },
+        [&Other](SetT &MS) { doNotOptimize(MS.merge(Other)); });
+  S.run("MemorySet/intersect", [&]() { return makeSet(Locs); },
+        [&Other](SetT &MS) { doNotOptimize(MS.intersect(Other)); });
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::size_t Size;
+  unsigned MaxIter;
+  StringRef Filter;
+  if (!parseArguments(Argc, Argv, Size, MaxIter, Filter))
+    return 1;
+  BenchmarkSuite S("containers", Size, MaxIter, Filter);
+  BenchmarkSuite::printHeader();
+  runBimap<BimapListStorage>(S, "Bimap");
+  runBimap<BimapFlatStorage>(S, "FlatBimap");
+  runPersistentSet(S);
+  runMemorySet(S);
+  return 0;
+}
@@ -0,0 +1,194 @@
+//===- DependenceTests.cpp - Dependence Test Benchmarks ---------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains microbenchmarks which compare fixed-width integer and
+// general (SCEV and APInt based) evaluation of dependence tests. Synthetic
+// functions contain a loop nest with a lot of accesses to the same array.
+// Subscripts of accesses are chosen to invoke Strong SIV test for loops with
+// constant and symbolic trip counts and GCD test for MIV subscripts.
+// Dependence is checked for each pair of accesses. The number of disproved
+// dependencies is printed for each mode, so it can be checked that both
+// modes produce the same results.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include <tsar/Analysis/Memory/DependenceAnalysis.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <cassert>
+#include <memory>
+
+using namespace llvm;
+using namespace tsar::perf;
+
+namespace {
+/// Kind of subscripts in a synthetic function.
+enum class SubscriptKind {
+  /// A[J + K], the inner loop has a constant trip count.
+  StrongSIVConstBound,
+  /// A[I + K], the outer loop has a symbolic trip count.
+  StrongSIVSymbolicBound,
+  /// A[4 * I + 6 * J + K].
+  MIV
+};
+
+/// Build a function with a specified name which contains a loop nest:
+/// for (I = 0; I < N; ++I) for (J = 0; J < 64; ++J) { A[...] = 0; ... }
+/// The number of stores in the inner loop is equal to `NumAccesses`.
+Function *buildFunction(Module &M, StringRef Name, SubscriptKind Kind,
+                        std::size_t NumAccesses) {
+  auto &Ctx = M.getContext();
+  auto *Int64Ty = Type::getInt64Ty(Ctx);
+  auto *FuncTy = FunctionType::get(Type::getVoidTy(Ctx),
+                                   {Int64Ty->getPointerTo(), Int64Ty}, false);
+  auto *F = Function::Create(FuncTy, GlobalValue::ExternalLinkage, Name, M);
+  auto *A = &*F->arg_begin();
+  auto *N = &*(F->arg_begin() + 1);
+  auto *EntryBB = BasicBlock::Create(Ctx, "entry", F);
+  auto *OuterBB = BasicBlock::Create(Ctx, "outer", F);
+  auto *InnerBB = BasicBlock::Create(Ctx, "inner", F);
+  auto *LatchBB = BasicBlock::Create(Ctx, "latch", F);
+  auto *ExitBB = BasicBlock::Create(Ctx, "exit", F);
+  IRBuilder<> B(EntryBB);
+  B.CreateCondBr(B.CreateICmpSGT(N, B.getInt64(0)), OuterBB, ExitBB);
+  B.SetInsertPoint(OuterBB);
+  auto *I = B.CreatePHI(Int64Ty, 2, "i");
+  I->addIncoming(B.getInt64(0), EntryBB);
+  B.CreateBr(InnerBB);
+  B.SetInsertPoint(InnerBB);
+  auto *J = B.CreatePHI(Int64Ty, 2, "j");
+  J->addIncoming(B.getInt64(0), OuterBB);
+  for (std::size_t K = 0; K < NumAccesses; ++K) {
+    Value *Idx = nullptr;
+    switch (Kind) {
+    case SubscriptKind::StrongSIVConstBound:
+      Idx = B.CreateNSWAdd(J, B.getInt64(K));
+      break;
+    case SubscriptKind::StrongSIVSymbolicBound:
+      Idx = B.CreateNSWAdd(I, B.getInt64(K));
+      break;
+    case SubscriptKind::MIV:
+      Idx = B.CreateNSWAdd(
+          B.CreateNSWAdd(B.CreateNSWMul(I, B.getInt64(4)),
+                         B.CreateNSWMul(J, B.getInt64(6))),
+          B.getInt64(K));
+      break;
+    }
+    B.CreateStore(B.getInt64(0), B.CreateInBoundsGEP(Int64Ty, A, Idx));
+  }
+  auto *NextJ = B.CreateNSWAdd(J, B.getInt64(1));
+  J->addIncoming(NextJ, InnerBB);
+  B.CreateCondBr(B.CreateICmpSLT(NextJ, B.getInt64(64)), InnerBB, LatchBB);
+  B.SetInsertPoint(LatchBB);
+  auto *NextI = B.CreateNSWAdd(I, B.getInt64(1));
+  I->addIncoming(NextI, LatchBB);
+  B.CreateCondBr(B.CreateICmpSLT(NextI, N), OuterBB, ExitBB);
+  B.SetInsertPoint(ExitBB);
+  B.CreateRetVoid();
+  return F;
+}
+
+/// Analysis results which are necessary to run dependence tests.
+///
+/// Alias analysis without any providers is used, so dependence analysis
+/// relies on the comparison of underlying objects only.
+struct AnalysisState {
+  explicit AnalysisState(Function &F)
+      : TLII(Triple(F.getParent()->getTargetTriple())), TLI(TLII), AC(F),
+        DT(F), LI(DT), SE(F, TLI, AC, DT, LI), AA(TLI),
+        DI(&F, &AA, &SE, &LI) {}
+
+  TargetLibraryInfoImpl TLII;
+  TargetLibraryInfo TLI;
+  AssumptionCache AC;
+  DominatorTree DT;
+  LoopInfo LI;
+  ScalarEvolution SE;
+  AAResults AA;
+  DependenceInfo DI;
+};
+
+/// Check dependence for each pair of stores in a function, return
+/// the number of disproved dependencies.
+std::size_t checkDependencies(Function &F, DependenceInfo &DI) {
+  SmallVector<Instruction *, 64> Accesses;
+  for (auto &I : instructions(F))
+    if (isa<StoreInst>(I))
+      Accesses.push_back(&I);
+  std::size_t NumIndependent = 0;
+  for (auto SrcItr = Accesses.begin(), EI = Accesses.end(); SrcItr != EI;
+       ++SrcItr)
+    for (auto DstItr = SrcItr; DstItr != EI; ++DstItr)
+      if (!DI.depends(*SrcItr, *DstItr, true))
+        ++NumIndependent;
+  return NumIndependent;
+}
+
+/// Enable or disable fixed-width fast path in dependence tests.
+void setFastPath(bool Enable) {
+  auto &Opts = cl::getRegisteredOptions();
+  auto Itr = Opts.find("da-int64-fast-path");
+  assert(Itr != Opts.end() && "Option must be registered!");
+  static_cast<cl::opt<bool> *>(Itr->second)->setValue(Enable);
+}
+
+void runTests(BenchmarkSuite &S, StringRef Name, SubscriptKind Kind) {
+  LLVMContext Ctx;
+  Module M("dependence-tests", Ctx);
+  auto *F = buildFunction(M, Name, Kind, S.size());
+  for (bool IsFast : {false, true}) {
+    setFastPath(IsFast);
+    StringRef Mode = IsFast ? "int64" : "general";
+    S.run((Name + "/" + Mode).str(),
+          [F]() { return std::make_unique<AnalysisState>(*F); },
+          [F](std::unique_ptr<AnalysisState> &State) {
+            doNotOptimize(checkDependencies(*F, State->DI));
+          });
+    AnalysisState State(*F);
+    outs() << "# " << Name << "/" << Mode << ": "
+           << checkDependencies(*F, State.DI) << " independent pairs\n";
+  }
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::size_t Size;
+  unsigned MaxIter;
+  StringRef Filter;
+  if (!parseArguments(Argc, Argv, Size, MaxIter, Filter))
+    return 1;
+  BenchmarkSuite S("dependence-tests", Size, MaxIter, Filter);
+  BenchmarkSuite::printHeader();
+  runTests(S, "StrongSIV-const", SubscriptKind::StrongSIVConstBound);
+  runTests(S, "StrongSIV-symbolic", SubscriptKind::StrongSIVSymbolicBound);
+  runTests(S, "GCD", SubscriptKind::MIV);
+  return 0;
+}
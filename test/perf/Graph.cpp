@@ -0,0 +1,255 @@
+//===--- Graph.cpp ------ Graph Algorithm Benchmarks ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains microbenchmarks for graph algorithms: numbering of nodes,
+// relation between nodes in a spanning tree and data-flow solvers. Synthetic
+// graphs are similar to control-flow graphs: each node has a small number
+// of successors, most of edges are directed forward and there are some
+// back edges.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include <tsar/Core/tsar-config.h>
+#include <tsar/ADT/DataFlow.h>
+#include <tsar/ADT/GraphNumbering.h>
+#include <tsar/ADT/SpanningTreeRelation.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/GraphTraits.h>
+#include <llvm/ADT/SmallVector.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::perf;
+
+namespace {
+struct Node {
+  using iterator = SmallVectorImpl<Node *>::iterator;
+
+  unsigned Id;
+  SmallVector<Node *, 4> Succs;
+  SmallVector<Node *, 4> Preds;
+
+  /// Definitions generated and killed in a node.
+  BitVector Gen, Kill;
+
+  /// Data-flow value after a node.
+  BitVector Out;
+};
+
+class Graph {
+public:
+  using iterator = std::vector<Node *>::iterator;
+
+  /// Build a graph with a specified number of nodes.
+  ///
+  /// If `HasBackEdges` is false the graph is acyclic.
+  Graph(std::size_t Size, unsigned NumDefs, bool HasBackEdges) {
+    std::mt19937 Gen(Size);
+    std::uniform_int_distribution<unsigned> Dist(0, 99);
+    for (std::size_t I = 0; I < Size; ++I) {
+      mStorage.push_back(std::make_unique<Node>());
+      auto *N = mStorage.back().get();
+      N->Id = I;
+      N->Gen.resize(NumDefs);
+      N->Kill.resize(NumDefs);
+      N->Gen.set(I % NumDefs);
+      N->Kill.set((I * 7 + 3) % NumDefs);
+      mNodes.push_back(N);
+      if (I == 0)
+        continue;
+      // Each node is reachable from a close previous node.
+      addEdge(mNodes[I - 1 - Dist(Gen) % std::min<std::size_t>(I, 4)], N);
+      if (I > 1 && Dist(Gen) < 30)
+        addEdge(mNodes[Dist(Gen) % (I - 1)], N);
+      if (HasBackEdges && I > 1 && Dist(Gen) < 10)
+        addEdge(N, mNodes[I - 1 - Dist(Gen) % std::min<std::size_t>(I, 16)]);
+    }
+  }
+
+  Node *getEntryNode() const { return mNodes.front(); }
+
+  iterator begin() { return mNodes.begin(); }
+  iterator end() { return mNodes.end(); }
+
+  std::size_t size() const { return mNodes.size(); }
+
+  void clear() {
+    for (auto *N : mNodes)
+      N->Out.clear();
+  }
+
+private:
+  static void addEdge(Node *From, Node *To) {
+    From->Succs.push_back(To);
+    To->Preds.push_back(From);
+  }
+
+  std::vector<std::unique_ptr<Node>> mStorage;
+  std::vector<Node *> mNodes;
+};
+
+/// Data-flow graph where edges are directed from a node to its predecessors.
+struct DFGraph {
+  Graph *G;
+};
+
+/// Reaching definitions problem.
+struct ReachDefs {
+  unsigned NumDefs;
+};
+}
+
+namespace llvm {
+template<> struct GraphTraits<Graph *> {
+  using NodeRef = Node *;
+  using ChildIteratorType = Node::iterator;
+  static NodeRef getEntryNode(Graph *G) { return G->getEntryNode(); }
+  static ChildIteratorType child_begin(NodeRef N) { return N->Succs.begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->Succs.end(); }
+  using nodes_iterator = Graph::iterator;
+  static nodes_iterator nodes_begin(Graph *G) { return G->begin(); }
+  static nodes_iterator nodes_end(Graph *G) { return G->end(); }
+  static std::size_t size(Graph *G) { return G->size(); }
+};
+
+template<> struct GraphTraits<DFGraph> {
+  using NodeRef = Node *;
+  using ChildIteratorType = Node::iterator;
+  static NodeRef getEntryNode(DFGraph G) { return G.G->getEntryNode(); }
+  static ChildIteratorType child_begin(NodeRef N) { return N->Preds.begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->Preds.end(); }
+  using nodes_iterator = Graph::iterator;
+  static nodes_iterator nodes_begin(DFGraph G) { return G.G->begin() + 1; }
+  static nodes_iterator nodes_end(DFGraph G) { return G.G->end(); }
+};
+
+template<> struct GraphTraits<Inverse<DFGraph>> {
+  using NodeRef = Node *;
+  using ChildIteratorType = Node::iterator;
+  static NodeRef getEntryNode(Inverse<DFGraph> G) {
+    return G.Graph.G->getEntryNode();
+  }
+  static ChildIteratorType child_begin(NodeRef N) { return N->Succs.begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->Succs.end(); }
+};
+}
+
+namespace tsar {
+template<> struct DataFlowTraits<ReachDefs *> {
+  using GraphType = DFGraph;
+  using ValueType = BitVector;
+  static ValueType topElement(ReachDefs *RD, GraphType) {
+    return BitVector(RD->NumDefs);
+  }
+  static ValueType boundaryCondition(ReachDefs *RD, GraphType) {
+    return BitVector(RD->NumDefs);
+  }
+  static void setValue(ValueType V, Node *N, ReachDefs *) {
+    N->Out = std::move(V);
+  }
+  static const ValueType &getValue(Node *N, ReachDefs *) { return N->Out; }
+  static void initialize(Node *, ReachDefs *, GraphType) {}
+  static void meetOperator(const ValueType &LHS, ValueType &RHS, ReachDefs *,
+                           GraphType) {
+    RHS |= LHS;
+  }
+  static bool transferFunction(ValueType V, Node *N, ReachDefs *, GraphType) {
+    V.reset(N->Kill);
+    V |= N->Gen;
+    if (V == N->Out)
+      return false;
+    N->Out = std::move(V);
+    return true;
+  }
+};
+}
+
+namespace {
+void runNumbering(BenchmarkSuite &S) {
+  Graph G(S.size(), 1, true);
+  S.run("GraphNumbering/numberGraph", [&G]() {
+    GraphNumbering<Node *> Numbering;
+    numberGraph(&G, &Numbering);
+    doNotOptimize(Numbering.size());
+  });
+}
+
+void runSpanningTreeRelation(BenchmarkSuite &S) {
+  Graph G(S.size(), 1, true);
+  S.run("SpanningTreeRelation/build", [&G]() {
+    SpanningTreeRelation<Graph *> STR(&G);
+    doNotOptimize(STR.isEqual(G.getEntryNode(), G.getEntryNode()));
+  });
+  std::vector<std::pair<Node *, Node *>> Queries;
+  std::mt19937 Gen(S.size());
+  std::uniform_int_distribution<std::size_t> Dist(0, G.size() - 1);
+  for (std::size_t I = 0; I < S.size(); ++I)
+    Queries.emplace_back(*(G.begin() + Dist(Gen)), *(G.begin() + Dist(Gen)));
+  SpanningTreeRelation<Graph *> STR(&G);
+  S.run("SpanningTreeRelation/compare", [&STR, &Queries]() {
+    std::size_t Sum = 0;
+    for (auto &Q : Queries)
+      Sum += STR.compare(Q.first, Q.second);
+    doNotOptimize(Sum);
+  });
+}
+
+void runDataFlow(BenchmarkSuite &S) {
+  const unsigned NumDefs = 128;
+  ReachDefs RD{NumDefs};
+  Graph Cyclic(S.size(), NumDefs, true);
+  S.run("DataFlow/iterative", [&Cyclic]() { Cyclic.clear(); return 0; },
+        [&Cyclic, &RD](int) {
+          solveDataFlowIteratively(&RD, DFGraph{&Cyclic});
+          doNotOptimize(Cyclic.getEntryNode()->Out.count());
+        });
+  Graph Acyclic(S.size(), NumDefs, false);
+  S.run("DataFlow/iterative-acyclic",
+        [&Acyclic]() { Acyclic.clear(); return 0; },
+        [&Acyclic, &RD](int) {
+          solveDataFlowIteratively(&RD, DFGraph{&Acyclic});
+          doNotOptimize(Acyclic.getEntryNode()->Out.count());
+        });
+  S.run("DataFlow/topological-acyclic",
+        [&Acyclic]() { Acyclic.clear(); return 0; },
+        [&Acyclic, &RD](int) {
+          solveDataFlowTopologicaly(&RD, DFGraph{&Acyclic});
+          doNotOptimize(Acyclic.getEntryNode()->Out.count());
+        });
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::size_t Size;
+  unsigned MaxIter;
+  StringRef Filter;
+  if (!parseArguments(Argc, Argv, Size, MaxIter, Filter))
+    return 1;
+  BenchmarkSuite S("graph", Size, MaxIter, Filter);
+  BenchmarkSuite::printHeader();
+  runNumbering(S);
+  runSpanningTreeRelation(S);
+  runDataFlow(S);
+  return 0;
+}
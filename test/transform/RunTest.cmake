@@ -0,0 +1,24 @@
+# Run TSAR on a copy of SOURCE in WORK_DIR and check the transformed file
+# with FileCheck. OPTIONS is a space-separated list of TSAR options.
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+get_filename_component(Name ${SOURCE} NAME_WE)
+get_filename_component(Ext ${SOURCE} EXT)
+configure_file(${SOURCE} ${WORK_DIR}/${Name}${Ext} COPYONLY)
+separate_arguments(Options UNIX_COMMAND "${OPTIONS}")
+
+execute_process(
+  COMMAND ${TSAR} ${Name}${Ext} ${Options} -output-suffix=test
+  WORKING_DIRECTORY ${WORK_DIR}
+  RESULT_VARIABLE Result)
+if(NOT Result EQUAL 0)
+  message(FATAL_ERROR "tsar failed on ${SOURCE}: ${Result}")
+endif()
+execute_process(
+  COMMAND ${FILECHECK} ${SOURCE} --input-file=${Name}.test${Ext}
+  WORKING_DIRECTORY ${WORK_DIR}
+  RESULT_VARIABLE Result)
+if(NOT Result EQUAL 0)
+  message(FATAL_ERROR "unexpected result of transformation of ${SOURCE}")
+endif()
@@ -0,0 +1,52 @@
+//===- dvmh_sm_transfer.c - Data Transfer Optimization (DVMH) -----*- C -*-===//
+//
+// This file checks that optimization of data transfers between host and
+// device does not remove 'actual' directives for variables which may be
+// modified on host through a pointer or which are shadowed in a nested scope.
+//
+//===----------------------------------------------------------------------===//
+
+// CHECK-LABEL: void {{alias}}(void)
+// CHECK: p[I] = p[I - 1] + {{1}};
+// CHECK: #pragma dvm actual({{(.*, )?A(, .*)?}})
+// CHECK: B[I] = A[I] * {{2}};
+
+// CHECK-LABEL: void {{shadow}}(void)
+// CHECK: a[I] = a[I - 1] + {{1}};
+// CHECK: B[I] = a[I] * {{3}};
+// CHECK: #pragma dvm actual({{(.*, )?a(, .*)?}})
+// CHECK: B[I] = a[I] * {{2}};
+
+#define N 100
+
+double A[N];
+double B[N];
+
+// Host writes 'A' through a pointer between two loops executed on device.
+void alias(void) {
+  double *p = A;
+  for (int I = 0; I < N; ++I)
+    A[I] = I;
+  for (int I = 1; I < N; ++I)
+    p[I] = p[I - 1] + 1;
+  for (int I = 0; I < N; ++I)
+    B[I] = A[I] * 2;
+}
+
+// Host writes an outer 'a', the inner 'a' is transferred to device instead.
+void shadow(void) {
+  double a[N];
+  for (int I = 0; I < N; ++I)
+    a[I] = I;
+  for (int I = 1; I < N; ++I)
+    a[I] = a[I - 1] + 1;
+  {
+    double a[N];
+    for (int I = 0; I < N; ++I)
+      a[I] = B[I] + 1;
+    for (int I = 0; I < N; ++I)
+      B[I] = a[I] * 3;
+  }
+  for (int I = 0; I < N; ++I)
+    B[I] = a[I] * 2;
+}
@@ -36,6 +36,7 @@
 #include <llvm/ADT/StringSwitch.h>
 #include <llvm/ADT/Optional.h>
 #include <array>
+#include <cstdint>
 #include <limits>
 #include <vector>
 #include <string>
@@ -156,12 +157,35 @@ JSON_OBJECT_PAIR_6(Location,
   Location(Location &&) = default;
   Location & operator=(Location &&) = default;
 JSON_OBJECT_END(Location)
+
+/// \brief This represents a part of a large response.
+///
+/// If Root is not zero only a subtree with a specified root is sent. If Limit
+/// is not zero only Limit elements starting from Offset are sent. A server sets
+/// Total to the number of elements in the whole (sub)tree, so a client can
+/// request the remaining pages.
+JSON_OBJECT_BEGIN(Page)
+JSON_OBJECT_PAIR_4(Page,
+  Root, std::uintptr_t,
+  Offset, unsigned,
+  Limit, unsigned,
+  Total, unsigned)
+
+  Page() : JSON_INIT(Page, 0, 0, 0, 0) {}
+  ~Page() = default;
+
+  Page(const Page &) = default;
+  Page & operator=(const Page &) = default;
+  Page(Page &&) = default;
+  Page & operator=(Page &&) = default;
+JSON_OBJECT_END(Page)
 }
 }
 
 JSON_DEFAULT_TRAITS(tsar::msg::, Diagnostic)
 JSON_DEFAULT_TRAITS(tsar::msg::, File)
 JSON_DEFAULT_TRAITS(tsar::msg::, Location)
+JSON_DEFAULT_TRAITS(tsar::msg::, Page)
 
 namespace json {
 /// Specialization of JSON serialization traits for tsar::msg::Status type.
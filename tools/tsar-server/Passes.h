@@ -31,13 +31,21 @@ class IntrusiveConnection;
 class RedirectIO;
 }
 
+namespace tsar {
+class ServerSession;
+}
+
 namespace llvm {
 class ModulePass;
 class PassRegistry;
 
 /// Create an interaction pass to obtain results of private variables analysis.
+///
+/// The pass stops interaction when a client requests to repeat analysis in
+/// a specified session.
 ModulePass * createPrivateServerPass(
-  bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr);
+  bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr,
+  tsar::ServerSession &Session);
 
 /// Initialize an interaction pass to obtain results of private variables
 /// analysis.
@@ -25,6 +25,7 @@
 
 #include "ClangMessages.h"
 #include "Passes.h"
+#include "Session.h"
 #include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/AnalysisServer.h"
 #include "tsar/Analysis/Attributes.h"
@@ -175,9 +176,15 @@ JSON_OBJECT_PAIR_7(Loop,
   Loop & operator=(Loop &&) = default;
 JSON_OBJECT_END(Loop)
 
+/// \brief This message provides loops in a function.
+///
+/// Loops are sorted according to their start locations, a subtree of loops
+/// (a specified loop and all nested loops) and a range of loops in a subtree
+/// can be requested with Page field.
 JSON_OBJECT_BEGIN(LoopTree)
-JSON_OBJECT_ROOT_PAIR_2(LoopTree,
+JSON_OBJECT_ROOT_PAIR_3(LoopTree,
   FunctionID, unsigned,
+  Page, msg::Page,
   Loops, std::vector<Loop>)
 
   LoopTree() : JSON_INIT_ROOT {}
@@ -349,10 +356,18 @@ JSON_OBJECT_PAIR_3(AliasEdge,
   AliasEdge & operator=(AliasEdge &&) = default;
 JSON_OBJECT_END(AliasEdge)
 
+/// \brief This message provides alias tree for a loop.
+///
+/// Nodes are sent in breadth-first order, so the top levels of a tree are
+/// available in the first page. A subtree of nodes and a range of nodes in
+/// a subtree can be requested with Page field. Edges from each sent node to
+/// its children are sent with the node, children may be placed in the
+/// subsequent pages.
 JSON_OBJECT_BEGIN(AliasTree)
-JSON_OBJECT_ROOT_PAIR_4(AliasTree,
+JSON_OBJECT_ROOT_PAIR_5(AliasTree,
   FuncID, unsigned,
   LoopID, unsigned,
+  Page, msg::Page,
   Nodes, std::vector<AliasNode>,
   Edges, std::vector<AliasEdge>)
 
@@ -388,6 +403,45 @@ JSON_OBJECT_PAIR_4(Dependence,
   Causes, std::vector<std::string>)
   Dependence() : JSON_INIT(Dependence, true) {}
 JSON_OBJECT_END(Dependence)
+
+/// \brief This message notifies server that some files have been changed.
+///
+/// The current run of analysis is finished and analysis is repeated from
+/// scratch. If AST files are cached (-ast-cache option) only changed sources
+/// are parsed again. Identifiers of functions and loops are not preserved
+/// between runs of analysis, so they should be requested again.
+JSON_OBJECT_BEGIN(Reanalyze)
+JSON_OBJECT_ROOT_PAIR(Reanalyze
+  , Files, std::vector<std::string>
+  )
+
+  Reanalyze() : JSON_INIT_ROOT {}
+  ~Reanalyze() override = default;
+
+  Reanalyze(const Reanalyze &) = default;
+  Reanalyze & operator=(const Reanalyze &) = default;
+  Reanalyze(Reanalyze &&) = default;
+  Reanalyze & operator=(Reanalyze &&) = default;
+JSON_OBJECT_END(Reanalyze)
+
+/// \brief This message provides statistic of a server session.
+///
+/// This contains number of runs of analysis and number of sources which have
+/// been reused or parsed in the last run.
+JSON_OBJECT_BEGIN(Session)
+JSON_OBJECT_ROOT_PAIR_3(Session,
+  Runs, unsigned,
+  ReusedSources, unsigned,
+  ParsedSources, unsigned)
+
+  Session() : JSON_INIT_ROOT, JSON_INIT(Session, 0, 0, 0) {}
+  ~Session() override = default;
+
+  Session(const Session &) = default;
+  Session & operator=(const Session &) = default;
+  Session(Session &&) = default;
+  Session & operator=(Session &&) = default;
+JSON_OBJECT_END(Session)
 }
 }
 
@@ -409,6 +463,8 @@ JSON_DEFAULT_TRAITS(tsar::msg::, AliasTree)
 JSON_DEFAULT_TRAITS(tsar::msg::, Reduction)
 JSON_DEFAULT_TRAITS(tsar::msg::, Induction)
 JSON_DEFAULT_TRAITS(tsar::msg::, Dependence)
+JSON_DEFAULT_TRAITS(tsar::msg::, Reanalyze)
+JSON_DEFAULT_TRAITS(tsar::msg::, Session)
 
 namespace json {
 /// Specialization of JSON serialization traits for tsar::msg::LoopType type.
@@ -880,8 +936,8 @@ public:
 
   /// Constructor.
   explicit PrivateServerPass(bcl::IntrusiveConnection &IC,
-      bcl::RedirectIO &StdErr) :
-    ModulePass(ID), mConnection(&IC), mStdErr(&StdErr) {
+      bcl::RedirectIO &StdErr, ServerSession &Session) :
+    ModulePass(ID), mConnection(&IC), mStdErr(&StdErr), mSession(&Session) {
     initializePrivateServerPassPass(*PassRegistry::getPassRegistry());
   }
 
@@ -899,6 +955,8 @@ private:
   std::string answerCalleeFuncList(llvm::Module &M,
     const msg::CalleeFuncList &Request);
   std::string answerAliasTree(llvm::Module &M, const msg::AliasTree &Request);
+  std::string answerReanalyze(const msg::Reanalyze &Request);
+  std::string answerSession();
 
   /// Recursively collect builtin functions in a specified contexs and
   /// inner contexts.
@@ -907,6 +965,7 @@ private:
 
   bcl::IntrusiveConnection *mConnection;
   bcl::RedirectIO *mStdErr;
+  ServerSession *mSession = nullptr;
 
   TransformationInfo *mTfmInfo = nullptr;
   TransformationContext *mTfmCtx  = nullptr;
@@ -1187,6 +1246,30 @@ std::string PrivateServerPass::answerLoopTree(llvm::Module &M,
       Loop[msg::Loop::Level] = Levels.size() + 1;
       Levels.push_back(Loop[msg::Loop::EndLocation]);
     }
+    // Levels are calculated for all loops in a function, so select loops
+    // which should be sent after that.
+    auto &Page = LoopTree[msg::LoopTree::Page];
+    Page = Request[msg::LoopTree::Page];
+    auto &Loops = LoopTree[msg::LoopTree::Loops];
+    auto First = Loops.begin(), Last = Loops.end();
+    if (Page[msg::Page::Root]) {
+      First = find_if(Loops, [&Page](msg::Loop &L) {
+        return L[msg::Loop::ID] == Page[msg::Page::Root];
+      });
+      if (First != Loops.end())
+        Last = std::find_if(std::next(First), Loops.end(),
+                            [First](msg::Loop &L) {
+                              return L[msg::Loop::Level] <=
+                                     (*First)[msg::Loop::Level];
+                            });
+    }
+    Page[msg::Page::Total] = Last - First;
+    First += std::min(Page[msg::Page::Offset], Page[msg::Page::Total]);
+    if (Page[msg::Page::Limit] &&
+        Page[msg::Page::Limit] < static_cast<unsigned>(Last - First))
+      Last = First + Page[msg::Page::Limit];
+    Loops.erase(Last, Loops.end());
+    Loops.erase(Loops.begin(), First);
     return json::Parser<msg::LoopTree>::unparseAsObject(LoopTree);
   }
   return json::Parser<msg::LoopTree>::unparseAsObject(Request);
@@ -1454,7 +1537,39 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
       msg::AliasTree Response;
       Response[msg::AliasTree::FuncID] = Request[msg::AliasTree::FuncID];
       Response[msg::AliasTree::LoopID] = Request[msg::AliasTree::LoopID];
-      for (auto &TS : DIDepSet) {
+      auto &Page = Response[msg::AliasTree::Page];
+      Page = Request[msg::AliasTree::Page];
+      // Collect nodes of a requested subtree in breadth-first order. Only
+      // nodes in a requested page are converted to messages, so the cost of
+      // a response depends on the page size.
+      auto *Root = DIAT.getTopLevelNode();
+      if (Page[msg::Page::Root]) {
+        auto Itr = find_if(DIAT, [&Page](DIAliasNode &N) {
+          return reinterpret_cast<std::uintptr_t>(&N) == Page[msg::Page::Root];
+        });
+        Root = Itr != DIAT.end() ? &*Itr : nullptr;
+      }
+      std::vector<decltype(DIDepSet.begin())> Selection;
+      std::vector<DIAliasNode *> Worklist;
+      if (Root)
+        Worklist.push_back(Root);
+      for (std::size_t I = 0; I < Worklist.size(); ++I) {
+        auto TSItr = DIDepSet.find_as(Worklist[I]);
+        if (TSItr != DIDepSet.end())
+          Selection.push_back(TSItr);
+        for (auto &C : make_range(Worklist[I]->child_begin(),
+                                  Worklist[I]->child_end()))
+          Worklist.push_back(&C);
+      }
+      Page[msg::Page::Total] = Selection.size();
+      auto First = Selection.begin() +
+        std::min(Page[msg::Page::Offset], Page[msg::Page::Total]);
+      auto Last = Selection.end();
+      if (Page[msg::Page::Limit] &&
+          Page[msg::Page::Limit] < static_cast<unsigned>(Last - First))
+        Last = First + Page[msg::Page::Limit];
+      for (auto TSItr : make_range(First, Last)) {
+        auto &TS = *TSItr;
         Response[msg::AliasTree::Nodes].emplace_back();
         auto &N = Response[msg::AliasTree::Nodes].back();
         N[msg::AliasNode::ID] = reinterpret_cast<std::uintptr_t>(TS.getNode());
@@ -1561,6 +1676,21 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
   return json::Parser<msg::AliasTree>::unparseAsObject(Request);
 }
 
+std::string PrivateServerPass::answerReanalyze(const msg::Reanalyze &Request) {
+  mSession->requestReanalysis(Request[msg::Reanalyze::Files]);
+  return json::Parser<msg::Reanalyze>::unparseAsObject(Request);
+}
+
+std::string PrivateServerPass::answerSession() {
+  msg::Session Session;
+  Session[msg::Session::Runs] = mSession->getNumRuns();
+  if (auto *Cache = mSession->getASTCache()) {
+    Session[msg::Session::ReusedSources] = Cache->getNumReused();
+    Session[msg::Session::ParsedSources] = Cache->getNumRebuilt();
+  }
+  return json::Parser<msg::Session>::unparseAsObject(Session);
+}
+
 bool PrivateServerPass::runOnModule(llvm::Module &M) {
   if (!mConnection) {
     M.getContext().emitError("intrusive connection is not established");
@@ -1610,7 +1740,9 @@ bool PrivateServerPass::runOnModule(llvm::Module &M) {
       [&DIMEnvWrapper](DIMemoryEnvironmentWrapper &Wrapper) {
     Wrapper.set(*DIMEnvWrapper);
   });
-  while (mConnection->answer(
+  // Stop interaction if a client has been notified that analysis should be
+  // repeated, the next run will answer the subsequent requests.
+  while (!mSession->isReanalysisRequested() && mConnection->answer(
       [this, &M](const std::string &Request) -> std::string {
     msg::Diagnostic Diag(msg::Status::Error);
     if (mStdErr->isDiff()) {
@@ -1618,7 +1750,8 @@ bool PrivateServerPass::runOnModule(llvm::Module &M) {
       return json::Parser<msg::Diagnostic>::unparseAsObject(Diag);
     }
     json::Parser<msg::Statistic, msg::FileList, msg::LoopTree,
-      msg::FunctionList, msg::CalleeFuncList, msg::AliasTree> P(Request);
+      msg::FunctionList, msg::CalleeFuncList, msg::AliasTree,
+      msg::Reanalyze, msg::Session> P(Request);
     auto Obj = P.parse();
     assert(Obj && "Invalid request!");
     if (Obj->is<msg::Statistic>())
@@ -1633,6 +1766,10 @@ bool PrivateServerPass::runOnModule(llvm::Module &M) {
       return answerCalleeFuncList(M, Obj->as<msg::CalleeFuncList>());
     if (Obj->is<msg::AliasTree>())
       return answerAliasTree(M, Obj->as<msg::AliasTree>());
+    if (Obj->is<msg::Reanalyze>())
+      return answerReanalyze(Obj->as<msg::Reanalyze>());
+    if (Obj->is<msg::Session>())
+      return answerSession();
     llvm_unreachable("Unknown request to server!");
   }));
   return false;
@@ -1650,6 +1787,7 @@ void PrivateServerPass::getAnalysisUsage(AnalysisUsage &AU) const {
 }
 
 ModulePass * llvm::createPrivateServerPass(
-    bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr) {
-  return new PrivateServerPass(IC, StdErr);
+    bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr,
+    ServerSession &Session) {
+  return new PrivateServerPass(IC, StdErr, Session);
 }
@@ -29,10 +29,16 @@
 // The first request from client should be msg::CommandLine which specifies
 // analysis options and targets for input/output redirection.
 //
+// Analysis is repeated in the same session if a client notifies server that
+// some files have been changed. If -ast-cache option is specified, only
+// changed sources are parsed again, the analysis is always repeated from
+// scratch.
+//
 //===----------------------------------------------------------------------===//
 
 #include "Messages.h"
 #include "Passes.h"
+#include "Session.h"
 #include "tsar/Analysis/Clang/Passes.h"
 #include "tsar/Analysis/Passes.h"
 #include "tsar/Analysis/Memory/Passes.h"
@@ -111,9 +117,10 @@ namespace {
 class ServerQueryManager : public QueryManager {
 public:
   explicit ServerQueryManager(const GlobalOptions &GO, IntrusiveConnection &C,
-      RedirectIO &StdIn, RedirectIO &StdOut, RedirectIO &StdErr)
+      RedirectIO &StdIn, RedirectIO &StdOut, RedirectIO &StdErr,
+      ServerSession &Session)
     : mGlobalOptions(GO), mConnection(C), mStdIn(StdIn), mStdOut(StdOut),
-      mStdErr(StdErr) {}
+      mStdErr(StdErr), mSession(Session) {}
 
   void run(llvm::Module *M, TransformationInfo *TfmInfo) override {
     assert(M && "Module must not be null!");
@@ -141,7 +148,7 @@ public:
     // mapping. So, metadata-level memory mapping is a shared resource and
     // synchronization is necessary.
     Passes.add(createAnalysisWaitServerPass());
-    Passes.add(createPrivateServerPass(mConnection, mStdErr));
+    Passes.add(createPrivateServerPass(mConnection, mStdErr, mSession));
     Passes.add(createAnalysisReleaseServerPass());
     Passes.add(createAnalysisCloseConnectionPass());
     Passes.add(createVerifierPass());
@@ -156,6 +163,7 @@ private:
   RedirectIO &mStdIn;
   RedirectIO &mStdOut;
   RedirectIO &mStdErr;
+  ServerSession &mSession;
   ASTImportInfo mImportInfo;
 };
 
@@ -221,9 +229,13 @@ void run(IntrusiveConnection C) {
   if (IsQuerySet) {
     Analyzer->run();
   } else {
-    ServerQueryManager QM(Analyzer->getGlobalOptions(),
-      C, StdIn, StdOut, StdErr);
-    Analyzer->run(&QM);
+    ServerSession Session(Analyzer->getASTCache());
+    do {
+      Session.startRun();
+      ServerQueryManager QM(Analyzer->getGlobalOptions(),
+        C, StdIn, StdOut, StdErr, Session);
+      Analyzer->run(&QM);
+    } while (Session.isReanalysisRequested());
   }
   C.answer([&StdErr](const std::string &) {
     msg::Diagnostic Diag(StdErr.isDiff() ? msg::Status::Error
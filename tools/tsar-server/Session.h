@@ -0,0 +1,76 @@
+//===------- Session.h ------ Server Session --------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a state of a server which is kept between consecutive
+// runs of analysis. A client may notify server that some files have been
+// changed, so analysis is repeated without restart of the server.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_SERVER_SESSION_H
+#define TSAR_SERVER_SESSION_H
+
+#include "tsar/Core/ASTCache.h"
+#include <bcl/utility.h>
+#include <string>
+#include <vector>
+
+namespace tsar {
+/// State of a server which is kept between consecutive runs of analysis.
+class ServerSession : private bcl::Uncopyable {
+public:
+  /// Create a session, if a cache of AST files is not set all sources are
+  /// parsed again on each run of analysis.
+  explicit ServerSession(ASTCache *Cache = nullptr) : mASTCache(Cache) {}
+
+  /// Return cache of AST files or nullptr if caching of AST is disabled.
+  ASTCache *getASTCache() noexcept { return mASTCache; }
+  const ASTCache *getASTCache() const noexcept { return mASTCache; }
+
+  /// Request the next run of analysis because specified files have been
+  /// changed.
+  void requestReanalysis(const std::vector<std::string> &Files) {
+    if (mASTCache)
+      for (auto &F : Files)
+        mASTCache->invalidate(F);
+    mIsReanalysisRequested = true;
+  }
+
+  /// Return true if analysis should be repeated after the current run.
+  bool isReanalysisRequested() const noexcept {
+    return mIsReanalysisRequested;
+  }
+
+  /// Prepare the session to the next run of analysis.
+  void startRun() noexcept {
+    mIsReanalysisRequested = false;
+    ++mNumRuns;
+  }
+
+  /// Return number of runs of analysis in this session.
+  unsigned getNumRuns() const noexcept { return mNumRuns; }
+
+private:
+  ASTCache *mASTCache;
+  bool mIsReanalysisRequested = false;
+  unsigned mNumRuns = 0;
+};
+}
+#endif//TSAR_SERVER_SESSION_H